@@ -0,0 +1,42 @@
+/**
+  ******************************************************************************
+  * @file           : event_queue.h
+  * @brief          : Header for event_queue.c file.
+  *                   Interrupt to thread mode events.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __EVENT_QUEUE_H
+#define __EVENT_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported types ------------------------------------------------------------*/
+/* Events, dispatched in this order when several are pending (32 at most) */
+typedef enum
+{
+  EVENT_AUDIO_ALT = 0,      /* streaming alternate setting changed */
+  EVENT_AUDIO_VENDOR,       /* vendor OUT request waiting to be applied */
+  EVENT_CDC_DIAG,           /* diagnostics report due on the virtual COM port */
+  EVENT_NUM
+} EVENT_IdTypeDef;
+
+typedef void (*EVENT_HandlerTypeDef)(void *ctx);
+
+/* Exported functions prototypes ---------------------------------------------*/
+void EVENT_Register(EVENT_IdTypeDef id, EVENT_HandlerTypeDef handler, void *ctx);
+void EVENT_Post(EVENT_IdTypeDef id);
+void EVENT_Dispatch(void);
+void EVENT_Idle(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __EVENT_QUEUE_H */
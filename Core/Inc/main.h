@@ -41,6 +41,15 @@ extern "C" {
 
 /* Exported constants --------------------------------------------------------*/
 /* USER CODE BEGIN EC */
+/* Interrupt priority map (NVIC_PRIORITYGROUP_4, preemption only, lower wins):
+ *    0  DMA1_Stream4 (I2S2 TX)  refills the next playback block, hard deadline
+ *    1  OTG_FS                  endpoint/FIFO servicing and the SOF feedback packet
+ *   15  SysTick                 HAL time base (TICK_INT_PRIORITY)
+ *   15  PendSV                  deferred work: packet conversion, feedback math
+ */
+#define IRQ_PRIO_I2S_DMA                0U
+#define IRQ_PRIO_USB                    1U
+#define IRQ_PRIO_WORK                   15U
 
 /* USER CODE END EC */
 
@@ -53,7 +62,8 @@ extern "C" {
 void Error_Handler(void);
 
 /* USER CODE BEGIN EFP */
-
+/* Not called from main(), the audio interface brings the I2S up when streaming starts */
+void MX_I2S2_Init(void);
 /* USER CODE END EFP */
 
 /* Private defines -----------------------------------------------------------*/
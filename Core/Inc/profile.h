@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file           : profile.h
+  * @brief          : Header for profile.c file.
+  *                   Interrupt handler cycle profiling with the DWT counter.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __PROFILE_H
+#define __PROFILE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported constants --------------------------------------------------------*/
+/* Build with -DUSE_ISR_PROFILE=1 to enable; otherwise the macros below are empty */
+#ifndef USE_ISR_PROFILE
+#define USE_ISR_PROFILE                 0U
+#endif
+
+/* Histogram bucket n counts calls of 2^n .. 2^(n+1)-1 cycles, the last one everything longer */
+#define PROFILE_HIST_BUCKETS            20U
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  PROFILE_OTG_FS = 0,       /* OTG_FS_IRQHandler */
+  PROFILE_DATAOUT,          /* USBD_AUDIO_DataOut */
+  PROFILE_SOF,              /* USBD_AUDIO_SOF */
+  PROFILE_DMA_I2S,          /* DMA1_Stream4_IRQHandler */
+  PROFILE_PENDSV,           /* PendSV_Handler, deferred work */
+  PROFILE_NUM
+} PROFILE_IdTypeDef;
+
+/* Layout returned by the GET_PROFILE vendor request, little endian */
+typedef struct
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint32_t avg;
+  uint32_t hist[PROFILE_HIST_BUCKETS];
+} PROFILE_ReportTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+#if (USE_ISR_PROFILE == 1U)
+/* Times include any higher priority interrupt that preempted the handler */
+#define PROFILE_BEGIN(id)               uint32_t profile_t0_##id = DWT->CYCCNT
+#define PROFILE_END(id)                 PROFILE_Record((id), DWT->CYCCNT - profile_t0_##id)
+#else
+#define PROFILE_BEGIN(id)
+#define PROFILE_END(id)
+#endif /* USE_ISR_PROFILE */
+
+/* Exported functions prototypes ---------------------------------------------*/
+void PROFILE_CycleCounter_Init(void);
+
+#if (USE_ISR_PROFILE == 1U)
+void PROFILE_Init(void);
+void PROFILE_Record(PROFILE_IdTypeDef id, uint32_t cycles);
+void PROFILE_Read(PROFILE_IdTypeDef id, PROFILE_ReportTypeDef *report);
+void PROFILE_Reset(void);
+#endif /* USE_ISR_PROFILE */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __PROFILE_H */
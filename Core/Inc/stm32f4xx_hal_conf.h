@@ -154,6 +154,18 @@
 #define  INSTRUCTION_CACHE_ENABLE     1U
 #define  DATA_CACHE_ENABLE            1U
 
+/* The OTG FS interrupt path and the audio copy kernels run from SRAM (.RamFunc, copied with
+   .data at startup) so their timing does not depend on flash wait states and ART hits.
+   Build with -DUSE_RAM_ISR=0 to keep them in flash */
+#ifndef USE_RAM_ISR
+#define  USE_RAM_ISR                  1U
+#endif
+#if (USE_RAM_ISR == 1U)
+#define  RAM_ISR                      __RAM_FUNC
+#else
+#define  RAM_ISR
+#endif
+
 #define  USE_HAL_ADC_REGISTER_CALLBACKS         0U /* ADC register callback disabled       */
 #define  USE_HAL_CAN_REGISTER_CALLBACKS         0U /* CAN register callback disabled       */
 #define  USE_HAL_CEC_REGISTER_CALLBACKS         0U /* CEC register callback disabled       */
@@ -0,0 +1,37 @@
+/**
+  ******************************************************************************
+  * @file           : work_queue.h
+  * @brief          : Header for work_queue.c file.
+  *                   Deferred interrupt work, run from PendSV.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __WORK_QUEUE_H
+#define __WORK_QUEUE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef void (*WORK_FuncTypeDef)(void *arg);
+
+/* Exported constants --------------------------------------------------------*/
+/* Number of queued work items, must be a power of two */
+#define WORK_QUEUE_SIZE                 8U
+
+/* Exported functions prototypes ---------------------------------------------*/
+void WORK_Init(void);
+HAL_StatusTypeDef WORK_Post(WORK_FuncTypeDef func, void *arg);
+void WORK_Run(void);
+uint32_t WORK_GetDropped(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __WORK_QUEUE_H */
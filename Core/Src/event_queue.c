@@ -0,0 +1,93 @@
+/**
+  ******************************************************************************
+  * @file           : event_queue.c
+  * @brief          : Interrupt to thread mode events.
+  *
+  *                   Control plane work (alternate setting changes, DSP
+  *                   settings, ...) is posted by the interrupt handlers and
+  *                   run from the main loop. Pending events are bits of one
+  *                   word set with LDREX/STREX, so posting never masks
+  *                   interrupts and an event posted several times before the
+  *                   main loop gets to it runs once.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "event_queue.h"
+
+/* Private variables ---------------------------------------------------------*/
+static volatile uint32_t EVENT_Pending;
+static EVENT_HandlerTypeDef EVENT_Handler[EVENT_NUM];
+static void *EVENT_Ctx[EVENT_NUM];
+
+/**
+  * @brief  Sets the handler of an event. Call before the event can be posted.
+  * @param  id: event
+  * @param  handler: called from thread mode with ctx
+  * @param  ctx: handler argument
+  * @retval None
+  */
+void EVENT_Register(EVENT_IdTypeDef id, EVENT_HandlerTypeDef handler, void *ctx)
+{
+  EVENT_Ctx[id] = ctx;
+  EVENT_Handler[id] = handler;
+}
+
+/**
+  * @brief  Marks an event pending. Callable from any priority.
+  * @param  id: event
+  * @retval None
+  */
+RAM_ISR void EVENT_Post(EVENT_IdTypeDef id)
+{
+  uint32_t pending;
+
+  do
+  {
+    pending = __LDREXW(&EVENT_Pending);
+  } while (__STREXW(pending | (1UL << id), &EVENT_Pending) != 0U);
+}
+
+/**
+  * @brief  Runs the handlers of all pending events. Thread mode only.
+  * @retval None
+  */
+void EVENT_Dispatch(void)
+{
+  uint32_t pending;
+
+  do
+  {
+    pending = __LDREXW(&EVENT_Pending);
+  } while (__STREXW(0U, &EVENT_Pending) != 0U);
+
+  while (pending != 0U)
+  {
+    uint32_t id = __CLZ(__RBIT(pending));
+
+    pending &= pending - 1U;
+
+    if (EVENT_Handler[id] != NULL)
+    {
+      EVENT_Handler[id](EVENT_Ctx[id]);
+    }
+  }
+}
+
+/**
+  * @brief  Sleeps until the next interrupt unless an event is already pending.
+  *         Interrupts are masked around the check so an event posted between
+  *         the check and WFI still wakes the core.
+  * @retval None
+  */
+void EVENT_Idle(void)
+{
+  __disable_irq();
+
+  if (EVENT_Pending == 0U)
+  {
+    __WFI();
+  }
+
+  __enable_irq();
+}
@@ -22,7 +22,10 @@
 
 /* Private includes ----------------------------------------------------------*/
 /* USER CODE BEGIN Includes */
-
+#include "work_queue.h"
+#include "event_queue.h"
+#include "profile.h"
+#include "usbd_audio_bench.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -32,7 +35,11 @@
 
 /* Private define ------------------------------------------------------------*/
 /* USER CODE BEGIN PD */
-
+/* What SystemClock_Config sets up: 25MHz HSE / 25 * 336 / 4. 84MHz is the top of the F401
+   range and is reached in voltage scale 2, the F401 has no scale 1. At 2.7-3.6V it needs
+   two flash wait states */
+#define SYSCLK_FREQ                     84000000U
+#define SYSCLK_FLASH_LATENCY            FLASH_LATENCY_2
 /* USER CODE END PD */
 
 /* Private macro -------------------------------------------------------------*/
@@ -52,9 +59,9 @@ DMA_HandleTypeDef hdma_spi2_tx;
 void SystemClock_Config(void);
 static void MX_GPIO_Init(void);
 static void MX_DMA_Init(void);
-static void MX_I2S2_Init(void);
+void MX_I2S2_Init(void);
 /* USER CODE BEGIN PFP */
-
+static void ART_Config(void);
 /* USER CODE END PFP */
 
 /* Private user code ---------------------------------------------------------*/
@@ -78,23 +85,34 @@ int main(void)
   HAL_Init();
 
   /* USER CODE BEGIN Init */
-
+  WORK_Init();
+#if (USE_ISR_PROFILE == 1U)
+  PROFILE_Init();
+#endif
   /* USER CODE END Init */
 
   /* Configure the system clock */
   SystemClock_Config();
 
   /* USER CODE BEGIN SysInit */
-
+  ART_Config();
+#if (USE_AUDIO_BENCH == 1U)
+  /* At full clock and before the USB device is started */
+  AUDIO_BENCH_Run();
+#endif
   /* USER CODE END SysInit */
 
   /* Initialize all configured peripherals */
   MX_GPIO_Init();
   MX_DMA_Init();
   MX_USB_DEVICE_Init();
-  MX_I2S2_Init();
   /* USER CODE BEGIN 2 */
-
+  /* The device is attached now. MX_I2S2_Init, with the PLLI2S lock, is left to the first
+     SET_INTERFACE to a streaming alternate setting (AUDIO_Init_FS) */
+#ifdef DEBUG
+  /* Keep the debugger attached while the core sleeps in WFI */
+  HAL_DBGMCU_EnableDBGSleepMode();
+#endif
   /* USER CODE END 2 */
 
   /* Infinite loop */
@@ -104,6 +122,9 @@ int main(void)
     /* USER CODE END WHILE */
 
     /* USER CODE BEGIN 3 */
+    /* Control plane work posted by the interrupt handlers, then sleep */
+    EVENT_Dispatch();
+    EVENT_Idle();
   }
   /* USER CODE END 3 */
 }
@@ -158,7 +179,7 @@ void SystemClock_Config(void)
   * @param None
   * @retval None
   */
-static void MX_I2S2_Init(void)
+void MX_I2S2_Init(void)
 {
 
   /* USER CODE BEGIN I2S2_Init 0 */
@@ -223,7 +244,47 @@ static void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 4 */
-
+/**
+  * @brief  Sets the flash prefetch and the ART instruction and data caches as
+  *         stm32f4xx_hal_conf.h asks, rather than relying on HAL_Init, then
+  *         checks the flash interface, the regulator and SYSCLK against what
+  *         SystemClock_Config is meant to produce.
+  * @retval None
+  */
+static void ART_Config(void)
+{
+  uint32_t acr = 0U;
+
+  /* The caches can only be reset while disabled, so no line fetched before the
+     wait states were raised survives */
+  __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+  __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+  __HAL_FLASH_DATA_CACHE_DISABLE();
+  __HAL_FLASH_DATA_CACHE_RESET();
+
+#if (INSTRUCTION_CACHE_ENABLE != 0U)
+  __HAL_FLASH_INSTRUCTION_CACHE_ENABLE();
+  acr |= FLASH_ACR_ICEN;
+#endif
+#if (DATA_CACHE_ENABLE != 0U)
+  __HAL_FLASH_DATA_CACHE_ENABLE();
+  acr |= FLASH_ACR_DCEN;
+#endif
+#if (PREFETCH_ENABLE != 0U)
+  __HAL_FLASH_PREFETCH_BUFFER_ENABLE();
+  acr |= FLASH_ACR_PRFTEN;
+#else
+  __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+#endif
+
+  if (((FLASH->ACR & (FLASH_ACR_ICEN | FLASH_ACR_DCEN | FLASH_ACR_PRFTEN)) != acr) ||
+      (__HAL_FLASH_GET_LATENCY() != SYSCLK_FLASH_LATENCY) ||
+      (__HAL_PWR_GET_FLAG(PWR_FLAG_VOSRDY) == 0U) ||
+      (HAL_RCC_GetSysClockFreq() != SYSCLK_FREQ))
+  {
+    Error_Handler();
+  }
+}
 /* USER CODE END 4 */
 
 /**
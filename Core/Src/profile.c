@@ -0,0 +1,142 @@
+/**
+  ******************************************************************************
+  * @file           : profile.c
+  * @brief          : Interrupt handler cycle profiling.
+  *
+  *                   Each profiled handler is timed with DWT->CYCCNT between
+  *                   PROFILE_BEGIN and PROFILE_END, and the time is added to
+  *                   a min/max/sum and a log2 histogram. Built only with
+  *                   USE_ISR_PROFILE=1.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "profile.h"
+
+/**
+  * @brief  Starts the DWT cycle counter, without resetting it. Also used by
+  *         the DSP pipeline and the data path benchmark.
+  * @retval None
+  */
+void PROFILE_CycleCounter_Init(void)
+{
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+#if (USE_ISR_PROFILE == 1U)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint32_t hist[PROFILE_HIST_BUCKETS];
+} PROFILE_StatTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static PROFILE_StatTypeDef PROFILE_Stat[PROFILE_NUM];
+
+/**
+  * @brief  Starts the DWT cycle counter and clears the statistics.
+  * @retval None
+  */
+void PROFILE_Init(void)
+{
+  PROFILE_CycleCounter_Init();
+  DWT->CYCCNT = 0U;
+
+  PROFILE_Reset();
+}
+
+/**
+  * @brief  Adds one call to the statistics of a handler.
+  * @param  id: handler
+  * @param  cycles: time taken
+  * @retval None
+  */
+RAM_ISR void PROFILE_Record(PROFILE_IdTypeDef id, uint32_t cycles)
+{
+  PROFILE_StatTypeDef *stat = &PROFILE_Stat[id];
+  uint32_t bucket = (cycles != 0U) ? (31U - __CLZ(cycles)) : 0U;
+  uint32_t primask = __get_PRIMASK();
+
+  if (bucket >= PROFILE_HIST_BUCKETS)
+  {
+    bucket = PROFILE_HIST_BUCKETS - 1U;
+  }
+
+  /* A handler may be preempted by another profiled one */
+  __disable_irq();
+
+  stat->count++;
+  stat->sum += cycles;
+  stat->hist[bucket]++;
+
+  if (cycles < stat->min)
+  {
+    stat->min = cycles;
+  }
+  if (cycles > stat->max)
+  {
+    stat->max = cycles;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Takes a consistent copy of the statistics of a handler.
+  * @param  id: handler
+  * @param  report: copy
+  * @retval None
+  */
+void PROFILE_Read(PROFILE_IdTypeDef id, PROFILE_ReportTypeDef *report)
+{
+  PROFILE_StatTypeDef *stat = &PROFILE_Stat[id];
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  report->count = stat->count;
+  report->min = (stat->count != 0U) ? stat->min : 0U;
+  report->max = stat->max;
+  report->avg = (stat->count != 0U) ? (uint32_t)(stat->sum / stat->count) : 0U;
+
+  for (uint32_t i = 0U; i < PROFILE_HIST_BUCKETS; i++)
+  {
+    report->hist[i] = stat->hist[i];
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  Clears the statistics of every handler.
+  * @retval None
+  */
+void PROFILE_Reset(void)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  for (uint32_t id = 0U; id < PROFILE_NUM; id++)
+  {
+    PROFILE_Stat[id].count = 0U;
+    PROFILE_Stat[id].min = 0xFFFFFFFFU;
+    PROFILE_Stat[id].max = 0U;
+    PROFILE_Stat[id].sum = 0U;
+
+    for (uint32_t i = 0U; i < PROFILE_HIST_BUCKETS; i++)
+    {
+      PROFILE_Stat[id].hist[i] = 0U;
+    }
+  }
+
+  __set_PRIMASK(primask);
+}
+
+#endif /* USE_ISR_PROFILE */
@@ -174,7 +174,8 @@ void HAL_I2S_MspDeInit(I2S_HandleTypeDef* hi2s)
     /* I2S2 DMA DeInit */
     HAL_DMA_DeInit(hi2s->hdmatx);
   /* USER CODE BEGIN SPI2_MspDeInit 1 */
-
+    /* Only the I2S runs from the PLLI2S, HAL_I2S_MspInit turns it back on */
+    __HAL_RCC_PLLI2S_DISABLE();
   /* USER CODE END SPI2_MspDeInit 1 */
   }
 
@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * @file           : work_queue.c
+  * @brief          : Deferred interrupt work.
+  *
+  *                   Interrupt handlers only do what cannot wait (endpoint and
+  *                   FIFO servicing, DMA block refill) and post the rest here.
+  *                   Posting pends PendSV, which runs at the lowest priority
+  *                   (IRQ_PRIO_WORK), so the queued work runs as soon as no
+  *                   other interrupt is active and can itself be preempted by
+  *                   the USB and DMA interrupts.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "work_queue.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  WORK_FuncTypeDef func;
+  void *arg;
+} WORK_ItemTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static WORK_ItemTypeDef WORK_Queue[WORK_QUEUE_SIZE];
+/* head is only moved by WORK_Post (inside a critical section), tail only by WORK_Run */
+static volatile uint32_t WORK_Head;
+static volatile uint32_t WORK_Tail;
+static volatile uint32_t WORK_Dropped;
+
+/**
+  * @brief  Sets the PendSV priority and empties the queue.
+  * @retval None
+  */
+void WORK_Init(void)
+{
+  WORK_Head = 0U;
+  WORK_Tail = 0U;
+  WORK_Dropped = 0U;
+
+  HAL_NVIC_SetPriority(PendSV_IRQn, IRQ_PRIO_WORK, 0);
+}
+
+/**
+  * @brief  Queues func(arg) to run from PendSV. Callable from any priority.
+  * @param  func: work function
+  * @param  arg: argument passed to func
+  * @retval HAL_OK, or HAL_BUSY if the queue is full and the work was dropped
+  */
+RAM_ISR HAL_StatusTypeDef WORK_Post(WORK_FuncTypeDef func, void *arg)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+
+  if ((WORK_Head - WORK_Tail) >= WORK_QUEUE_SIZE)
+  {
+    WORK_Dropped++;
+    __set_PRIMASK(primask);
+    return HAL_BUSY;
+  }
+
+  WORK_Queue[WORK_Head & (WORK_QUEUE_SIZE - 1U)].func = func;
+  WORK_Queue[WORK_Head & (WORK_QUEUE_SIZE - 1U)].arg = arg;
+  WORK_Head++;
+
+  __set_PRIMASK(primask);
+
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;
+
+  return HAL_OK;
+}
+
+/**
+  * @brief  Runs the queued work in posting order. Called from PendSV_Handler.
+  * @retval None
+  */
+void WORK_Run(void)
+{
+  while (WORK_Tail != WORK_Head)
+  {
+    WORK_ItemTypeDef item = WORK_Queue[WORK_Tail & (WORK_QUEUE_SIZE - 1U)];
+
+    WORK_Tail++;
+    item.func(item.arg);
+  }
+}
+
+/**
+  * @brief  Number of work items dropped because the queue was full.
+  * @retval count since WORK_Init
+  */
+uint32_t WORK_GetDropped(void)
+{
+  return WORK_Dropped;
+}
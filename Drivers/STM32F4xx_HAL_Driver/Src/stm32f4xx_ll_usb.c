@@ -450,7 +450,7 @@ HAL_StatusTypeDef USB_DevInit(USB_OTG_GlobalTypeDef *USBx, USB_OTG_CfgTypeDef cf
             15 means Flush all Tx FIFOs
   * @retval HAL status
   */
-HAL_StatusTypeDef USB_FlushTxFifo(USB_OTG_GlobalTypeDef *USBx, uint32_t num)
+RAM_ISR HAL_StatusTypeDef USB_FlushTxFifo(USB_OTG_GlobalTypeDef *USBx, uint32_t num)
 {
   uint32_t count = 0U;
 
@@ -472,7 +472,7 @@ HAL_StatusTypeDef USB_FlushTxFifo(USB_OTG_GlobalTypeDef *USBx, uint32_t num)
   * @param  USBx  Selected device
   * @retval HAL status
   */
-HAL_StatusTypeDef USB_FlushRxFifo(USB_OTG_GlobalTypeDef *USBx)
+RAM_ISR HAL_StatusTypeDef USB_FlushRxFifo(USB_OTG_GlobalTypeDef *USBx)
 {
   uint32_t count = 0;
 
@@ -711,7 +711,7 @@ HAL_StatusTypeDef USB_DeactivateDedicatedEndpoint(USB_OTG_GlobalTypeDef *USBx, U
   *           1 : DMA feature used
   * @retval HAL status
   */
-HAL_StatusTypeDef USB_EPStartXfer(USB_OTG_GlobalTypeDef *USBx, USB_OTG_EPTypeDef *ep, uint8_t dma)
+RAM_ISR HAL_StatusTypeDef USB_EPStartXfer(USB_OTG_GlobalTypeDef *USBx, USB_OTG_EPTypeDef *ep, uint8_t dma)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
   uint32_t epnum = (uint32_t)ep->num;
@@ -953,7 +953,7 @@ HAL_StatusTypeDef USB_EP0StartXfer(USB_OTG_GlobalTypeDef *USBx, USB_OTG_EPTypeDe
   *           1 : DMA feature used
   * @retval HAL status
   */
-HAL_StatusTypeDef USB_WritePacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *src,
+RAM_ISR HAL_StatusTypeDef USB_WritePacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *src,
                                   uint8_t ch_ep_num, uint16_t len, uint8_t dma)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
@@ -963,6 +963,39 @@ HAL_StatusTypeDef USB_WritePacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *src,
   if (dma == 0U)
   {
     count32b = ((uint32_t)len + 3U) / 4U;
+
+    if (((uint32_t)src & 3U) == 0U)
+    {
+      /* Word aligned source: plain word loads, four pushes per iteration. Any
+         address of the 4 KB FIFO window pushes to the FIFO. pFifo is volatile,
+         so every push stays a single word store; only the loop overhead is cut */
+      __IO uint32_t *pFifo = &USBx_DFIFO((uint32_t)ch_ep_num);
+
+      while (count32b >= 4U)
+      {
+        uint32_t w0 = pSrc[0];
+        uint32_t w1 = pSrc[1];
+        uint32_t w2 = pSrc[2];
+        uint32_t w3 = pSrc[3];
+
+        pFifo[0] = w0;
+        pFifo[1] = w1;
+        pFifo[2] = w2;
+        pFifo[3] = w3;
+        pSrc += 4U;
+        count32b -= 4U;
+      }
+
+      while (count32b > 0U)
+      {
+        pFifo[0] = *pSrc;
+        pSrc++;
+        count32b--;
+      }
+
+      return HAL_OK;
+    }
+
     for (i = 0U; i < count32b; i++)
     {
       USBx_DFIFO((uint32_t)ch_ep_num) = __UNALIGNED_UINT32_READ(pSrc);
@@ -980,13 +1013,46 @@ HAL_StatusTypeDef USB_WritePacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *src,
   * @param  len  Number of bytes to read
   * @retval pointer to destination buffer
   */
-void *USB_ReadPacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *dest, uint16_t len)
+RAM_ISR void *USB_ReadPacket(USB_OTG_GlobalTypeDef *USBx, uint8_t *dest, uint16_t len)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
   uint32_t *pDest = (uint32_t *)dest;
   uint32_t i;
   uint32_t count32b = ((uint32_t)len + 3U) / 4U;
 
+  if ((((uint32_t)dest & 3U) == 0U) && (((uint32_t)len & 3U) == 0U))
+  {
+    /* Word aligned destination and whole words (isochronous audio packets):
+       four pops per iteration. Any address of the 4 KB FIFO window pops the
+       FIFO. pFifo is volatile, so every pop stays a single word load; only
+       the loop overhead is cut */
+    __IO uint32_t *pFifo = &USBx_DFIFO(0U);
+
+    while (count32b >= 4U)
+    {
+      uint32_t w0 = pFifo[0];
+      uint32_t w1 = pFifo[1];
+      uint32_t w2 = pFifo[2];
+      uint32_t w3 = pFifo[3];
+
+      pDest[0] = w0;
+      pDest[1] = w1;
+      pDest[2] = w2;
+      pDest[3] = w3;
+      pDest += 4U;
+      count32b -= 4U;
+    }
+
+    while (count32b > 0U)
+    {
+      *pDest = pFifo[0];
+      pDest++;
+      count32b--;
+    }
+
+    return ((void *)pDest);
+  }
+
   for (i = 0U; i < count32b; i++)
   {
     __UNALIGNED_UINT32_WRITE(pDest, USBx_DFIFO(0U));
@@ -1152,7 +1218,7 @@ HAL_StatusTypeDef  USB_DevDisconnect(USB_OTG_GlobalTypeDef *USBx)
   * @param  USBx  Selected device
   * @retval HAL status
   */
-uint32_t  USB_ReadInterrupts(USB_OTG_GlobalTypeDef *USBx)
+RAM_ISR uint32_t  USB_ReadInterrupts(USB_OTG_GlobalTypeDef *USBx)
 {
   uint32_t tmpreg;
 
@@ -1167,7 +1233,7 @@ uint32_t  USB_ReadInterrupts(USB_OTG_GlobalTypeDef *USBx)
   * @param  USBx  Selected device
   * @retval HAL status
   */
-uint32_t USB_ReadDevAllOutEpInterrupt(USB_OTG_GlobalTypeDef *USBx)
+RAM_ISR uint32_t USB_ReadDevAllOutEpInterrupt(USB_OTG_GlobalTypeDef *USBx)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
   uint32_t tmpreg;
@@ -1183,7 +1249,7 @@ uint32_t USB_ReadDevAllOutEpInterrupt(USB_OTG_GlobalTypeDef *USBx)
   * @param  USBx  Selected device
   * @retval HAL status
   */
-uint32_t USB_ReadDevAllInEpInterrupt(USB_OTG_GlobalTypeDef *USBx)
+RAM_ISR uint32_t USB_ReadDevAllInEpInterrupt(USB_OTG_GlobalTypeDef *USBx)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
   uint32_t tmpreg;
@@ -1201,7 +1267,7 @@ uint32_t USB_ReadDevAllInEpInterrupt(USB_OTG_GlobalTypeDef *USBx)
   *          This parameter can be a value from 0 to 15
   * @retval Device OUT EP Interrupt register
   */
-uint32_t USB_ReadDevOutEPInterrupt(USB_OTG_GlobalTypeDef *USBx, uint8_t epnum)
+RAM_ISR uint32_t USB_ReadDevOutEPInterrupt(USB_OTG_GlobalTypeDef *USBx, uint8_t epnum)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
   uint32_t tmpreg;
@@ -1219,7 +1285,7 @@ uint32_t USB_ReadDevOutEPInterrupt(USB_OTG_GlobalTypeDef *USBx, uint8_t epnum)
   *          This parameter can be a value from 0 to 15
   * @retval Device IN EP Interrupt register
   */
-uint32_t USB_ReadDevInEPInterrupt(USB_OTG_GlobalTypeDef *USBx, uint8_t epnum)
+RAM_ISR uint32_t USB_ReadDevInEPInterrupt(USB_OTG_GlobalTypeDef *USBx, uint8_t epnum)
 {
   uint32_t USBx_BASE = (uint32_t)USBx;
   uint32_t tmpreg, msk, emp;
@@ -1251,7 +1317,7 @@ void  USB_ClearInterrupts(USB_OTG_GlobalTypeDef *USBx, uint32_t interrupt)
   *           0 : Host
   *           1 : Device
   */
-uint32_t USB_GetMode(USB_OTG_GlobalTypeDef *USBx)
+RAM_ISR uint32_t USB_GetMode(USB_OTG_GlobalTypeDef *USBx)
 {
   return ((USBx->GINTSTS) & 0x1U);
 }
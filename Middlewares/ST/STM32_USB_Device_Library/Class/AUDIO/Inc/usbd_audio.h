@@ -27,6 +27,8 @@ extern "C" {
 
 /* Includes ------------------------------------------------------------------*/
 #include  "usbd_ioreq.h"
+#include  "usbd_audio_src.h"
+#include  "usbd_audio_dsp.h"
 
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
   * @{
@@ -61,7 +63,6 @@ extern "C" {
 #define AUDIO_OUT_EP                                  0x01U
 #define AUDIO_IN_EP                                   0x81U
 
-#define USB_AUDIO_CONFIG_DESC_SIZ                     0x76U
 #define AUDIO_INTERFACE_DESC_SIZE                     0x09U
 #define USB_AUDIO_DESC_SIZ                            0x09U
 #define AUDIO_STANDARD_ENDPOINT_DESC_SIZE             0x09U
@@ -88,8 +89,21 @@ extern "C" {
 #define AUDIO_INPUT_TERMINAL_DESC_SIZE                0x0CU
 #define AUDIO_OUTPUT_TERMINAL_DESC_SIZE               0x09U
 #define AUDIO_STREAMING_INTERFACE_DESC_SIZE           0x07U
+#define AUDIO_FEATURE_UNIT_DESC_SIZE                  0x09U
+/* Type I format with a single discrete sampling frequency */
+#define AUDIO_FORMAT_TYPE_I_DESC_SIZE                 0x0BU
 
 #define AUDIO_CONTROL_MUTE                            0x0001U
+#define AUDIO_CONTROL_VOLUME                          0x0002U
+
+/* Feature unit control selectors */
+#define AUDIO_FU_MUTE_CONTROL                         0x01U
+#define AUDIO_FU_VOLUME_CONTROL                       0x02U
+
+/* Feature unit volume range in 1/256dB: -80dB .. 0dB in 1dB steps */
+#define AUDIO_VOLUME_MIN                              (-80 * 256)
+#define AUDIO_VOLUME_MAX                              0
+#define AUDIO_VOLUME_RES                              256
 
 #define AUDIO_FORMAT_TYPE_I                           0x01U
 #define AUDIO_FORMAT_TYPE_III                         0x03U
@@ -97,26 +111,141 @@ extern "C" {
 #define AUDIO_ENDPOINT_GENERAL                        0x01U
 
 #define AUDIO_REQ_GET_CUR                             0x81U
+#define AUDIO_REQ_GET_MIN                             0x82U
+#define AUDIO_REQ_GET_MAX                             0x83U
+#define AUDIO_REQ_GET_RES                             0x84U
 #define AUDIO_REQ_SET_CUR                             0x01U
+#define AUDIO_REQ_GET_MEM                             0x85U
 
 #define AUDIO_OUT_STREAMING_CTRL                      0x02U
 
+/* Vendor requests (bit 7 set for device-to-host, like the class requests) */
+#define AUDIO_VENDOR_REQ_SET_PROC                     0x01U
+#define AUDIO_VENDOR_REQ_GET_PROC                     0x81U
+#define AUDIO_VENDOR_REQ_SET_DSP                      0x02U
+#define AUDIO_VENDOR_REQ_GET_DSP                      0x82U
+#define AUDIO_VENDOR_REQ_GET_DSP_STATS                0x83U
+/* Handler profiling, only with USE_ISR_PROFILE=1: wValue selects the handler (PROFILE_IdTypeDef) */
+#define AUDIO_VENDOR_REQ_GET_PROFILE                  0x84U
+#define AUDIO_VENDOR_REQ_RESET_PROFILE                0x03U
+/* Streaming telemetry: AUDIO_TLM_TypeDef, see usbd_audio_telemetry.h */
+#define AUDIO_VENDOR_REQ_GET_TELEMETRY                0x85U
+#define AUDIO_VENDOR_REQ_RESET_TELEMETRY              0x04U
+/* Data path benchmark, only with USE_AUDIO_BENCH=1: AUDIO_BENCH_ResultTypeDef per kernel,
+   wValue selects the flash accelerator setting (AUDIO_BENCH_ART_xxx) */
+#define AUDIO_VENDOR_REQ_GET_BENCH                    0x86U
+/* Feedback controller gains, AUDIO_VENDOR_FB_CTRL_SIZE bytes */
+#define AUDIO_VENDOR_REQ_SET_FB_CTRL                  0x05U
+#define AUDIO_VENDOR_REQ_GET_FB_CTRL                  0x87U
+/* Latency profile: SET takes the AUDIO_LATENCY_xxx index (1 byte), GET returns AUDIO_VENDOR_LATENCY_SIZE bytes */
+#define AUDIO_VENDOR_REQ_SET_LATENCY                  0x06U
+#define AUDIO_VENDOR_REQ_GET_LATENCY                  0x88U
+/* SET_PROC/GET_PROC data: AUDIO_PROC_xxx flags, then the signed balance */
+#define AUDIO_VENDOR_PROC_DATA_SIZE                   2U
+/* SET_DSP/GET_DSP data: stage enable mask, 32-bit little endian */
+#define AUDIO_VENDOR_DSP_DATA_SIZE                    4U
+/* GET_DSP_STATS data: { cycles_last, cycles_max } per stage, 32-bit little endian */
+#define AUDIO_VENDOR_DSP_STATS_SIZE                   (AUDIO_DSP_STAGE_NUM * 8U)
+/* SET_FB_CTRL/GET_FB_CTRL data: { gain, limit }, 32-bit little endian. The gain is the feedback
+   change per frame of fill deviation in 1/2^22 of the nominal value, the limit the largest
+   distance from the nominal feedback (10.14 shifted left by 8) */
+#define AUDIO_VENDOR_FB_CTRL_SIZE                     8U
+/* GET_LATENCY data: selected profile, profile in use, then its ring size, pre-roll and
+   feedback setpoint in frames, 16-bit little endian */
+#define AUDIO_VENDOR_LATENCY_SIZE                     8U
+/* Largest data stage of a vendor request, several EP0 packets */
+#define AUDIO_VENDOR_BUF_SIZE                         128U
+
+/* Feedback controller defaults: 1/2^14 of the nominal rate per frame, at most +/- 1kHz */
+#define AUDIO_FB_GAIN_DEFAULT                         256U
+#define AUDIO_FB_GAIN_MAX                             65536U
+#define AUDIO_FB_LIMIT_DEFAULT                        (1UL << 22)
+#define AUDIO_FB_LIMIT_MAX                            (8UL << 22)
+
 #define AUDIO_OUT_TC                                  0x01U
 #define AUDIO_IN_TC                                   0x02U
 
 
-#define AUDIO_OUT_PACKET                              (uint16_t)(((USBD_AUDIO_FREQ * 2U * 2U) / 1000U))
+/* Streaming format, the same for every alternate setting. The data path moves whole 32-bit
+   frames, so these describe it in the descriptors rather than make it configurable */
+#define AUDIO_CHANNELS                                2U
+#define AUDIO_SUBFRAME_SIZE                           2U
+#define AUDIO_BIT_RESOLUTION                          16U
+#define AUDIO_FRAME_SIZE                              (AUDIO_CHANNELS * AUDIO_SUBFRAME_SIZE)
+
+/* 48kHz alternate setting: 48 frames per packet, plus one so that the host can follow a device
+   clock running faster than its own */
+#define AUDIO_OUT_PACKET                              (uint16_t)((((USBD_AUDIO_FREQ + 999U) / 1000U) + 1U) * AUDIO_FRAME_SIZE)
+/* 44.1kHz alternate setting: 44 or 45 frames per packet, plus one for feedback corrections */
+#define AUDIO_OUT_PACKET_44K                          (uint16_t)((((44100U + 999U) / 1000U) + 1U) * AUDIO_FRAME_SIZE)
 #define AUDIO_IN_PACKET                               3U
 
 
 #define AUDIO_DEFAULT_VOLUME                          70U
 
-/* Number of sub-packets in the audio transfer buffer. You can modify this value but always make sure
-  that it is an even number and higher than 3 */
-#define AUDIO_OUT_PACKET_NUM                          8U
-/* Total size of the audio transfer buffer */
+/* Audio Streaming interface alternate settings */
+#define AUDIO_ALT_ZERO_BW                             0x00U
+#define AUDIO_ALT_48K                                 0x01U
+/* 44.1kHz from the host, converted to the 48kHz I2S clock on the device */
+#define AUDIO_ALT_44K                                 0x02U
+
+/* Operational alternate settings, numbered from 1 in this order. The configuration descriptor
+   is generated from this table: X(bAlternateSetting, sampling frequency in Hz, OUT wMaxPacketSize) */
+#define AUDIO_AS_ALT_TABLE(X)                                          \
+  X(AUDIO_ALT_48K,  USBD_AUDIO_FREQ,  AUDIO_OUT_PACKET)                \
+  X(AUDIO_ALT_44K,  44100U,           AUDIO_OUT_PACKET_44K)
+
+#define AUDIO_AS_ALT_COUNT(alt, freq, mps)            + 1U
+/* Alternate settings of the streaming interface, zero bandwidth included */
+#define AUDIO_ALT_NUM                                 (1U AUDIO_AS_ALT_TABLE(AUDIO_AS_ALT_COUNT))
+
+/* Descriptor lengths, all derived from the sizes above */
+#define AUDIO_AC_TOTAL_SIZE                           (USB_AUDIO_DESC_SIZ + AUDIO_INPUT_TERMINAL_DESC_SIZE + \
+                                                       AUDIO_FEATURE_UNIT_DESC_SIZE + AUDIO_OUTPUT_TERMINAL_DESC_SIZE)
+/* One operational alternate setting: interface, AS general, format, ISO OUT + CS endpoint, feedback IN */
+#define AUDIO_AS_ALT_DESC_SIZE                        (AUDIO_INTERFACE_DESC_SIZE + AUDIO_STREAMING_INTERFACE_DESC_SIZE + \
+                                                       AUDIO_FORMAT_TYPE_I_DESC_SIZE + AUDIO_STANDARD_ENDPOINT_DESC_SIZE + \
+                                                       AUDIO_STREAMING_ENDPOINT_DESC_SIZE + AUDIO_STANDARD_ENDPOINT_DESC_SIZE)
+/* The device declares interface associations (class 0xEF/02/01) when the CDC port is built
+   in, the audio function then needs one too, covering the AC and AS interfaces */
+#if (USE_USBD_CDC_DIAG == 1U)
+#define AUDIO_IAD_DESC_SIZE                           0x08U
+#else
+#define AUDIO_IAD_DESC_SIZE                           0x00U
+#endif /* USE_USBD_CDC_DIAG */
+#define USB_AUDIO_CONFIG_DESC_SIZ                     (USB_LEN_CFG_DESC + AUDIO_IAD_DESC_SIZE + \
+                                                       AUDIO_INTERFACE_DESC_SIZE + AUDIO_AC_TOTAL_SIZE + \
+                                                       AUDIO_INTERFACE_DESC_SIZE + \
+                                                       ((AUDIO_ALT_NUM - 1U) * AUDIO_AS_ALT_DESC_SIZE))
+
+/* Latency profiles. Playback starts once the pre-roll is buffered, the ring holds twice the
+   pre-roll and the feedback keeps the pre-roll buffered, DMA blocks included. 2ms suits live
+   monitoring, 8ms gives long sessions the most margin against host scheduling hiccups */
+#define AUDIO_LATENCY_2MS                             0U
+#define AUDIO_LATENCY_4MS                             1U
+#define AUDIO_LATENCY_8MS                             2U
+#define AUDIO_LATENCY_NUM                             3U
+#define AUDIO_LATENCY_DEFAULT                         AUDIO_LATENCY_4MS
+/* Largest pre-roll of the table, sizes the ring */
+#define AUDIO_LATENCY_MAX_MS                          8U
+
+/* Number of 1ms packets the audio transfer buffer can hold, enough for the largest latency profile */
+#define AUDIO_OUT_PACKET_NUM                          (2U * AUDIO_LATENCY_MAX_MS)
+/* Size of the static arena the ring is carved from when streaming starts. The ring itself is sized
+   from the I2S rate, the frame format and the latency profile, and only uses what it needs */
 #define AUDIO_TOTAL_BUF_SIZE                          ((uint16_t)(AUDIO_OUT_PACKET * AUDIO_OUT_PACKET_NUM))
 
+/* SOFs (ms) without an OUT packet after which a stream is considered stopped and the I2S,
+   its DMA and the PLLI2S are powered down. The next OUT packet powers them up again */
+#define AUDIO_IDLE_TIMEOUT_MS                         500U
+
+/* Frames per processing block. The I2S DMA plays from two such blocks (ping-pong) and the
+   half/full transfer interrupts drain the next block from the ring through the DSP pipeline */
+#define AUDIO_BLOCK_FRAMES                            32U
+
+/* Size of the meter block returned by GET_MEM on the Feature Unit */
+#define AUDIO_METER_DATA_SIZE                         8U
+
 /* Audio Commands enumeration */
 typedef enum
 {
@@ -153,12 +282,18 @@ typedef struct
 typedef struct
 {
   uint32_t alt_setting;
-  uint8_t buffer[AUDIO_TOTAL_BUF_SIZE];
+  uint8_t *buffer;          /* ring, carved from the arena by AUDIO_Latency_Load */
+  uint16_t ring_size;       /* capacity of buffer in bytes */
+  uint16_t start_size;      /* bytes buffered before the I2S starts */
+  uint16_t fb_target;       /* feedback setpoint, writable frames */
   AUDIO_OffsetTypeDef offset;
   uint8_t rd_enable;
   uint16_t rd_ptr;
   uint16_t wr_ptr;
+  uint32_t out_buf[2U * AUDIO_BLOCK_FRAMES];
   USBD_AUDIO_ControlTypeDef control;
+  uint8_t src_enable;
+  AUDIO_SRC_TypeDef src;
 } USBD_AUDIO_HandleTypeDef;
 
 
@@ -203,6 +338,11 @@ uint8_t USBD_AUDIO_RegisterInterface(USBD_HandleTypeDef *pdev,
                                      USBD_AUDIO_ItfTypeDef *fops);
 
 void USBD_AUDIO_Sync(USBD_HandleTypeDef *pdev, AUDIO_OffsetTypeDef offset);
+void USBD_AUDIO_Suspend(USBD_HandleTypeDef *pdev);
+
+/* Data path kernels, also run by the benchmark */
+uint32_t AUDIO_Ring_Write(uint8_t *ring, uint32_t size, uint32_t wr_ptr, const uint32_t *src, uint32_t count);
+uint32_t AUDIO_Feedback_Calc(uint32_t writable, uint32_t target, uint32_t nom, uint32_t gain);
 /**
   * @}
   */
@@ -0,0 +1,95 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_bench.h
+  * @brief   Header file for the usbd_audio_bench.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_AUDIO_BENCH_H
+#define __USBD_AUDIO_BENCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_BENCH
+  * @brief Data path micro-benchmark
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_BENCH_Exported_Defines
+  * @{
+  */
+/* Build with -DUSE_AUDIO_BENCH=1 to run the benchmark at boot */
+#ifndef USE_AUDIO_BENCH
+#define USE_AUDIO_BENCH                               0U
+#endif /* USE_AUDIO_BENCH */
+
+/* Calls timed per kernel */
+#define AUDIO_BENCH_ITERATIONS                        256U
+
+/* Kernels, in the order of the GET_BENCH reply */
+#define AUDIO_BENCH_RING_WRITE                        0U  /* one 48kHz packet into the ring */
+#define AUDIO_BENCH_FEEDBACK                          1U  /* one feedback value */
+#define AUDIO_BENCH_SRC                               2U  /* one 44.1kHz packet (45 frames) through the SRC */
+#define AUDIO_BENCH_DSP                               3U  /* one AUDIO_BLOCK_FRAMES block through the DSP pipeline */
+#define AUDIO_BENCH_NUM                               4U
+
+/* Flash accelerator settings every kernel is timed under, selected by wValue of GET_BENCH */
+#define AUDIO_BENCH_ART_ON                            0U  /* as set up at startup */
+#define AUDIO_BENCH_ART_OFF                           1U  /* prefetch and both caches off */
+#define AUDIO_BENCH_ART_NUM                           2U
+
+#define AUDIO_VENDOR_BENCH_SIZE                       (AUDIO_BENCH_NUM * 12U)
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_BENCH_Exported_TypesDefinitions
+  * @{
+  */
+/* DWT cycles per call, 32-bit little endian words */
+typedef struct
+{
+  uint32_t min;
+  uint32_t max;
+  uint32_t avg;
+} AUDIO_BENCH_ResultTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_BENCH_Exported_Functions
+  * @{
+  */
+#if (USE_AUDIO_BENCH == 1U)
+void AUDIO_BENCH_Run(void);
+const AUDIO_BENCH_ResultTypeDef *AUDIO_BENCH_Get(uint32_t art);
+#endif /* USE_AUDIO_BENCH */
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_AUDIO_BENCH_H */
@@ -0,0 +1,111 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_dsp.h
+  * @brief   Header file for the usbd_audio_dsp.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_AUDIO_DSP_H
+#define __USBD_AUDIO_DSP_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include "usbd_conf.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_DSP
+  * @brief Playback processing pipeline
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_DSP_Exported_Defines
+  * @{
+  */
+/* Bytes of stage state carved out of the arena at init */
+#define AUDIO_DSP_ARENA_SIZE                          256U
+
+/* Stages, in processing order. Bit n of the enable mask controls stage n */
+#define AUDIO_DSP_STAGE_CHANNEL                       0U
+#define AUDIO_DSP_STAGE_VOLUME                        1U
+#define AUDIO_DSP_STAGE_METER                         2U
+#define AUDIO_DSP_STAGE_NUM                           3U
+
+#define AUDIO_DSP_ENABLE_ALL                          ((1UL << AUDIO_DSP_STAGE_NUM) - 1U)
+
+/* Channel stage flags. The balance goes from -127 (left only) to 127 (right only) */
+#define AUDIO_PROC_DC_BLOCK                           0x01U
+#define AUDIO_PROC_SWAP                               0x02U
+#define AUDIO_PROC_MONO                               0x04U
+#define AUDIO_PROC_INVERT_L                           0x08U
+#define AUDIO_PROC_INVERT_R                           0x10U
+
+/* DC blocker pole: y = x - lp(x), lp cut-off ~= Fs / (2 * pi * 2^shift) = 15Hz at 48kHz */
+#define AUDIO_PROC_DC_SHIFT                           9U
+
+/* Number of frames the level meters integrate over before latching a new reading (100ms) */
+#define AUDIO_METER_WINDOW                            (USBD_AUDIO_FREQ / 10U)
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_DSP_Exported_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  uint32_t state_size;                                           /* bytes of arena used by the stage */
+  void (*Reset)(void *state);                                    /* clear the running state, keep settings */
+  void (*Process)(void *state, uint32_t *frames, uint32_t count);  /* in place, 16-bit stereo, L low */
+} AUDIO_DSP_StageTypeDef;
+
+
+typedef struct
+{
+  uint32_t cycles_last;     /* DWT cycles spent on the last block */
+  uint32_t cycles_max;      /* worst block since the last reset */
+} AUDIO_DSP_StatsTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_DSP_Exported_Functions
+  * @{
+  */
+uint8_t AUDIO_DSP_Init(void);
+void AUDIO_DSP_Reset(void);
+void AUDIO_DSP_Process(uint32_t *frames, uint32_t count);
+void AUDIO_DSP_SetEnable(uint32_t mask);
+uint32_t AUDIO_DSP_GetEnable(void);
+const AUDIO_DSP_StatsTypeDef *AUDIO_DSP_GetStats(void);
+
+void AUDIO_DSP_Channel_Set(uint8_t flags, int8_t balance);
+void AUDIO_DSP_Channel_Get(uint8_t *flags, int8_t *balance);
+void AUDIO_DSP_Volume_Set(int16_t volume, uint8_t mute);
+void AUDIO_DSP_Meter_Read(uint16_t *peak, uint16_t *rms);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_AUDIO_DSP_H */
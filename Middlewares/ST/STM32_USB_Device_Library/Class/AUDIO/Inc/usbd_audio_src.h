@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_src.h
+  * @brief   Header file for the usbd_audio_src.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_AUDIO_SRC_H
+#define __USBD_AUDIO_SRC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_SRC
+  * @brief Fixed ratio 44.1kHz to 48kHz sample rate converter
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_SRC_Exported_Defines
+  * @{
+  */
+/* 48000 / 44100 = 160 / 147: interpolate by L, decimate by M */
+#define AUDIO_SRC_L                                   160U
+#define AUDIO_SRC_M                                   147U
+/* Taps per polyphase branch */
+#define AUDIO_SRC_TAPS                                40U
+
+/* Upper bound of the output frames produced from a block of input frames */
+#define AUDIO_SRC_OUT_FRAMES(frames)                  ((((frames) * AUDIO_SRC_L) / AUDIO_SRC_M) + 1U)
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_SRC_Exported_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  uint32_t hist[2U * AUDIO_SRC_TAPS];   /* stereo input history, stored twice so the window never wraps */
+  uint32_t pos;                         /* history slot of the oldest frame */
+  uint32_t phase;                       /* polyphase branch of the next output, 0..L-1 */
+} AUDIO_SRC_TypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_SRC_Exported_Functions
+  * @{
+  */
+void AUDIO_SRC_Reset(AUDIO_SRC_TypeDef *src);
+uint32_t AUDIO_SRC_Process(AUDIO_SRC_TypeDef *src, const uint32_t *in,
+                           uint32_t frames, uint32_t *out);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_AUDIO_SRC_H */
@@ -0,0 +1,128 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_telemetry.h
+  * @brief   Header file for the usbd_audio_telemetry.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_AUDIO_TELEMETRY_H
+#define __USBD_AUDIO_TELEMETRY_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_TELEMETRY
+  * @brief Streaming telemetry counters
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Exported_Defines
+  * @{
+  */
+/* Buffer fill histogram: bucket n counts samples with fill in [n, n+1) * capacity / buckets */
+#define AUDIO_TLM_FILL_BUCKETS                        8U
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Exported_TypesDefinitions
+  * @{
+  */
+/* Layout returned by the GET_TELEMETRY vendor request, 32-bit little endian words */
+typedef struct
+{
+  uint32_t underruns;           /* DMA blocks the ring could not fill completely */
+  uint32_t underrun_frames;     /* frames of silence played instead */
+  uint32_t overruns;            /* OUT packets dropped, the ring was full */
+  uint32_t oversize;            /* OUT packets dropped, larger than AUDIO_OUT_PACKET */
+  uint32_t iso_out_incomplete;  /* USBD_AUDIO_IsoOutIncomplete calls */
+  uint32_t iso_in_incomplete;   /* USBD_AUDIO_IsoINIncomplete calls */
+  uint32_t work_dropped;        /* packets or feedback updates the work queue refused */
+  uint32_t fill_samples;        /* fill level samples, one per feedback update */
+  uint32_t fill_min;            /* frames buffered (ring + DMA blocks) */
+  uint32_t fill_max;
+  uint32_t fill_hist[AUDIO_TLM_FILL_BUCKETS];
+  uint32_t fb_min;              /* feedback value, 10.14 shifted left by 8 */
+  uint32_t fb_max;
+  uint32_t fb_last;
+  uint32_t boot_attach_us;      /* reset to USBD_Start, kept by AUDIO_TLM_Reset */
+  uint32_t boot_audio_us;       /* reset to the first I2S DMA start, kept by AUDIO_TLM_Reset */
+  uint32_t rx_busy;             /* OUT packets dropped, the previous one was still being converted */
+} AUDIO_TLM_TypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Exported_Variables
+  * @{
+  */
+extern AUDIO_TLM_TypeDef AUDIO_Tlm;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Exported_Macros
+  * @{
+  */
+#define AUDIO_TLM_INC(field)          AUDIO_TLM_Add(&AUDIO_Tlm.field, 1U)
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Exported_Functions
+  * @{
+  */
+/**
+  * @brief  AUDIO_TLM_Add
+  *         Atomic add, safe from any priority without masking interrupts.
+  *         Always inlined, so it runs from wherever the caller does.
+  * @param  ctr: counter
+  * @param  n: increment
+  * @retval None
+  */
+__STATIC_FORCEINLINE void AUDIO_TLM_Add(volatile uint32_t *ctr, uint32_t n)
+{
+  uint32_t val;
+
+  do
+  {
+    val = __LDREXW(ctr);
+  } while (__STREXW(val + n, ctr) != 0U);
+}
+
+void AUDIO_TLM_Reset(void);
+void AUDIO_TLM_Read(AUDIO_TLM_TypeDef *snap);
+void AUDIO_TLM_Fill(uint32_t frames, uint32_t capacity);
+void AUDIO_TLM_Feedback(uint32_t fb);
+uint32_t AUDIO_TLM_Micros(void);
+void AUDIO_TLM_Stamp(uint32_t *stamp);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_AUDIO_TELEMETRY_H */
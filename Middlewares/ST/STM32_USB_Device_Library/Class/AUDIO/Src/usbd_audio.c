@@ -20,16 +20,22 @@
   *             - 1 Audio Terminal Input (1 channel)
   *             - Audio Class-Specific AC Interfaces
   *             - Audio Class-Specific AS Interfaces
-  *             - AudioControl Requests: only SET_CUR and GET_CUR requests are supported (for Mute)
-  *             - Audio Feature Unit (limited to Mute control)
+  *             - AudioControl Requests: GET_CUR/MIN/MAX/RES and SET_CUR on the Feature Unit,
+  *               answered from AUDIO_FU_Controls
+  *             - GET_MEM on the Feature Unit returns the playback peak/RMS level meters
+  *             - Vendor requests, dispatched from AUDIO_VENDOR_Table: DSP channel stage
+  *               settings (DC blocker, balance, swap, mono, polarity), stage enables,
+  *               cycle counts, feedback controller gains, latency profile, telemetry
+  *             - Audio Feature Unit (Mute and Volume on the master channel)
   *             - Audio Synchronization type: Asynchronous
   *             - Single fixed audio sampling rate (configurable in usbd_conf.h file)
+  *             - Alternate setting 2 accepts 44.1kHz and converts it to the 48kHz I2S clock
   *          The current audio class version supports the following audio features:
   *             - Pulse Coded Modulation (PCM) format
   *             - sampling rate: 48KHz.
   *             - Bit resolution: 16
   *             - Number of channels: 2
-  *             - No volume control
+  *             - Volume control, -80dB to 0dB in 1dB steps
   *             - Mute/Unmute capability
   *             - Asynchronous Endpoints
   *
@@ -63,6 +69,11 @@ EndBSPDependencies */
 #include "usbd_audio.h"
 #include "usbd_ctlreq.h"
 #include "stm32f4xx_ll_dma.h"
+#include "work_queue.h"
+#include "event_queue.h"
+#include "profile.h"
+#include "usbd_audio_telemetry.h"
+#include "usbd_audio_bench.h"
 
 /** @addtogroup STM32_USB_DEVICE_LIBRARY
   * @{
@@ -77,6 +88,62 @@ EndBSPDependencies */
 /** @defgroup USBD_AUDIO_Private_TypesDefinitions
   * @{
   */
+/* OUT packet buffer, handed from the OTG interrupt to PendSV */
+typedef struct
+{
+  uint32_t buf[AUDIO_OUT_PACKET / 4U];
+  uint16_t len;
+  volatile uint8_t busy;    /* set by DataOut, cleared once AUDIO_Packet_Work is done with buf */
+  USBD_HandleTypeDef *pdev;
+} AUDIO_RxSlotTypeDef;
+
+/* Feature unit control. CUR is kept formatted next to the fixed MIN/MAX/RES,
+   so every GET is answered straight from the table */
+typedef struct
+{
+  uint8_t unit;             /* bUnitID */
+  uint8_t selector;         /* AUDIO_FU_xxx_CONTROL */
+  uint8_t channel;          /* 0 = master */
+  uint8_t size;             /* parameter block length */
+  uint8_t ranged;           /* GET_MIN/MAX/RES supported */
+  uint8_t cur[2];
+  uint8_t min[2];
+  uint8_t max[2];
+  uint8_t res[2];
+} AUDIO_FU_ControlTypeDef;
+
+/* Ring layout of a latency profile, see AUDIO_Latency_Calc */
+typedef struct
+{
+  uint16_t ring_size;       /* bytes carved from the arena */
+  uint16_t start_size;      /* pre-roll, bytes */
+  uint16_t fb_target;       /* feedback setpoint, writable frames */
+} AUDIO_LatencyTypeDef;
+
+/* Vendor request, see AUDIO_VENDOR_Table */
+typedef struct
+{
+  uint8_t request;                                    /* bRequest */
+  uint16_t size;                                      /* data stage: exact length OUT, largest IN */
+  uint8_t (*Get)(uint16_t value, uint8_t *buf);       /* IN: fills size bytes, USBD_FAIL for a bad wValue */
+  void (*Set)(uint16_t value, const uint8_t *buf);    /* OUT: thread mode, interrupts masked */
+} AUDIO_VENDOR_EntryTypeDef;
+
+typedef enum
+{
+  AUDIO_VENDOR_IDLE = 0,
+  AUDIO_VENDOR_RX,          /* data stage in progress */
+  AUDIO_VENDOR_QUEUED,      /* waiting for AUDIO_VENDOR_Event */
+} AUDIO_VENDOR_StateTypeDef;
+
+/* OUT request received on EP0, applied from thread mode */
+typedef struct
+{
+  volatile AUDIO_VENDOR_StateTypeDef state;
+  const AUDIO_VENDOR_EntryTypeDef *entry;
+  uint16_t value;
+  uint32_t data[AUDIO_VENDOR_BUF_SIZE / 4U];
+} AUDIO_VENDOR_PendingTypeDef;
 /**
   * @}
   */
@@ -85,6 +152,27 @@ EndBSPDependencies */
 /** @defgroup USBD_AUDIO_Private_Defines
   * @{
   */
+/* Feature Unit Config */
+#define AUDIO_CONTROL_FEATURES         (AUDIO_CONTROL_MUTE | AUDIO_CONTROL_VOLUME)
+
+/* Registers the class reads directly. They can be predefined ahead of this file (the host
+   simulation in Tests/host does it from its stm32f4xx_hal.h) to run the class against a
+   simulated DMA and SOF clock */
+#ifndef AUDIO_DMA_NDTR
+/* Half-words the I2S DMA has left in the current pass over out_buf */
+#define AUDIO_DMA_NDTR()               (LL_DMA_ReadReg(DMA1_Stream4, NDTR) & 0xFFFFU)
+#endif /* AUDIO_DMA_NDTR */
+
+#ifndef AUDIO_DMA_RUNNING
+/* The I2S DMA is going round out_buf, its half/full transfer interrupts refill the blocks */
+#define AUDIO_DMA_RUNNING()            ((LL_DMA_ReadReg(DMA1_Stream4, CR) & DMA_SxCR_EN) != 0U)
+#endif /* AUDIO_DMA_RUNNING */
+
+#ifndef AUDIO_USB_FNSOF
+/* Frame number of the last SOF */
+#define AUDIO_USB_FNSOF()              ((((USB_OTG_DeviceTypeDef *)(USB_OTG_FS_PERIPH_BASE + USB_OTG_DEVICE_BASE))->DSTS \
+                                         & USB_OTG_DSTS_FNSOF) >> 8)
+#endif /* AUDIO_USB_FNSOF */
 /**
   * @}
   */
@@ -95,8 +183,69 @@ EndBSPDependencies */
   */
 #define AUDIO_SAMPLE_FREQ(frq)         (uint8_t)(frq), (uint8_t)((frq >> 8)), (uint8_t)((frq >> 16))
 
-#define AUDIO_PACKET_SZE(frq)          (uint8_t)(((frq * 2U * 2U)/1000U) & 0xFFU), \
-                                       (uint8_t)((((frq * 2U * 2U)/1000U) >> 8) & 0xFFU)
+/* Streaming alternate setting of AUDIO_AS_ALT_TABLE, AUDIO_AS_ALT_DESC_SIZE bytes */
+#define AUDIO_AS_ALT_DESC(alt, freq, mps)                                                        \
+  /* USB Speaker Standard AS Interface Descriptor - Audio Streaming Operational */               \
+  AUDIO_INTERFACE_DESC_SIZE,            /* bLength */                                            \
+  USB_DESC_TYPE_INTERFACE,              /* bDescriptorType */                                    \
+  0x01,                                 /* bInterfaceNumber */                                   \
+  (alt),                                /* bAlternateSetting */                                  \
+  0x02,                                 /* bNumEndpoints */                                      \
+  USB_DEVICE_CLASS_AUDIO,               /* bInterfaceClass */                                    \
+  AUDIO_SUBCLASS_AUDIOSTREAMING,        /* bInterfaceSubClass */                                 \
+  AUDIO_PROTOCOL_UNDEFINED,             /* bInterfaceProtocol */                                 \
+  0x00,                                 /* iInterface */                                         \
+                                                                                                 \
+  /* USB Speaker Audio Streaming Interface Descriptor */                                         \
+  AUDIO_STREAMING_INTERFACE_DESC_SIZE,  /* bLength */                                            \
+  AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */                                    \
+  AUDIO_STREAMING_GENERAL,              /* bDescriptorSubtype */                                 \
+  0x01,                                 /* bTerminalLink */                                      \
+  0x01,                                 /* bDelay */                                             \
+  0x01,                                 /* wFormatTag AUDIO_FORMAT_PCM  0x0001 */                \
+  0x00,                                                                                          \
+                                                                                                 \
+  /* USB Speaker Audio Type I Format Interface Descriptor */                                     \
+  AUDIO_FORMAT_TYPE_I_DESC_SIZE,        /* bLength */                                            \
+  AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */                                    \
+  AUDIO_STREAMING_FORMAT_TYPE,          /* bDescriptorSubtype */                                 \
+  AUDIO_FORMAT_TYPE_I,                  /* bFormatType */                                        \
+  AUDIO_CHANNELS,                       /* bNrChannels */                                        \
+  AUDIO_SUBFRAME_SIZE,                  /* bSubFrameSize */                                      \
+  AUDIO_BIT_RESOLUTION,                 /* bBitResolution */                                     \
+  0x01,                                 /* bSamFreqType only one frequency supported */          \
+  AUDIO_SAMPLE_FREQ(freq),              /* Audio sampling frequency coded on 3 bytes */          \
+                                                                                                 \
+  /* Endpoint 1 - Standard Descriptor */                                                         \
+  AUDIO_STANDARD_ENDPOINT_DESC_SIZE,    /* bLength */                                            \
+  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */                                    \
+  AUDIO_OUT_EP,                         /* bEndpointAddress 1 out endpoint */                    \
+  USBD_EP_TYPE_ISOC_ASYNC,              /* bmAttributes */                                       \
+  LOBYTE(mps),                          /* wMaxPacketSize in Bytes */                            \
+  HIBYTE(mps),                                                                                   \
+  AUDIO_FS_BINTERVAL,                   /* bInterval */                                          \
+  0x00,                                 /* bRefresh */                                           \
+  AUDIO_IN_EP,                          /* bSynchAddress */                                      \
+                                                                                                 \
+  /* Endpoint - Audio Streaming Descriptor */                                                    \
+  AUDIO_STREAMING_ENDPOINT_DESC_SIZE,   /* bLength */                                            \
+  AUDIO_ENDPOINT_DESCRIPTOR_TYPE,       /* bDescriptorType */                                    \
+  AUDIO_ENDPOINT_GENERAL,               /* bDescriptor */                                        \
+  0x00,                                 /* bmAttributes */                                       \
+  0x00,                                 /* bLockDelayUnits */                                    \
+  0x00,                                 /* wLockDelay */                                         \
+  0x00,                                                                                          \
+                                                                                                 \
+  /* Endpoint 2 - Standard AS Isochronous Synch Endpoint Descriptor, UAC 1.0 4.6.2.1 */          \
+  AUDIO_STANDARD_ENDPOINT_DESC_SIZE,    /* bLength */                                            \
+  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */                                    \
+  AUDIO_IN_EP,                          /* bEndpointAddress */                                   \
+  0x11,                                 /* bmAttributes: isochronous, feedback */                \
+  LOBYTE(AUDIO_IN_PACKET),              /* wMaxPacketSize in Bytes */                            \
+  HIBYTE(AUDIO_IN_PACKET),                                                                       \
+  0x01,                                 /* bInterval 1ms */                                      \
+  0x02,                                 /* bRefresh 4ms = 2^2 */                                 \
+  0x00,                                 /* bSynchAddress */
 
 /**
   * @}
@@ -122,8 +271,39 @@ static uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev);
 
 static uint8_t USBD_AUDIO_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
 static uint8_t USBD_AUDIO_IsoOutIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
-static void AUDIO_REQ_GetCurrent(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
-static void AUDIO_REQ_SetCurrent(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t AUDIO_REQ_FeatureUnit(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static void AUDIO_FU_Apply(USBD_HandleTypeDef *pdev, AUDIO_FU_ControlTypeDef *ctrl, const uint8_t *data);
+static void AUDIO_FU_Reset(void);
+static void AUDIO_REQ_GetMeter(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static void AUDIO_Block_Fill(USBD_AUDIO_HandleTypeDef *haudio, uint32_t *dst);
+static void AUDIO_Packet_Work(void *arg);
+static void AUDIO_Feedback_Work(void *arg);
+static void AUDIO_Alt_Event(void *ctx);
+static void AUDIO_Stream_Idle(USBD_HandleTypeDef *pdev);
+static uint8_t AUDIO_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static void AUDIO_VENDOR_RxReady(USBD_HandleTypeDef *pdev);
+static void AUDIO_VENDOR_Event(void *ctx);
+static uint8_t AUDIO_VENDOR_GetProc(uint16_t value, uint8_t *buf);
+static void AUDIO_VENDOR_SetProc(uint16_t value, const uint8_t *buf);
+static uint8_t AUDIO_VENDOR_GetDsp(uint16_t value, uint8_t *buf);
+static void AUDIO_VENDOR_SetDsp(uint16_t value, const uint8_t *buf);
+static uint8_t AUDIO_VENDOR_GetDspStats(uint16_t value, uint8_t *buf);
+static uint8_t AUDIO_VENDOR_GetTelemetry(uint16_t value, uint8_t *buf);
+static void AUDIO_VENDOR_ResetTelemetry(uint16_t value, const uint8_t *buf);
+static uint8_t AUDIO_VENDOR_GetFbCtrl(uint16_t value, uint8_t *buf);
+static void AUDIO_VENDOR_SetFbCtrl(uint16_t value, const uint8_t *buf);
+static uint8_t AUDIO_VENDOR_GetLatency(uint16_t value, uint8_t *buf);
+static void AUDIO_VENDOR_SetLatency(uint16_t value, const uint8_t *buf);
+static void AUDIO_Latency_Calc(uint8_t profile, uint32_t freq, uint32_t frame_size,
+                               AUDIO_LatencyTypeDef *lat);
+static uint8_t AUDIO_Latency_Load(USBD_AUDIO_HandleTypeDef *haudio);
+#if (USE_AUDIO_BENCH == 1U)
+static uint8_t AUDIO_VENDOR_GetBench(uint16_t value, uint8_t *buf);
+#endif /* USE_AUDIO_BENCH */
+#if (USE_ISR_PROFILE == 1U)
+static uint8_t AUDIO_VENDOR_GetProfile(uint16_t value, uint8_t *buf);
+static void AUDIO_VENDOR_ResetProfile(uint16_t value, const uint8_t *buf);
+#endif /* USE_ISR_PROFILE */
 
 /**
   * @}
@@ -157,7 +337,7 @@ __ALIGN_BEGIN static uint8_t USBD_AUDIO_CfgDesc[USB_AUDIO_CONFIG_DESC_SIZ] __ALI
   /* Configuration 1 */
   0x09,                                 /* bLength */
   USB_DESC_TYPE_CONFIGURATION,          /* bDescriptorType */
-  LOBYTE(USB_AUDIO_CONFIG_DESC_SIZ),    /* wTotalLength  109 bytes*/
+  LOBYTE(USB_AUDIO_CONFIG_DESC_SIZ),    /* wTotalLength */
   HIBYTE(USB_AUDIO_CONFIG_DESC_SIZ),
   0x02,                                 /* bNumInterfaces */
   0x01,                                 /* bConfigurationValue */
@@ -170,6 +350,19 @@ __ALIGN_BEGIN static uint8_t USBD_AUDIO_CfgDesc[USB_AUDIO_CONFIG_DESC_SIZ] __ALI
   USBD_MAX_POWER,                       /* bMaxPower = 100 mA */
   /* 09 byte*/
 
+#if (USE_USBD_CDC_DIAG == 1U)
+  /* Interface Association Descriptor: AC interface 0 and AS interface 1 */
+  AUDIO_IAD_DESC_SIZE,                  /* bLength */
+  USB_DESC_TYPE_IAD,                    /* bDescriptorType */
+  0x00,                                 /* bFirstInterface */
+  0x02,                                 /* bInterfaceCount */
+  USB_DEVICE_CLASS_AUDIO,               /* bFunctionClass */
+  AUDIO_SUBCLASS_AUDIOCONTROL,          /* bFunctionSubClass */
+  AUDIO_PROTOCOL_UNDEFINED,             /* bFunctionProtocol */
+  0x00,                                 /* iFunction */
+  /* 08 byte*/
+#endif /* USE_USBD_CDC_DIAG */
+
   /* USB Speaker Standard interface descriptor */
   AUDIO_INTERFACE_DESC_SIZE,            /* bLength */
   USB_DESC_TYPE_INTERFACE,              /* bDescriptorType */
@@ -183,13 +376,13 @@ __ALIGN_BEGIN static uint8_t USBD_AUDIO_CfgDesc[USB_AUDIO_CONFIG_DESC_SIZ] __ALI
   /* 09 byte*/
 
   /* USB Speaker Class-specific AC Interface Descriptor */
-  AUDIO_INTERFACE_DESC_SIZE,            /* bLength */
+  USB_AUDIO_DESC_SIZ,                   /* bLength */
   AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */
   AUDIO_CONTROL_HEADER,                 /* bDescriptorSubtype */
   0x00,          /* 1.00 */             /* bcdADC */
   0x01,
-  0x27,                                 /* wTotalLength = 39*/
-  0x00,
+  LOBYTE(AUDIO_AC_TOTAL_SIZE),          /* wTotalLength */
+  HIBYTE(AUDIO_AC_TOTAL_SIZE),
   0x01,                                 /* bInCollection */
   0x01,                                 /* baInterfaceNr */
   /* 09 byte*/
@@ -210,19 +403,19 @@ __ALIGN_BEGIN static uint8_t USBD_AUDIO_CfgDesc[USB_AUDIO_CONFIG_DESC_SIZ] __ALI
   /* 12 byte*/
 
   /* USB Speaker Audio Feature Unit Descriptor */
-  0x09,                                 /* bLength */
+  AUDIO_FEATURE_UNIT_DESC_SIZE,         /* bLength */
   AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */
   AUDIO_CONTROL_FEATURE_UNIT,           /* bDescriptorSubtype */
   AUDIO_OUT_STREAMING_CTRL,             /* bUnitID */
   0x01,                                 /* bSourceID */
   0x01,                                 /* bControlSize */
-  AUDIO_CONTROL_MUTE,                   /* bmaControls(0) */
+  AUDIO_CONTROL_FEATURES,               /* bmaControls(0) */
   0,                                    /* bmaControls(1) */
   0x00,                                 /* iTerminal */
   /* 09 byte*/
 
   /*USB Speaker Output Terminal Descriptor */
-  0x09,      /* bLength */
+  AUDIO_OUTPUT_TERMINAL_DESC_SIZE,      /* bLength */
   AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */
   AUDIO_CONTROL_OUTPUT_TERMINAL,        /* bDescriptorSubtype */
   0x03,                                 /* bTerminalID */
@@ -246,72 +439,8 @@ __ALIGN_BEGIN static uint8_t USBD_AUDIO_CfgDesc[USB_AUDIO_CONFIG_DESC_SIZ] __ALI
   0x00,                                 /* iInterface */
   /* 09 byte*/
 
-  /* USB Speaker Standard AS Interface Descriptor - Audio Streaming Operational */
-  /* Interface 1, Alternate Setting 1                                           */
-  AUDIO_INTERFACE_DESC_SIZE,            /* bLength */
-  USB_DESC_TYPE_INTERFACE,              /* bDescriptorType */
-  0x01,                                 /* bInterfaceNumber */
-  0x01,                                 /* bAlternateSetting */
-  0x02,                                 /* bNumEndpoints */
-  USB_DEVICE_CLASS_AUDIO,               /* bInterfaceClass */
-  AUDIO_SUBCLASS_AUDIOSTREAMING,        /* bInterfaceSubClass */
-  AUDIO_PROTOCOL_UNDEFINED,             /* bInterfaceProtocol */
-  0x00,                                 /* iInterface */
-  /* 09 byte*/
-
-  /* USB Speaker Audio Streaming Interface Descriptor */
-  AUDIO_STREAMING_INTERFACE_DESC_SIZE,  /* bLength */
-  AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */
-  AUDIO_STREAMING_GENERAL,              /* bDescriptorSubtype */
-  0x01,                                 /* bTerminalLink */
-  0x01,                                 /* bDelay */
-  0x01,                                 /* wFormatTag AUDIO_FORMAT_PCM  0x0001 */
-  0x00,
-  /* 07 byte*/
-
-  /* USB Speaker Audio Type III Format Interface Descriptor */
-  0x0B,                                 /* bLength */
-  AUDIO_INTERFACE_DESCRIPTOR_TYPE,      /* bDescriptorType */
-  AUDIO_STREAMING_FORMAT_TYPE,          /* bDescriptorSubtype */
-  AUDIO_FORMAT_TYPE_I,                  /* bFormatType */
-  0x02,                                 /* bNrChannels */
-  0x02,                                 /* bSubFrameSize :  2 Bytes per frame (16bits) */
-  16,                                   /* bBitResolution (16-bits per sample) */
-  0x01,                                 /* bSamFreqType only one frequency supported */
-  AUDIO_SAMPLE_FREQ(USBD_AUDIO_FREQ),   /* Audio sampling frequency coded on 3 bytes */
-  /* 11 byte*/
-
-  /* Endpoint 1 - Standard Descriptor */
-  AUDIO_STANDARD_ENDPOINT_DESC_SIZE,    /* bLength */
-  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */
-  AUDIO_OUT_EP,                         /* bEndpointAddress 1 out endpoint */
-  USBD_EP_TYPE_ISOC_ASYNC,              /* bmAttributes */
-  AUDIO_PACKET_SZE(USBD_AUDIO_FREQ),    /* wMaxPacketSize in Bytes (Freq(Samples)*2(Stereo)*2(HalfWord)) */
-  AUDIO_FS_BINTERVAL,                   /* bInterval */
-  0x00,                                 /* bRefresh */
-  AUDIO_IN_EP,                          /* bSynchAddress */
-  /* 09 byte*/
-
-  /* Endpoint - Audio Streaming Descriptor*/
-  AUDIO_STREAMING_ENDPOINT_DESC_SIZE,   /* bLength */
-  AUDIO_ENDPOINT_DESCRIPTOR_TYPE,       /* bDescriptorType */
-  AUDIO_ENDPOINT_GENERAL,               /* bDescriptor */
-  0x00,                                 /* bmAttributes */
-  0x00,                                 /* bLockDelayUnits */
-  0x00,                                 /* wLockDelay */
-  0x00,
-  /* 07 byte*/
-
-  /* Endpoint 2 - Standard Descriptor - See UAC Spec 1.0 p.63 4.6.2.1 Standard AS Isochronous Synch Endpoint Descriptor */
-  AUDIO_STANDARD_ENDPOINT_DESC_SIZE, /* bLength */
-  USB_DESC_TYPE_ENDPOINT,            /* bDescriptorType */
-  AUDIO_IN_EP,                       /* bEndpointAddress */
-  0x11,                              /* bmAttributes */
-  0x03, 0x00,                        /* wMaxPacketSize in Bytes */
-  0x01,                              /* bInterval 1ms */
-  0x02,		                         /* bRefresh 4ms = 2^2 */
-  0x00,                              /* bSynchAddress */
-  /* 09 byte*/
+  /* Operational alternate settings, 52 bytes each */
+  AUDIO_AS_ALT_TABLE(AUDIO_AS_ALT_DESC)
 } ;
 
 /* USB Standard Device Descriptor */
@@ -339,12 +468,13 @@ __ALIGN_BEGIN static uint8_t USBD_AUDIO_DeviceQualifierDesc[USB_LEN_DEV_QUALIFIE
 volatile uint32_t tx_flag = 1;
 volatile uint32_t is_playing = 0;
 volatile uint32_t all_ready = 0;
+/* Set while an operational alternate setting is selected but no stream is coming in, see
+   AUDIO_Stream_Idle. idle_sofs counts the SOFs since the last OUT packet */
+static volatile uint8_t audio_idle = 0U;
+static volatile uint32_t idle_sofs = 0U;
 // FNSOF is critical for frequency changing to work
 volatile uint32_t fnsof = 0;
 
-/* Feature Unit Config */
-#define AUDIO_CONTROL_FEATURES AUDIO_CONTROL_MUTE | AUDIO_CONTROL_VOL
-
 /* Nomial feedback data for different frequencies */
 #define AUDIO_FB_DEFAULT \
         (USBD_AUDIO_FREQ == 96000) ? (96 << 22) \
@@ -352,10 +482,29 @@ volatile uint32_t fnsof = 0;
       : (USBD_AUDIO_FREQ == 44100) ? ((44 << 22) + (1 << 22) / 10) \
       : (48 << 22)
 
-/* Feedback is limited to +/- 1kHz */
-#define AUDIO_FB_DELTA (uint32_t)(1 << 22)
+/* Nominal feedback of the 44.1kHz alternate setting, fed through the SRC */
+#define AUDIO_FB_44K ((44 << 22) + (1 << 22) / 10)
 
 volatile uint32_t fb_nom = AUDIO_FB_DEFAULT;
+/* Pre-roll in ms of the latency profiles, indexed by AUDIO_LATENCY_xxx */
+static const uint8_t AUDIO_Latency_Ms[AUDIO_LATENCY_NUM] = { 2U, 4U, AUDIO_LATENCY_MAX_MS };
+
+/* Backing store of the ring, the handle only keeps a pointer into it. The ring is always filled
+   at the I2S rate behind the SRC, so its frame format does not change with the alternate
+   setting, only its size with the latency profile. Kept out of the class pool (usbd_conf.c) on
+   purpose: the pool is a bump allocator rewound only once every class block is back, so a ring
+   resized on SET_INTERFACE could not be given back, and as a static array the worst case shows
+   in the linker map */
+static uint32_t AUDIO_Ring_Arena[AUDIO_TOTAL_BUF_SIZE / 4U];
+
+/* Selected by AUDIO_VENDOR_REQ_SET_LATENCY, taken on the next start of streaming */
+static volatile uint8_t latency_sel = AUDIO_LATENCY_DEFAULT;
+/* Profile loaded into the class handle */
+static uint8_t latency_active = AUDIO_LATENCY_DEFAULT;
+
+/* Feedback controller, set by AUDIO_VENDOR_REQ_SET_FB_CTRL */
+volatile uint32_t fb_gain = AUDIO_FB_GAIN_DEFAULT;
+volatile uint32_t fb_limit = AUDIO_FB_LIMIT_DEFAULT;
 volatile uint32_t fb_value = AUDIO_FB_DEFAULT;
 volatile uint32_t audio_buf_writable_size_last = AUDIO_TOTAL_BUF_SIZE / 2U;
 volatile int32_t fb_raw = AUDIO_FB_DEFAULT;
@@ -363,6 +512,51 @@ volatile uint8_t fb_data[3] = {
     (uint8_t)((AUDIO_FB_DEFAULT & 0x0000FF00) >> 8),
     (uint8_t)((AUDIO_FB_DEFAULT & 0x00FF0000) >> 16),
     (uint8_t)((AUDIO_FB_DEFAULT & 0xFF000000) >> 24)};
+/* Set while a feedback update is queued, so at most one is pending */
+volatile uint32_t fb_work_pending = 0;
+
+/* OUT packets: one is being received while the other waits for PendSV */
+static AUDIO_RxSlotTypeDef AUDIO_RxSlot[2];
+static uint8_t rx_slot = 0U;
+
+/* Feature unit controls, mute then volume (AUDIO_FU_Apply combines the two). CUR is set by AUDIO_FU_Reset */
+static AUDIO_FU_ControlTypeDef AUDIO_FU_Controls[] =
+{
+  /* unit                     selector                 ch  size ranged cur        min                                                      max                                                      res */
+  { AUDIO_OUT_STREAMING_CTRL, AUDIO_FU_MUTE_CONTROL,   0U, 1U,  0U,    {0U, 0U},  {0U, 0U},                                                {0U, 0U},                                                {0U, 0U} },
+  { AUDIO_OUT_STREAMING_CTRL, AUDIO_FU_VOLUME_CONTROL, 0U, 2U,  1U,    {0U, 0U},  {LOBYTE(AUDIO_VOLUME_MIN), HIBYTE(AUDIO_VOLUME_MIN)},    {LOBYTE(AUDIO_VOLUME_MAX), HIBYTE(AUDIO_VOLUME_MAX)},    {LOBYTE(AUDIO_VOLUME_RES), HIBYTE(AUDIO_VOLUME_RES)} },
+};
+
+/* Target of the SET_CUR whose data stage is in progress */
+static AUDIO_FU_ControlTypeDef *fu_pending = NULL;
+
+/* Vendor requests. IN data is sent from AUDIO_VENDOR_Buf, OUT data is received into
+   AUDIO_VENDOR_Pending, sizes are at most AUDIO_VENDOR_BUF_SIZE */
+static const AUDIO_VENDOR_EntryTypeDef AUDIO_VENDOR_Table[] =
+{
+  /* bRequest                          size                             Get                          Set */
+  { AUDIO_VENDOR_REQ_SET_PROC,         AUDIO_VENDOR_PROC_DATA_SIZE,     NULL,                        AUDIO_VENDOR_SetProc },
+  { AUDIO_VENDOR_REQ_GET_PROC,         AUDIO_VENDOR_PROC_DATA_SIZE,     AUDIO_VENDOR_GetProc,        NULL },
+  { AUDIO_VENDOR_REQ_SET_DSP,          AUDIO_VENDOR_DSP_DATA_SIZE,      NULL,                        AUDIO_VENDOR_SetDsp },
+  { AUDIO_VENDOR_REQ_GET_DSP,          AUDIO_VENDOR_DSP_DATA_SIZE,      AUDIO_VENDOR_GetDsp,         NULL },
+  { AUDIO_VENDOR_REQ_GET_DSP_STATS,    AUDIO_VENDOR_DSP_STATS_SIZE,     AUDIO_VENDOR_GetDspStats,    NULL },
+  { AUDIO_VENDOR_REQ_GET_TELEMETRY,    sizeof(AUDIO_TLM_TypeDef),       AUDIO_VENDOR_GetTelemetry,   NULL },
+  { AUDIO_VENDOR_REQ_RESET_TELEMETRY,  0U,                              NULL,                        AUDIO_VENDOR_ResetTelemetry },
+  { AUDIO_VENDOR_REQ_SET_FB_CTRL,      AUDIO_VENDOR_FB_CTRL_SIZE,       NULL,                        AUDIO_VENDOR_SetFbCtrl },
+  { AUDIO_VENDOR_REQ_GET_FB_CTRL,      AUDIO_VENDOR_FB_CTRL_SIZE,       AUDIO_VENDOR_GetFbCtrl,      NULL },
+  { AUDIO_VENDOR_REQ_SET_LATENCY,      1U,                              NULL,                        AUDIO_VENDOR_SetLatency },
+  { AUDIO_VENDOR_REQ_GET_LATENCY,      AUDIO_VENDOR_LATENCY_SIZE,       AUDIO_VENDOR_GetLatency,     NULL },
+#if (USE_AUDIO_BENCH == 1U)
+  { AUDIO_VENDOR_REQ_GET_BENCH,        AUDIO_VENDOR_BENCH_SIZE,         AUDIO_VENDOR_GetBench,       NULL },
+#endif /* USE_AUDIO_BENCH */
+#if (USE_ISR_PROFILE == 1U)
+  { AUDIO_VENDOR_REQ_GET_PROFILE,      sizeof(PROFILE_ReportTypeDef),   AUDIO_VENDOR_GetProfile,     NULL },
+  { AUDIO_VENDOR_REQ_RESET_PROFILE,    0U,                              NULL,                        AUDIO_VENDOR_ResetProfile },
+#endif /* USE_ISR_PROFILE */
+};
+
+static AUDIO_VENDOR_PendingTypeDef AUDIO_VENDOR_Pending;
+static uint32_t AUDIO_VENDOR_Buf[AUDIO_VENDOR_BUF_SIZE / 4U];
 /**
   * @brief  USBD_AUDIO_Init
   *         Initialize the AUDIO interface
@@ -411,17 +605,32 @@ static uint8_t USBD_AUDIO_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
   haudio->wr_ptr = 0U;
   haudio->rd_ptr = 0U;
   haudio->rd_enable = 0U;
+  haudio->src_enable = 0U;
+  (void)USBD_memset(haudio->out_buf, 0, sizeof(haudio->out_buf));
+  audio_idle = 0U;
+  idle_sofs = 0U;
 
-  /* Initialize the Audio output Hardware layer */
-  if (((USBD_AUDIO_ItfTypeDef *)pdev->pUserData)->Init(USBD_AUDIO_FREQ,
-                                                       AUDIO_DEFAULT_VOLUME,
-                                                       0U) != 0U)
+  if (AUDIO_Latency_Load(haudio) != (uint8_t)USBD_OK)
   {
-    return (uint8_t)USBD_FAIL;
+    return (uint8_t)USBD_EMEM;
+  }
+
+  if (AUDIO_DSP_Init() != (uint8_t)USBD_OK)
+  {
+    return (uint8_t)USBD_EMEM;
   }
 
+  AUDIO_VENDOR_Pending.state = AUDIO_VENDOR_IDLE;
+  AUDIO_FU_Reset();
+
+  EVENT_Register(EVENT_AUDIO_ALT, AUDIO_Alt_Event, pdev);
+  EVENT_Register(EVENT_AUDIO_VENDOR, AUDIO_VENDOR_Event, pdev);
+
+  /* The audio output hardware layer is initialized from thread mode on the first
+     SET_INTERFACE to a streaming alternate setting, see AUDIO_Alt_Event */
+
   /* Prepare Out endpoint to receive 1st packet */
-  (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, haudio->buffer,
+  (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, (uint8_t *)AUDIO_RxSlot[rx_slot].buf,
                                AUDIO_OUT_PACKET);
 
   return (uint8_t)USBD_OK;
@@ -452,12 +661,15 @@ static uint8_t USBD_AUDIO_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
 
   tx_flag = 0U;
 
-  /* DeInit  physical Interface components */
+  /* DeInit  physical Interface components. The DMA may still be reading out_buf until
+     AUDIO_Alt_Event stops it from thread mode, so leave silence behind */
   if (pdev->pClassData != NULL)
   {
-    ((USBD_AUDIO_ItfTypeDef *)pdev->pUserData)->DeInit(0U);
+    (void)USBD_memset(((USBD_AUDIO_HandleTypeDef *)pdev->pClassData)->out_buf, 0,
+                      sizeof(((USBD_AUDIO_HandleTypeDef *)pdev->pClassData)->out_buf));
     (void)USBD_free(pdev->pClassData);
     pdev->pClassData = NULL;
+    EVENT_Post(EVENT_AUDIO_ALT);
   }
 
   return (uint8_t)USBD_OK;
@@ -492,11 +704,23 @@ static uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev,
       switch (req->bRequest)
       {
         case AUDIO_REQ_GET_CUR:
-          AUDIO_REQ_GetCurrent(pdev, req);
+        case AUDIO_REQ_GET_MIN:
+        case AUDIO_REQ_GET_MAX:
+        case AUDIO_REQ_GET_RES:
+        case AUDIO_REQ_SET_CUR:
+          ret = (USBD_StatusTypeDef)AUDIO_REQ_FeatureUnit(pdev, req);
           break;
 
-        case AUDIO_REQ_SET_CUR:
-          AUDIO_REQ_SetCurrent(pdev, req);
+        case AUDIO_REQ_GET_MEM:
+          if (HIBYTE(req->wIndex) == AUDIO_OUT_STREAMING_CTRL)
+          {
+            AUDIO_REQ_GetMeter(pdev, req);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
           break;
 
         default:
@@ -524,7 +748,7 @@ static uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev,
         case USB_REQ_GET_DESCRIPTOR:
           if ((req->wValue >> 8) == AUDIO_DESCRIPTOR_TYPE)
           {
-            pbuf = USBD_AUDIO_CfgDesc + 18;
+            pbuf = USBD_AUDIO_CfgDesc + USB_LEN_CFG_DESC + AUDIO_IAD_DESC_SIZE + AUDIO_INTERFACE_DESC_SIZE;
             len = MIN(USB_AUDIO_DESC_SIZ, req->wLength);
 
             (void)USBD_CtlSendData(pdev, pbuf, len);
@@ -546,12 +770,13 @@ static uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev,
         case USB_REQ_SET_INTERFACE:
           if (pdev->dev_state == USBD_STATE_CONFIGURED)
           {
-            if ((uint8_t)(req->wValue) <= USBD_MAX_NUM_INTERFACES)
+            if ((uint8_t)(req->wValue) < AUDIO_ALT_NUM)
             {
               haudio->alt_setting = (uint8_t)(req->wValue);
               if (haudio->alt_setting == 0)
               {
-            	  memset(&haudio->buffer, 0, AUDIO_TOTAL_BUF_SIZE);
+            	  memset(haudio->buffer, 0, haudio->ring_size);
+            	  memset(&haudio->out_buf, 0, sizeof(haudio->out_buf));
             	  all_ready = 0U;
             	  tx_flag = 1U;
             	  is_playing = 0U;
@@ -561,10 +786,13 @@ static uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev,
             	  haudio->rd_ptr = 0U;
             	  haudio->wr_ptr = 0U;
 
+            	  AUDIO_DSP_Reset();
+
             	  USBD_LL_FlushEP(pdev, AUDIO_IN_EP);
             	  USBD_LL_FlushEP(pdev, AUDIO_OUT_EP);
 
-            	  ((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->DeInit(0);
+            	  /* The hardware layer is stopped from thread mode */
+            	  EVENT_Post(EVENT_AUDIO_ALT);
               }
               else
               {
@@ -576,13 +804,28 @@ static uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev,
             	  haudio->rd_enable = 0U;
             	  haudio->rd_ptr = 0U;
             	  haudio->wr_ptr = 0U;
+            	  audio_idle = 0U;
+            	  idle_sofs = 0U;
+            	  /* The DMA may still run from the previous setting, play silence until the pre-roll */
+            	  memset(&haudio->out_buf, 0, sizeof(haudio->out_buf));
+            	  if (AUDIO_Latency_Load(haudio) != (uint8_t)USBD_OK)
+            	  {
+            	    USBD_CtlError(pdev, req);
+            	    ret = USBD_FAIL;
+            	    break;
+            	  }
+
+            	  /* The I2S always runs at USBD_AUDIO_FREQ, 44.1kHz goes through the SRC */
+            	  haudio->src_enable = (haudio->alt_setting == AUDIO_ALT_44K) ? 1U : 0U;
+            	  AUDIO_SRC_Reset(&haudio->src);
+            	  fb_nom = (haudio->src_enable != 0U) ? AUDIO_FB_44K : AUDIO_FB_DEFAULT;
+            	  fb_value = fb_nom;
 
             	  USBD_LL_FlushEP(pdev, AUDIO_IN_EP);
             	  USBD_LL_FlushEP(pdev, AUDIO_OUT_EP);
 
-            	  ((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->Init(USBD_AUDIO_FREQ,
-																  AUDIO_DEFAULT_VOLUME,
-																  0U);
+            	  /* The hardware layer is powered up from thread mode, well before the pre-roll is buffered */
+            	  EVENT_Post(EVENT_AUDIO_ALT);
 
             	  tx_flag = 0;
             	  all_ready = 1U;
@@ -612,6 +855,11 @@ static uint8_t USBD_AUDIO_Setup(USBD_HandleTypeDef *pdev,
           break;
       }
       break;
+
+    case USB_REQ_TYPE_VENDOR:
+      ret = (USBD_StatusTypeDef)AUDIO_VENDOR_Setup(pdev, req);
+      break;
+
     default:
       USBD_CtlError(pdev, req);
       ret = USBD_FAIL;
@@ -643,7 +891,7 @@ static uint8_t *USBD_AUDIO_GetCfgDesc(uint16_t *length)
   * @param  epnum: endpoint index
   * @retval status
   */
-static uint8_t USBD_AUDIO_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+RAM_ISR static uint8_t USBD_AUDIO_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
   /* epnum is the lowest 4 bits of bEndpointAddress. See UAC 1.0 spec, p.61 */
   if (epnum == (AUDIO_IN_EP & 0xf)) {
@@ -668,16 +916,20 @@ static uint8_t USBD_AUDIO_EP0_RxReady(USBD_HandleTypeDef *pdev)
     return (uint8_t)USBD_FAIL;
   }
 
-  if (haudio->control.cmd == AUDIO_REQ_SET_CUR)
+  if ((pdev->request.bmRequest & USB_REQ_TYPE_MASK) == USB_REQ_TYPE_VENDOR)
   {
-    /* In this driver, to simplify code, only SET_CUR request is managed */
-
-    if (haudio->control.unit == AUDIO_OUT_STREAMING_CTRL)
+    AUDIO_VENDOR_RxReady(pdev);
+  }
+  else if (haudio->control.cmd == AUDIO_REQ_SET_CUR)
+  {
+    if (fu_pending != NULL)
     {
-      ((USBD_AUDIO_ItfTypeDef *)pdev->pUserData)->MuteCtl(haudio->control.data[0]);
-      haudio->control.cmd = 0U;
-      haudio->control.len = 0U;
+      AUDIO_FU_Apply(pdev, fu_pending, haudio->control.data);
+      fu_pending = NULL;
     }
+
+    haudio->control.cmd = 0U;
+    haudio->control.len = 0U;
   }
 
   return (uint8_t)USBD_OK;
@@ -701,10 +953,72 @@ static uint8_t USBD_AUDIO_EP0_TxReady(USBD_HandleTypeDef *pdev)
   * @param  pdev: device instance
   * @retval status
   */
-static uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev)
+RAM_ISR static uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev)
+{
+  USBD_AUDIO_HandleTypeDef* haudio;
+  haudio = (USBD_AUDIO_HandleTypeDef*)pdev->pClassData;
+  PROFILE_BEGIN(PROFILE_SOF);
+
+  /* The host stopped streaming without leaving the alternate setting */
+  if (haudio->alt_setting != 0U && audio_idle == 0U)
+  {
+    idle_sofs++;
+
+    if (idle_sofs >= AUDIO_IDLE_TIMEOUT_MS)
+    {
+      AUDIO_Stream_Idle(pdev);
+    }
+  }
+
+  /* Do stuff only when playing */
+  if (haudio->rd_enable >= 1U && all_ready == 1U)
+  {
+    /* The feedback value itself is worked out at PendSV level */
+    if (fb_work_pending == 0U)
+    {
+      fb_work_pending = 1U;
+
+      if (WORK_Post(AUDIO_Feedback_Work, pdev) != HAL_OK)
+      {
+        fb_work_pending = 0U;
+        AUDIO_TLM_INC(work_dropped);
+      }
+    }
+
+    /* Transmit feedback only when the last one is transmitted */
+    if (tx_flag == 0U)
+    {
+      /* Get FNSOF. Use volatile for fnsof_new since its address is mapped to a hardware register. */
+      uint32_t volatile fnsof_new = AUDIO_USB_FNSOF();
+
+      if ((fnsof & 0x1) == (fnsof_new & 0x1))
+//      if (fnsof_new & 0x1)
+      {
+        USBD_LL_Transmit(pdev, AUDIO_IN_EP, (uint8_t*)fb_data, 3U);
+        /* Block transmission until it's finished. */
+        tx_flag = 1U;
+      }
+    }
+  }
+
+  PROFILE_END(PROFILE_SOF);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_Feedback_Work
+  *         Updates the feedback value from the buffer fill. Queued from the
+  *         SOF interrupt and run from PendSV, the SOF interrupt only sends it.
+  * @param  arg: device instance
+  * @retval None
+  */
+static void AUDIO_Feedback_Work(void *arg)
 {
+  USBD_HandleTypeDef *pdev = (USBD_HandleTypeDef *)arg;
   USBD_AUDIO_HandleTypeDef* haudio;
   haudio = (USBD_AUDIO_HandleTypeDef*)pdev->pClassData;
+  uint32_t primask;
 
   /**
    * 1. Must be static so that the values are kept when the function is
@@ -713,19 +1027,30 @@ static uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev)
    */
   static volatile uint32_t sof_count = 0;
 
+  fb_work_pending = 0U;
+
   /* Do stuff only when playing */
-  if (haudio->rd_enable >= 1U && all_ready == 1U)
+  if (haudio != NULL && haudio->rd_enable >= 1U && all_ready == 1U)
   {
     /* Remaining writable buffer size */
     uint32_t audio_buf_writable_size;
-
-    /* Update audio read pointer */
-    haudio->rd_ptr = AUDIO_TOTAL_BUF_SIZE - (LL_DMA_ReadReg(DMA1_Stream4, NDTR) & 0xFFFF);
+    /* Frames already drained into the DMA blocks but not played yet */
+    uint32_t pending;
 
     /* Calculate remaining writable buffer size */
     audio_buf_writable_size = haudio->rd_ptr < haudio->wr_ptr
-    						? (haudio->rd_ptr + AUDIO_TOTAL_BUF_SIZE - haudio->wr_ptr)/4
-							: (haudio->rd_ptr - haudio->wr_ptr)/4;
+                            ? (haudio->rd_ptr + haudio->ring_size - haudio->wr_ptr)/4
+                            : (haudio->rd_ptr - haudio->wr_ptr)/4;
+
+    /* The block being played has 1 to AUDIO_BLOCK_FRAMES frames left in it (on a block
+       boundary NDTR/2 is a whole block), the other one is full */
+    pending = (AUDIO_DMA_NDTR() / 2U + AUDIO_BLOCK_FRAMES - 1U) % AUDIO_BLOCK_FRAMES + 1U
+              + AUDIO_BLOCK_FRAMES;
+
+    /* Frames buffered between the host and the DAC */
+    AUDIO_TLM_Fill(haudio->ring_size / 4U - audio_buf_writable_size + pending,
+                   haudio->ring_size / 4U + 2U * AUDIO_BLOCK_FRAMES);
+    audio_buf_writable_size = (audio_buf_writable_size > pending) ? audio_buf_writable_size - pending : 0U;
 
 //    fb_value = AUDIO_FB_DEFAULT;
 //
@@ -738,130 +1063,150 @@ static uint8_t USBD_AUDIO_SOF(USBD_HandleTypeDef *pdev)
     if (sof_count == 1U)
     {
       sof_count = 0;
-      // we start transmitting to I2S DAC when the audio buffer is half full, so the optimal
-      // remaining writable size is (AUDIO_TOTAL_BUF_SIZE/2)/6 samples
-      // Calculate feedback value based on the deviation from optimal
-      int32_t audio_buf_writable_dev_from_nom_size = audio_buf_writable_size - AUDIO_TOTAL_BUF_SIZE/(5);
-      // The feedback is ideally the true Fs generated by the I2S PLL clock and dividers. Unfortunately we have no means
-      // to measure it internally. So we can only start with a nominal value calculated by assuming the HSE clock crystal
-      // has 0ppm accuracy, and calculate the Fs frequency generated by the PLLI2S N, R, I2SDIV and ODD register values.
-      // We then modify this nominal feedback frequency by the deviation from the ideal write pointer position wrt the read
-      // pointer over time.
-      // Need to multiply by at least a "PID k factor" of (1<<22) + 256 for a deviation of 1 sample to produce a change in feedback
-      // as the internal fb value = (10.14) shifted 8bits in uint32_t.
-      // We also should use the minimum "PID k factor" that keeps the write-pointer to read-pointer distance out of the
-      // danger zone. This is to minimize the distortion caused by changes in host sampling frequency Fs.
-      // uint64_t tmp = (uint64_t)((int32_t)(1<<22) + (audio_buf_writable_dev_from_nom_size * 256));
-      uint64_t tmp = (uint64_t)((int32_t)(1<<22) + (audio_buf_writable_dev_from_nom_size * 256));
-      uint64_t pid_k = ((uint64_t)fb_nom) * tmp;
-      fb_value = (uint32_t)(pid_k >> 22);
+      fb_value = AUDIO_Feedback_Calc(audio_buf_writable_size, haudio->fb_target, fb_nom, fb_gain);
 
       /* Check feedback max / min */
-      if (fb_value > fb_nom + AUDIO_FB_DELTA)
-        fb_value = fb_raw = fb_nom + AUDIO_FB_DELTA;
-      else if (fb_value < fb_nom - AUDIO_FB_DELTA)
-    	fb_value = fb_raw = fb_nom - AUDIO_FB_DELTA;
+      if (fb_value > fb_nom + fb_limit)
+        fb_value = fb_raw = fb_nom + fb_limit;
+      else if (fb_value < fb_nom - fb_limit)
+        fb_value = fb_raw = fb_nom - fb_limit;
+
+      AUDIO_TLM_Feedback(fb_value);
 
       /* Set 10.14 format feedback data */
-	  /**
-	   * Order of 3 bytes in feedback packet: { LO byte, MID byte, HI byte }
-	   *
-	   * For example,
-	   * 48.000(dec) => 300000(hex, 8.16) => 0C0000(hex, 10.14) => packet { 00, 00, 0C }
-	   *
-	   * Note that ALSA accepts 8.16 format.
-	   */
+      /**
+       * Order of 3 bytes in feedback packet: { LO byte, MID byte, HI byte }
+       *
+       * For example,
+       * 48.000(dec) => 300000(hex, 8.16) => 0C0000(hex, 10.14) => packet { 00, 00, 0C }
+       *
+       * Note that ALSA accepts 8.16 format.
+       */
+      /* The SOF interrupt may send fb_data at any time, never let it see half an update */
+      primask = __get_PRIMASK();
+      __disable_irq();
       fb_data[0] = (uint8_t)((fb_value >> 8) & 0x000000FF);
-	  fb_data[1] = (uint8_t)((fb_value >> 16) & 0x000000FF);
-	  fb_data[2] = (uint8_t)((fb_value >> 24) & 0x000000FF);
-	}
-    /* Transmit feedback only when the last one is transmitted */
-    if (tx_flag == 0U)
-    {
-      /* Get FNSOF. Use volatile for fnsof_new since its address is mapped to a hardware register. */
-      USB_OTG_GlobalTypeDef* USBx = USB_OTG_FS;
-      uint32_t USBx_BASE = (uint32_t)USBx;
-      uint32_t volatile fnsof_new = (USBx_DEVICE->DSTS & USB_OTG_DSTS_FNSOF) >> 8;
-
-      if ((fnsof & 0x1) == (fnsof_new & 0x1))
-//      if (fnsof_new & 0x1)
-      {
-        USBD_LL_Transmit(pdev, AUDIO_IN_EP, (uint8_t*)fb_data, 3U);
-        /* Block transmission until it's finished. */
-        tx_flag = 1U;
-      }
+      fb_data[1] = (uint8_t)((fb_value >> 16) & 0x000000FF);
+      fb_data[2] = (uint8_t)((fb_value >> 24) & 0x000000FF);
+      __set_PRIMASK(primask);
     }
   }
+}
 
-  return (uint8_t)USBD_OK;
+/**
+  * @brief  AUDIO_Feedback_Calc
+  *         Feedback value for a given writable size of the buffers.
+  * @param  writable: frames that can still be written, DMA blocks excluded, at most the ring
+  * @param  target: setpoint of writable, from the latency profile, at most the ring
+  * @param  nom: nominal feedback, 10.14 shifted left by 8
+  * @param  gain: change per frame of deviation in 1/2^22 of nom, AUDIO_FB_GAIN_MAX at most
+  * @retval feedback, 10.14 shifted left by 8, not limited to fb_limit yet
+  */
+uint32_t AUDIO_Feedback_Calc(uint32_t writable, uint32_t target, uint32_t nom, uint32_t gain)
+{
+  // Calculate feedback value based on the deviation from optimal.
+  // The two DMA blocks are counted as used, so the setpoint is what stays writable once
+  // the pre-roll of the latency profile is buffered, see AUDIO_Latency_Calc.
+  int32_t audio_buf_writable_dev_from_nom_size = (int32_t)writable - (int32_t)target;
+  // The feedback is ideally the true Fs generated by the I2S PLL clock and dividers. Unfortunately we have no means
+  // to measure it internally. So we can only start with a nominal value calculated by assuming the HSE clock crystal
+  // has 0ppm accuracy, and calculate the Fs frequency generated by the PLLI2S N, R, I2SDIV and ODD register values.
+  // We then modify this nominal feedback frequency by the deviation from the ideal write pointer position wrt the read
+  // pointer over time.
+  // Need to multiply by at least a "PID k factor" of (1<<22) + 256 for a deviation of 1 sample to produce a change in feedback
+  // (the default gain, the host can change it with AUDIO_VENDOR_REQ_SET_FB_CTRL)
+  // as the internal fb value = (10.14) shifted 8bits in uint32_t.
+  // We also should use the minimum "PID k factor" that keeps the write-pointer to read-pointer distance out of the
+  // danger zone. This is to minimize the distortion caused by changes in host sampling frequency Fs.
+  // At AUDIO_FB_GAIN_MAX a deviation of -64 frames already takes the whole of nom off, so the
+  // factor is worked out in 64 bits and kept from going negative; fb_limit clamps the result.
+  int64_t tmp = (int64_t)(1 << 22) + (int64_t)audio_buf_writable_dev_from_nom_size * (int64_t)gain;
+  uint64_t pid_k;
+
+  if (tmp < 0)
+  {
+    tmp = 0;
+  }
+  pid_k = ((uint64_t)nom * (uint64_t)tmp) >> 22;
+
+  return (pid_k > UINT32_MAX) ? UINT32_MAX : (uint32_t)pid_k;
 }
 
 /**
-  * @brief  USBD_AUDIO_SOF
-  *         handle SOF event
+  * @brief  USBD_AUDIO_Sync
+  *         Refills the DMA block that has just been played with the next
+  *         AUDIO_BLOCK_FRAMES frames of the ring and runs the DSP pipeline on
+  *         it. Called from the I2S DMA half/full transfer interrupts, so the
+  *         pipeline always sees whole blocks whatever the USB packet sizes are.
   * @param  pdev: device instance
-  * @retval status
+  * @param  offset: AUDIO_OFFSET_HALF refills the first block, AUDIO_OFFSET_FULL the second
+  * @retval None
   */
 void USBD_AUDIO_Sync(USBD_HandleTypeDef *pdev, AUDIO_OffsetTypeDef offset)
 {
-//  USBD_AUDIO_HandleTypeDef *haudio;
-//  uint32_t BufferSize = AUDIO_TOTAL_BUF_SIZE / 2U;
-//
-//  if (pdev->pClassData == NULL)
-//  {
-//    return;
-//  }
-//
-//  haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
-//
-//  haudio->offset = offset;
-//
-//  if (haudio->rd_enable == 1U)
-//  {
-//    haudio->rd_ptr += (uint16_t)BufferSize;
-//
-//    if (haudio->rd_ptr == AUDIO_TOTAL_BUF_SIZE)
-//    {
-//      /* roll back */
-//      haudio->rd_ptr = 0U;
-//    }
-//  }
-//
-//  if (haudio->rd_ptr > haudio->wr_ptr)
-//  {
-//    if ((haudio->rd_ptr - haudio->wr_ptr) < AUDIO_OUT_PACKET)
-//    {
-//      BufferSize += 4U;
-//    }
-//    else
-//    {
-//      if ((haudio->rd_ptr - haudio->wr_ptr) > (AUDIO_TOTAL_BUF_SIZE - AUDIO_OUT_PACKET))
-//      {
-//        BufferSize -= 4U;
-//      }
-//    }
-//  }
-//  else
-//  {
-//    if ((haudio->wr_ptr - haudio->rd_ptr) < AUDIO_OUT_PACKET)
-//    {
-//      BufferSize -= 4U;
-//    }
-//    else
-//    {
-//      if ((haudio->wr_ptr - haudio->rd_ptr) > (AUDIO_TOTAL_BUF_SIZE - AUDIO_OUT_PACKET))
-//      {
-//        BufferSize += 4U;
-//      }
-//    }
-//  }
-//
-//  if (haudio->offset == AUDIO_OFFSET_FULL)
-//  {
-//    ((USBD_AUDIO_ItfTypeDef *)pdev->pUserData)->AudioCmd(&haudio->buffer[0],
-//                                                         BufferSize, AUDIO_CMD_PLAY);
-//    haudio->offset = AUDIO_OFFSET_NONE;
-//  }
+  USBD_AUDIO_HandleTypeDef *haudio;
+  uint32_t *dst;
+
+  if (pdev->pClassData == NULL)
+  {
+    return;
+  }
+
+  haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
+  dst = (offset == AUDIO_OFFSET_HALF) ? &haudio->out_buf[0] : &haudio->out_buf[AUDIO_BLOCK_FRAMES];
+
+  AUDIO_Block_Fill(haudio, dst);
+}
+
+/**
+  * @brief  AUDIO_Block_Fill
+  *         Moves one block from the ring to the DMA buffer and processes it.
+  *         Whatever the ring cannot supply is played as silence.
+  * @param  haudio: audio class handle
+  * @param  dst: AUDIO_BLOCK_FRAMES frames
+  * @retval None
+  */
+RAM_ISR static void AUDIO_Block_Fill(USBD_AUDIO_HandleTypeDef *haudio, uint32_t *dst)
+{
+  uint32_t avail = 0U;
+  uint32_t i;
+
+  if (haudio->rd_enable != 0U && all_ready == 1U)
+  {
+    avail = (haudio->wr_ptr >= haudio->rd_ptr)
+          ? (haudio->wr_ptr - haudio->rd_ptr) / 4U
+          : (haudio->wr_ptr + haudio->ring_size - haudio->rd_ptr) / 4U;
+  }
+
+  if (avail > AUDIO_BLOCK_FRAMES)
+  {
+    avail = AUDIO_BLOCK_FRAMES;
+  }
+
+  for (i = 0U; i < avail; i++)
+  {
+    dst[i] = *(uint32_t *)&haudio->buffer[haudio->rd_ptr];
+    haudio->rd_ptr += 4U;
+
+    if (haudio->rd_ptr >= haudio->ring_size)
+    {
+      haudio->rd_ptr = 0U;
+    }
+  }
+
+  if (avail < AUDIO_BLOCK_FRAMES && haudio->rd_enable != 0U && all_ready == 1U)
+  {
+    AUDIO_TLM_INC(underruns);
+    AUDIO_TLM_Add(&AUDIO_Tlm.underrun_frames, AUDIO_BLOCK_FRAMES - avail);
+  }
+
+  for (; i < AUDIO_BLOCK_FRAMES; i++)
+  {
+    dst[i] = 0U;
+  }
+
+  /* Channel stage, meters, ...: see usbd_audio_dsp.c */
+  AUDIO_DSP_Process(dst, AUDIO_BLOCK_FRAMES);
 }
 
 /**
@@ -871,11 +1216,11 @@ void USBD_AUDIO_Sync(USBD_HandleTypeDef *pdev, AUDIO_OffsetTypeDef offset)
   * @param  epnum: endpoint index
   * @retval status
   */
-static uint8_t USBD_AUDIO_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
+RAM_ISR static uint8_t USBD_AUDIO_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
-  USB_OTG_GlobalTypeDef* USBx = USB_OTG_FS;
-  uint32_t USBx_BASE = (uint32_t)USBx;
-  fnsof = (USBx_DEVICE->DSTS & USB_OTG_DSTS_FNSOF) >> 8;
+  fnsof = AUDIO_USB_FNSOF();
+
+  AUDIO_TLM_INC(iso_in_incomplete);
 
   if (tx_flag == 1U) {
 	tx_flag = 0U;
@@ -891,17 +1236,21 @@ static uint8_t USBD_AUDIO_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnu
   * @param  epnum: endpoint index
   * @retval status
   */
-static uint8_t USBD_AUDIO_IsoOutIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
+RAM_ISR static uint8_t USBD_AUDIO_IsoOutIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
   UNUSED(epnum);
 
-  USBD_AUDIO_HandleTypeDef *haudio;
-  haudio = (USBD_AUDIO_HandleTypeDef*)pdev->pClassData;
+  if (pdev->pClassData == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  AUDIO_TLM_INC(iso_out_incomplete);
 
   USBD_LL_FlushEP(pdev, AUDIO_OUT_EP);
 
   /* Prepare Out endpoint to receive next audio packet */
-  (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, (uint8_t *)&haudio->buffer[haudio->wr_ptr], AUDIO_OUT_PACKET);
+  (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, (uint8_t *)AUDIO_RxSlot[rx_slot].buf, AUDIO_OUT_PACKET);
 
   return (uint8_t)USBD_OK;
 }
@@ -912,125 +1261,895 @@ static uint8_t USBD_AUDIO_IsoOutIncomplete(USBD_HandleTypeDef *pdev, uint8_t epn
   * @param  epnum: endpoint index
   * @retval status
   */
-static uint8_t USBD_AUDIO_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+RAM_ISR static uint8_t USBD_AUDIO_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
 {
-  uint16_t PacketSize;
   USBD_AUDIO_HandleTypeDef *haudio;
+  AUDIO_RxSlotTypeDef *slot;
 
   haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
 
-  static uint8_t tmpbuf[1024];
-
   if (haudio == NULL)
   {
     return (uint8_t)USBD_FAIL;
   }
 
+  PROFILE_BEGIN(PROFILE_DATAOUT);
+
   if (epnum == AUDIO_OUT_EP && all_ready == 1U)
   {
-    /* Get received data packet length */
-    PacketSize = (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum);
-
-	// Ignore strangely large packets
-	if (PacketSize > AUDIO_OUT_PACKET)
-	{
-		PacketSize = 0U;
-	}
-
-	uint32_t tmpbuf_ptr = 0U;
-	uint32_t num_samples = PacketSize / 4; // 2bytes per sample
-
-	for (int i = 0; i < num_samples; i++)
-	{
-		haudio->buffer[haudio->wr_ptr++] = tmpbuf[tmpbuf_ptr]; // lsb
-		haudio->buffer[haudio->wr_ptr++] = tmpbuf[tmpbuf_ptr+1];
-		haudio->buffer[haudio->wr_ptr++] = tmpbuf[tmpbuf_ptr+2]; // msb
-		haudio->buffer[haudio->wr_ptr++] = tmpbuf[tmpbuf_ptr+3];
-
-		tmpbuf_ptr += 4;
-
-		if (haudio->wr_ptr >= AUDIO_TOTAL_BUF_SIZE) {
-			haudio->wr_ptr = 0U;
-		}
-	}
-
-	if (haudio->offset == AUDIO_OFFSET_UNKNOWN && is_playing == 0U)
-	{
-		if (haudio->wr_ptr >= AUDIO_TOTAL_BUF_SIZE / 2U)
-		{
-			haudio->offset = AUDIO_OFFSET_NONE;
-			is_playing = 1U;
-
-			if (haudio->rd_enable == 0U) {
-				haudio->rd_enable = 1U;
-				// Set last writable buffer size to actual value. Note that rd_ptr is 0 now.
-//				audio_buf_writable_samples_last = (AUDIO_TOTAL_BUF_SIZE - haudio->wr_ptr)/4;
-				((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->AudioCmd(&haudio->buffer[0],
-																	AUDIO_TOTAL_BUF_SIZE / 2,
-																	AUDIO_CMD_START);
-			}
-		}
-	}
-
-
-    /* Prepare Out endpoint to receive next audio packet */
-    (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, tmpbuf, AUDIO_OUT_PACKET);
+    idle_sofs = 0U;
+
+    /* First packet after an idle timeout or a suspend: power the hardware up again */
+    if (audio_idle != 0U)
+    {
+      audio_idle = 0U;
+      EVENT_Post(EVENT_AUDIO_ALT);
+    }
+
+    slot = &AUDIO_RxSlot[rx_slot];
+
+    /* PendSV is still converting the packet in the other slot: drop this one and
+       receive the next packet into the same slot */
+    if (AUDIO_RxSlot[rx_slot ^ 1U].busy != 0U)
+    {
+      AUDIO_TLM_INC(rx_busy);
+      (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, (uint8_t *)slot->buf, AUDIO_OUT_PACKET);
+    }
+    else
+    {
+      /* Get received data packet length */
+      slot->len = (uint16_t)USBD_LL_GetRxDataSize(pdev, epnum);
+      slot->pdev = pdev;
+      slot->busy = 1U;
+
+      /* Receive the next packet in the other slot and leave this one to PendSV */
+      rx_slot ^= 1U;
+      (void)USBD_LL_PrepareReceive(pdev, AUDIO_OUT_EP, (uint8_t *)AUDIO_RxSlot[rx_slot].buf, AUDIO_OUT_PACKET);
+
+      if (WORK_Post(AUDIO_Packet_Work, slot) != HAL_OK)
+      {
+        slot->busy = 0U;
+        AUDIO_TLM_INC(work_dropped);
+      }
+    }
   }
 
+  PROFILE_END(PROFILE_DATAOUT);
+
   return (uint8_t)USBD_OK;
 }
 
 /**
-  * @brief  AUDIO_Req_GetCurrent
-  *         Handles the GET_CUR Audio control request.
-  * @param  pdev: instance
-  * @param  req: setup class request
-  * @retval status
+  * @brief  AUDIO_Packet_Work
+  *         Converts a received OUT packet and appends it to the ring, and
+  *         starts the I2S once the pre-roll is buffered. Queued from DataOut
+  *         and run from PendSV, the slot stays busy until it returns.
+  * @param  arg: receive slot
+  * @retval None
   */
-static void AUDIO_REQ_GetCurrent(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+static void AUDIO_Packet_Work(void *arg)
 {
+  AUDIO_RxSlotTypeDef *slot = (AUDIO_RxSlotTypeDef *)arg;
+  USBD_HandleTypeDef *pdev = slot->pdev;
   USBD_AUDIO_HandleTypeDef *haudio;
+  uint16_t PacketSize = slot->len;
+  uint32_t wr_ptr;
+  uint32_t primask;
+  uint8_t start = 0U;
+
+  static uint32_t srcbuf[AUDIO_SRC_OUT_FRAMES(AUDIO_OUT_PACKET / 4U)];
+
   haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
 
-  if (haudio == NULL)
+  if (haudio == NULL || all_ready == 0U)
   {
+    slot->busy = 0U;
     return;
   }
 
-  (void)USBD_memset(haudio->control.data, 0, 64U);
+  // Ignore strangely large packets
+  if (PacketSize > AUDIO_OUT_PACKET)
+  {
+    PacketSize = 0U;
+    AUDIO_TLM_INC(oversize);
+  }
+
+  uint32_t *src = slot->buf;
+  uint32_t num_samples = PacketSize / 4; // 2bytes per sample
+
+  if (haudio->src_enable != 0U)
+  {
+    /* 44.1kHz stream: everything past this point sees 48kHz frames */
+    num_samples = AUDIO_SRC_Process(&haudio->src, src, num_samples, srcbuf);
+    src = srcbuf;
+  }
+
+  /* The DMA interrupt reads up to wr_ptr, so it is only moved once the frames are in */
+  wr_ptr = haudio->wr_ptr;
+
+  /* Keep one frame free so that a full ring is not taken for an empty one. rd_ptr only moves
+     forward meanwhile, so the space can only be underestimated */
+  if (num_samples > (haudio->rd_ptr + haudio->ring_size - wr_ptr - 4U) % haudio->ring_size / 4U)
+  {
+    num_samples = 0U;
+    AUDIO_TLM_INC(overruns);
+  }
+
+  wr_ptr = AUDIO_Ring_Write(haudio->buffer, haudio->ring_size, wr_ptr, src, num_samples);
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  /* Dropped if the alternate setting changed while the packet was being converted */
+  if (all_ready == 1U)
+  {
+    haudio->wr_ptr = (uint16_t)wr_ptr;
+
+    if (haudio->offset == AUDIO_OFFSET_UNKNOWN && is_playing == 0U)
+    {
+      /* The I2S is powered up from thread mode, wait for it if the pre-roll came first */
+      if (haudio->wr_ptr >= haudio->start_size &&
+          ((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->GetState() == 0)
+      {
+        haudio->offset = AUDIO_OFFSET_NONE;
+        is_playing = 1U;
+
+        if (haudio->rd_enable == 0U)
+        {
+          haudio->rd_enable = 1U;
+          start = 1U;
+        }
+      }
+    }
+  }
+
+  __set_PRIMASK(primask);
+
+  /* Only the pointers are published with the interrupts off, the DSP runs on the two blocks
+     below. A DMA still running from the previous alternate setting refills them itself from
+     the next half transfer on; otherwise no DMA interrupt can come before the start */
+  if (start != 0U && AUDIO_DMA_RUNNING() == 0U)
+  {
+    /* Prime both blocks; from here on the DMA interrupts keep them filled */
+    AUDIO_Block_Fill(haudio, &haudio->out_buf[0]);
+    AUDIO_Block_Fill(haudio, &haudio->out_buf[AUDIO_BLOCK_FRAMES]);
+
+    /* Not if SET_INTERFACE reset the stream meanwhile, the next pre-roll starts it */
+    if (haudio->rd_enable != 0U && all_ready == 1U)
+    {
+      ((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->AudioCmd((uint8_t *)haudio->out_buf,
+                                                          sizeof(haudio->out_buf) / 2U,
+                                                          AUDIO_CMD_START);
+      AUDIO_TLM_Stamp(&AUDIO_Tlm.boot_audio_us);
+    }
+  }
+
+  /* DataOut may receive into this slot again */
+  slot->busy = 0U;
+}
+
+/**
+  * @brief  AUDIO_Ring_Write
+  *         Copies frames into the playback ring, wrapping at its end.
+  * @param  ring: ring buffer
+  * @param  size: ring size in bytes
+  * @param  wr_ptr: byte offset of the first frame
+  * @param  src: frames
+  * @param  count: number of frames
+  * @retval byte offset following the last frame
+  */
+RAM_ISR uint32_t AUDIO_Ring_Write(uint8_t *ring, uint32_t size, uint32_t wr_ptr, const uint32_t *src, uint32_t count)
+{
+  for (uint32_t i = 0U; i < count; i++)
+  {
+    *(uint32_t *)&ring[wr_ptr] = src[i];
+    wr_ptr += 4U;
+
+    if (wr_ptr >= size)
+    {
+      wr_ptr = 0U;
+    }
+  }
 
-  /* Send the current mute state */
-  (void)USBD_CtlSendData(pdev, haudio->control.data, req->wLength);
+  return wr_ptr;
 }
 
 /**
-  * @brief  AUDIO_Req_SetCurrent
-  *         Handles the SET_CUR Audio control request.
+  * @brief  AUDIO_REQ_FeatureUnit
+  *         Handles GET_CUR/MIN/MAX/RES and SET_CUR on the Feature Unit. The
+  *         control is looked up by unit, selector and channel, GET data is sent
+  *         from the table and SET_CUR data is applied by AUDIO_FU_Apply.
   * @param  pdev: instance
   * @param  req: setup class request
   * @retval status
   */
-static void AUDIO_REQ_SetCurrent(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+static uint8_t AUDIO_REQ_FeatureUnit(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
 {
   USBD_AUDIO_HandleTypeDef *haudio;
   haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
+  AUDIO_FU_ControlTypeDef *ctrl = NULL;
+  uint8_t *data = NULL;
 
-  if (haudio == NULL)
+  for (uint32_t i = 0U; i < (sizeof(AUDIO_FU_Controls) / sizeof(AUDIO_FU_Controls[0])); i++)
   {
-    return;
+    if (AUDIO_FU_Controls[i].unit == HIBYTE(req->wIndex) &&
+        AUDIO_FU_Controls[i].selector == HIBYTE(req->wValue) &&
+        AUDIO_FU_Controls[i].channel == LOBYTE(req->wValue))
+    {
+      ctrl = &AUDIO_FU_Controls[i];
+      break;
+    }
   }
 
-  if (req->wLength != 0U)
+  if (ctrl != NULL)
   {
-    /* Prepare the reception of the buffer over EP0 */
-    (void)USBD_CtlPrepareRx(pdev, haudio->control.data, req->wLength);
+    switch (req->bRequest)
+    {
+      case AUDIO_REQ_GET_CUR:
+        data = ctrl->cur;
+        break;
+
+      case AUDIO_REQ_GET_MIN:
+        data = (ctrl->ranged != 0U) ? ctrl->min : NULL;
+        break;
+
+      case AUDIO_REQ_GET_MAX:
+        data = (ctrl->ranged != 0U) ? ctrl->max : NULL;
+        break;
+
+      case AUDIO_REQ_GET_RES:
+        data = (ctrl->ranged != 0U) ? ctrl->res : NULL;
+        break;
+
+      case AUDIO_REQ_SET_CUR:
+        if (req->wLength == ctrl->size)
+        {
+          /* Prepare the reception of the buffer over EP0 */
+          (void)USBD_CtlPrepareRx(pdev, haudio->control.data, req->wLength);
+
+          haudio->control.cmd = AUDIO_REQ_SET_CUR;     /* Set the request value */
+          haudio->control.len = (uint8_t)req->wLength; /* Set the request data length */
+          haudio->control.unit = HIBYTE(req->wIndex);  /* Set the request target unit */
+          fu_pending = ctrl;
+
+          return (uint8_t)USBD_OK;
+        }
+        break;
+
+      default:
+        break;
+    }
+  }
 
-    haudio->control.cmd = AUDIO_REQ_SET_CUR;     /* Set the request value */
-    haudio->control.len = (uint8_t)req->wLength; /* Set the request data length */
-    haudio->control.unit = HIBYTE(req->wIndex);  /* Set the request target unit */
+  if (data == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return (uint8_t)USBD_FAIL;
   }
-}
 
+  (void)USBD_CtlSendData(pdev, data, MIN(req->wLength, ctrl->size));
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_FU_Apply
+  *         Stores the SET_CUR value of a feature unit control, formatted for
+  *         GET_CUR, and passes mute and volume to the DSP pipeline and the
+  *         interface.
+  * @param  pdev: instance
+  * @param  ctrl: control
+  * @param  data: SET_CUR parameter block
+  * @retval None
+  */
+static void AUDIO_FU_Apply(USBD_HandleTypeDef *pdev, AUDIO_FU_ControlTypeDef *ctrl, const uint8_t *data)
+{
+  USBD_AUDIO_ItfTypeDef *fops = (USBD_AUDIO_ItfTypeDef *)pdev->pUserData;
+  int32_t volume;
+  uint8_t mute;
+
+  if (ctrl->selector == AUDIO_FU_MUTE_CONTROL)
+  {
+    ctrl->cur[0] = (data[0] != 0U) ? 1U : 0U;
+  }
+  else
+  {
+    volume = (int16_t)((uint16_t)data[0] | ((uint16_t)data[1] << 8));
+    volume = MAX(volume, AUDIO_VOLUME_MIN);
+    volume = MIN(volume, AUDIO_VOLUME_MAX);
+    /* Round down to a whole step, GET_CUR returns the value actually used */
+    volume = AUDIO_VOLUME_MAX - (((AUDIO_VOLUME_MAX - volume) + AUDIO_VOLUME_RES - 1) / AUDIO_VOLUME_RES) * AUDIO_VOLUME_RES;
+    ctrl->cur[0] = LOBYTE(volume);
+    ctrl->cur[1] = HIBYTE(volume);
+  }
+
+  mute = AUDIO_FU_Controls[0].cur[0];
+  volume = (int16_t)((uint16_t)AUDIO_FU_Controls[1].cur[0] | ((uint16_t)AUDIO_FU_Controls[1].cur[1] << 8));
+
+  AUDIO_DSP_Volume_Set((int16_t)volume, mute);
+
+  if (ctrl->selector == AUDIO_FU_MUTE_CONTROL)
+  {
+    fops->MuteCtl(mute);
+  }
+  else
+  {
+    /* The interface takes 0..100 */
+    fops->VolumeCtl((uint8_t)(((volume - AUDIO_VOLUME_MIN) * 100) / (AUDIO_VOLUME_MAX - AUDIO_VOLUME_MIN)));
+  }
+}
+
+/**
+  * @brief  AUDIO_FU_Reset
+  *         Unmuted, 0dB. The DSP pipeline starts from the same defaults.
+  * @retval None
+  */
+static void AUDIO_FU_Reset(void)
+{
+  AUDIO_FU_Controls[0].cur[0] = 0U;
+  AUDIO_FU_Controls[1].cur[0] = LOBYTE(AUDIO_VOLUME_MAX);
+  AUDIO_FU_Controls[1].cur[1] = HIBYTE(AUDIO_VOLUME_MAX);
+  fu_pending = NULL;
+}
+
+
+/**
+  * @brief  AUDIO_REQ_GetMeter
+  *         Handles the GET_MEM request on the Feature Unit: returns the
+  *         level meters latched over the last AUDIO_METER_WINDOW frames as
+  *         { peak L, peak R, RMS L, RMS R }, 16-bit little endian, 32767 = 0dBFS.
+  * @param  pdev: instance
+  * @param  req: setup class request
+  * @retval None
+  */
+static void AUDIO_REQ_GetMeter(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_AUDIO_HandleTypeDef *haudio;
+  haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
+  uint16_t peak[2];
+  uint16_t rms[2];
+
+  if (haudio == NULL)
+  {
+    return;
+  }
+
+  AUDIO_DSP_Meter_Read(peak, rms);
+
+  haudio->control.data[0] = LOBYTE(peak[0]);
+  haudio->control.data[1] = HIBYTE(peak[0]);
+  haudio->control.data[2] = LOBYTE(peak[1]);
+  haudio->control.data[3] = HIBYTE(peak[1]);
+  haudio->control.data[4] = LOBYTE(rms[0]);
+  haudio->control.data[5] = HIBYTE(rms[0]);
+  haudio->control.data[6] = LOBYTE(rms[1]);
+  haudio->control.data[7] = HIBYTE(rms[1]);
+
+  (void)USBD_CtlSendData(pdev, haudio->control.data,
+                         MIN(req->wLength, AUDIO_METER_DATA_SIZE));
+}
+
+/**
+  * @brief  AUDIO_VENDOR_Setup
+  *         Dispatches a vendor request through AUDIO_VENDOR_Table. IN data is
+  *         sent at once, OUT data is only stored: AUDIO_VENDOR_Event applies it
+  *         from thread mode, so nothing here waits on the data path.
+  * @param  pdev: instance
+  * @param  req: setup vendor request
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  const AUDIO_VENDOR_EntryTypeDef *entry = NULL;
+
+  for (uint32_t i = 0U; i < (sizeof(AUDIO_VENDOR_Table) / sizeof(AUDIO_VENDOR_Table[0])); i++)
+  {
+    if (AUDIO_VENDOR_Table[i].request == req->bRequest)
+    {
+      entry = &AUDIO_VENDOR_Table[i];
+      break;
+    }
+  }
+
+  if (entry == NULL || entry->size > AUDIO_VENDOR_BUF_SIZE)
+  {
+    USBD_CtlError(pdev, req);
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if ((req->bmRequest & 0x80U) != 0U)
+  {
+    if (entry->Get == NULL || entry->Get(req->wValue, (uint8_t *)AUDIO_VENDOR_Buf) != (uint8_t)USBD_OK)
+    {
+      USBD_CtlError(pdev, req);
+      return (uint8_t)USBD_FAIL;
+    }
+
+    /* Larger than EP0: the core sends the rest with USBD_CtlContinueSendData */
+    (void)USBD_CtlSendData(pdev, (uint8_t *)AUDIO_VENDOR_Buf, MIN(req->wLength, entry->size));
+    return (uint8_t)USBD_OK;
+  }
+
+  /* A request still waiting for thread mode is not overwritten, the host retries after the STALL */
+  if (entry->Set == NULL || req->wLength != entry->size || AUDIO_VENDOR_Pending.state == AUDIO_VENDOR_QUEUED)
+  {
+    USBD_CtlError(pdev, req);
+    return (uint8_t)USBD_FAIL;
+  }
+
+  AUDIO_VENDOR_Pending.entry = entry;
+  AUDIO_VENDOR_Pending.value = req->wValue;
+
+  if (entry->size == 0U)
+  {
+    AUDIO_VENDOR_Pending.state = AUDIO_VENDOR_QUEUED;
+    EVENT_Post(EVENT_AUDIO_VENDOR);
+    (void)USBD_CtlSendStatus(pdev);
+  }
+  else
+  {
+    /* Larger than EP0: the core takes the rest with USBD_CtlContinueRx, then calls EP0_RxReady */
+    AUDIO_VENDOR_Pending.state = AUDIO_VENDOR_RX;
+    (void)USBD_CtlPrepareRx(pdev, (uint8_t *)AUDIO_VENDOR_Pending.data, entry->size);
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_RxReady
+  *         Takes the data stage of a vendor OUT request and hands it over to
+  *         AUDIO_VENDOR_Event.
+  * @param  pdev: instance
+  * @retval None
+  */
+static void AUDIO_VENDOR_RxReady(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+
+  if (AUDIO_VENDOR_Pending.state == AUDIO_VENDOR_RX)
+  {
+    AUDIO_VENDOR_Pending.state = AUDIO_VENDOR_QUEUED;
+    EVENT_Post(EVENT_AUDIO_VENDOR);
+  }
+}
+
+/**
+  * @brief  AUDIO_VENDOR_Event
+  *         Applies the queued vendor OUT request. The OUT packets are written
+  *         from PendSV and the DSP pipeline runs from the DMA interrupt, so the
+  *         change is made with interrupts masked and always lands between two
+  *         packets and two blocks.
+  * @param  ctx: device instance
+  * @retval None
+  */
+static void AUDIO_VENDOR_Event(void *ctx)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  UNUSED(ctx);
+
+  __disable_irq();
+
+  if (AUDIO_VENDOR_Pending.state == AUDIO_VENDOR_QUEUED)
+  {
+    AUDIO_VENDOR_Pending.entry->Set(AUDIO_VENDOR_Pending.value, (const uint8_t *)AUDIO_VENDOR_Pending.data);
+    AUDIO_VENDOR_Pending.state = AUDIO_VENDOR_IDLE;
+  }
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  AUDIO_VENDOR_Put32
+  *         Stores a 32-bit value little endian.
+  * @param  dst: destination
+  * @param  value: value
+  * @retval None
+  */
+static void AUDIO_VENDOR_Put32(uint8_t *dst, uint32_t value)
+{
+  dst[0] = (uint8_t)value;
+  dst[1] = (uint8_t)(value >> 8);
+  dst[2] = (uint8_t)(value >> 16);
+  dst[3] = (uint8_t)(value >> 24);
+}
+
+/**
+  * @brief  AUDIO_VENDOR_Get32
+  *         Loads a 32-bit little endian value.
+  * @param  src: source
+  * @retval value
+  */
+static uint32_t AUDIO_VENDOR_Get32(const uint8_t *src)
+{
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) | ((uint32_t)src[2] << 16) | ((uint32_t)src[3] << 24);
+}
+
+/**
+  * @brief  AUDIO_VENDOR_GetProc
+  *         GET_PROC: channel stage flags and balance.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_PROC_DATA_SIZE bytes
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetProc(uint16_t value, uint8_t *buf)
+{
+  uint8_t flags;
+  int8_t balance;
+
+  UNUSED(value);
+
+  AUDIO_DSP_Channel_Get(&flags, &balance);
+  buf[0] = flags;
+  buf[1] = (uint8_t)balance;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_SetProc
+  *         SET_PROC: channel stage flags and balance.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_PROC_DATA_SIZE bytes
+  * @retval None
+  */
+static void AUDIO_VENDOR_SetProc(uint16_t value, const uint8_t *buf)
+{
+  UNUSED(value);
+
+  AUDIO_DSP_Channel_Set(buf[0], (int8_t)buf[1]);
+}
+
+/**
+  * @brief  AUDIO_VENDOR_GetDsp
+  *         GET_DSP: stage enable mask.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_DSP_DATA_SIZE bytes
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetDsp(uint16_t value, uint8_t *buf)
+{
+  UNUSED(value);
+
+  AUDIO_VENDOR_Put32(buf, AUDIO_DSP_GetEnable());
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_SetDsp
+  *         SET_DSP: stage enable mask.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_DSP_DATA_SIZE bytes
+  * @retval None
+  */
+static void AUDIO_VENDOR_SetDsp(uint16_t value, const uint8_t *buf)
+{
+  UNUSED(value);
+
+  AUDIO_DSP_SetEnable(AUDIO_VENDOR_Get32(buf));
+}
+
+/**
+  * @brief  AUDIO_VENDOR_GetDspStats
+  *         GET_DSP_STATS: cycle counts of each stage.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_DSP_STATS_SIZE bytes
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetDspStats(uint16_t value, uint8_t *buf)
+{
+  const AUDIO_DSP_StatsTypeDef *stats = AUDIO_DSP_GetStats();
+
+  UNUSED(value);
+
+  for (uint32_t i = 0U; i < AUDIO_DSP_STAGE_NUM; i++)
+  {
+    AUDIO_VENDOR_Put32(&buf[i * 8U], stats[i].cycles_last);
+    AUDIO_VENDOR_Put32(&buf[i * 8U + 4U], stats[i].cycles_max);
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_GetTelemetry
+  *         GET_TELEMETRY: snapshot of the streaming counters.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_TLM_TypeDef, 32-bit aligned
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetTelemetry(uint16_t value, uint8_t *buf)
+{
+  UNUSED(value);
+
+  AUDIO_TLM_Read((AUDIO_TLM_TypeDef *)(void *)buf);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_ResetTelemetry
+  *         RESET_TELEMETRY, no data.
+  * @param  value: wValue, unused
+  * @param  buf: unused
+  * @retval None
+  */
+static void AUDIO_VENDOR_ResetTelemetry(uint16_t value, const uint8_t *buf)
+{
+  UNUSED(value);
+  UNUSED(buf);
+
+  AUDIO_TLM_Reset();
+}
+
+/**
+  * @brief  AUDIO_VENDOR_GetFbCtrl
+  *         GET_FB_CTRL: feedback controller gain and limit.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_FB_CTRL_SIZE bytes
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetFbCtrl(uint16_t value, uint8_t *buf)
+{
+  UNUSED(value);
+
+  AUDIO_VENDOR_Put32(&buf[0], fb_gain);
+  AUDIO_VENDOR_Put32(&buf[4], fb_limit);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_SetFbCtrl
+  *         SET_FB_CTRL: feedback controller gain and limit, clamped to
+  *         AUDIO_FB_GAIN_MAX and AUDIO_FB_LIMIT_MAX. A zero gain restores the default.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_FB_CTRL_SIZE bytes
+  * @retval None
+  */
+static void AUDIO_VENDOR_SetFbCtrl(uint16_t value, const uint8_t *buf)
+{
+  uint32_t gain = AUDIO_VENDOR_Get32(&buf[0]);
+  uint32_t limit = AUDIO_VENDOR_Get32(&buf[4]);
+
+  UNUSED(value);
+
+  fb_gain = (gain == 0U) ? AUDIO_FB_GAIN_DEFAULT : MIN(gain, AUDIO_FB_GAIN_MAX);
+  fb_limit = MIN(limit, AUDIO_FB_LIMIT_MAX);
+}
+
+/**
+  * @brief  AUDIO_VENDOR_GetLatency
+  *         GET_LATENCY: selected profile and the one the stream uses.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_VENDOR_LATENCY_SIZE bytes
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetLatency(uint16_t value, uint8_t *buf)
+{
+  AUDIO_LatencyTypeDef lat;
+
+  UNUSED(value);
+
+  AUDIO_Latency_Calc(latency_active, USBD_AUDIO_FREQ, AUDIO_FRAME_SIZE, &lat);
+
+  buf[0] = latency_sel;
+  buf[1] = latency_active;
+  buf[2] = LOBYTE(lat.ring_size / AUDIO_FRAME_SIZE);
+  buf[3] = HIBYTE(lat.ring_size / AUDIO_FRAME_SIZE);
+  buf[4] = LOBYTE(lat.start_size / AUDIO_FRAME_SIZE);
+  buf[5] = HIBYTE(lat.start_size / AUDIO_FRAME_SIZE);
+  buf[6] = LOBYTE(lat.fb_target);
+  buf[7] = HIBYTE(lat.fb_target);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_SetLatency
+  *         SET_LATENCY: selects the profile of the next stream. An unknown
+  *         index is ignored.
+  * @param  value: wValue, unused
+  * @param  buf: AUDIO_LATENCY_xxx
+  * @retval None
+  */
+static void AUDIO_VENDOR_SetLatency(uint16_t value, const uint8_t *buf)
+{
+  UNUSED(value);
+
+  if (buf[0] < AUDIO_LATENCY_NUM)
+  {
+    latency_sel = buf[0];
+  }
+}
+
+#if (USE_AUDIO_BENCH == 1U)
+/**
+  * @brief  AUDIO_VENDOR_GetBench
+  *         GET_BENCH: results of the data path benchmark.
+  * @param  value: AUDIO_BENCH_ART_xxx
+  * @param  buf: AUDIO_VENDOR_BENCH_SIZE bytes
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetBench(uint16_t value, uint8_t *buf)
+{
+  const AUDIO_BENCH_ResultTypeDef *res = AUDIO_BENCH_Get(value);
+
+  if (res == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  (void)USBD_memcpy(buf, res, AUDIO_VENDOR_BENCH_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+#endif /* USE_AUDIO_BENCH */
+
+#if (USE_ISR_PROFILE == 1U)
+/**
+  * @brief  AUDIO_VENDOR_GetProfile
+  *         GET_PROFILE: report of the handler selected by wValue.
+  * @param  value: PROFILE_IdTypeDef
+  * @param  buf: PROFILE_ReportTypeDef, 32-bit aligned
+  * @retval status
+  */
+static uint8_t AUDIO_VENDOR_GetProfile(uint16_t value, uint8_t *buf)
+{
+  if (value >= (uint16_t)PROFILE_NUM)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  PROFILE_Read((PROFILE_IdTypeDef)value, (PROFILE_ReportTypeDef *)(void *)buf);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_VENDOR_ResetProfile
+  *         RESET_PROFILE, no data.
+  * @param  value: wValue, unused
+  * @param  buf: unused
+  * @retval None
+  */
+static void AUDIO_VENDOR_ResetProfile(uint16_t value, const uint8_t *buf)
+{
+  UNUSED(value);
+  UNUSED(buf);
+
+  PROFILE_Reset();
+}
+#endif /* USE_ISR_PROFILE */
+
+/**
+  * @brief  AUDIO_Latency_Calc
+  *         Ring layout of a latency profile. The ring holds twice the pre-roll,
+  *         and the feedback keeps the pre-roll buffered between the host and the
+  *         DAC once playing, so the profile latency is also the running one.
+  * @param  profile: AUDIO_LATENCY_xxx
+  * @param  freq: rate the ring is filled at, in Hz
+  * @param  frame_size: bytes per frame in the ring
+  * @param  lat: layout
+  * @retval None
+  */
+static void AUDIO_Latency_Calc(uint8_t profile, uint32_t freq, uint32_t frame_size,
+                               AUDIO_LatencyTypeDef *lat)
+{
+  uint32_t frames = ((freq + 999U) / 1000U) * AUDIO_Latency_Ms[profile];
+
+  lat->start_size = (uint16_t)(frames * frame_size);
+  lat->ring_size = (uint16_t)(2U * frames * frame_size);
+  /* Writable counts the DMA blocks as used, so it settles at the ring less everything
+     buffered: 192 frames at 4ms */
+  lat->fb_target = (uint16_t)((lat->ring_size - lat->start_size) / frame_size);
+}
+
+/**
+  * @brief  AUDIO_Latency_Load
+  *         Takes the selected latency profile and carves its ring out of the
+  *         arena. Only called while the ring is idle (class init,
+  *         SET_INTERFACE), the ring size cannot change under a running stream.
+  *         The ring is filled at the I2S rate whatever the host rate, the SRC
+  *         sits in front of it.
+  * @param  haudio: audio class handle
+  * @retval status
+  */
+static uint8_t AUDIO_Latency_Load(USBD_AUDIO_HandleTypeDef *haudio)
+{
+  AUDIO_LatencyTypeDef lat;
+
+  AUDIO_Latency_Calc(latency_sel, USBD_AUDIO_FREQ, AUDIO_FRAME_SIZE, &lat);
+
+  if (lat.ring_size > sizeof(AUDIO_Ring_Arena))
+  {
+    return (uint8_t)USBD_EMEM;
+  }
+
+  latency_active = latency_sel;
+  haudio->buffer = (uint8_t *)AUDIO_Ring_Arena;
+  haudio->ring_size = lat.ring_size;
+  haudio->start_size = lat.start_size;
+  haudio->fb_target = lat.fb_target;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_Stream_Idle
+  *         Stops playback without leaving the alternate setting: the host
+  *         stopped sending or the bus is suspended. The DMA plays silence
+  *         until AUDIO_Alt_Event powers the hardware down, and the stream
+  *         starts over, pre-roll included, with the next OUT packet.
+  * @param  pdev: device instance
+  * @retval None
+  */
+RAM_ISR static void AUDIO_Stream_Idle(USBD_HandleTypeDef *pdev)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
+  uint32_t primask;
+
+  if (haudio == NULL || audio_idle != 0U)
+  {
+    return;
+  }
+
+  primask = __get_PRIMASK();
+  __disable_irq();
+
+  (void)USBD_memset(haudio->out_buf, 0, sizeof(haudio->out_buf));
+  is_playing = 0U;
+  haudio->offset = AUDIO_OFFSET_UNKNOWN;
+  haudio->rd_enable = 0U;
+  haudio->rd_ptr = 0U;
+  haudio->wr_ptr = 0U;
+  audio_idle = 1U;
+
+  __set_PRIMASK(primask);
+
+  AUDIO_DSP_Reset();
+  EVENT_Post(EVENT_AUDIO_ALT);
+}
+
+/**
+  * @brief  USBD_AUDIO_Suspend
+  *         Bus suspend: stops playback and lets the hardware be powered
+  *         down. Called from the PCD suspend callback.
+  * @param  pdev: device instance
+  * @retval None
+  */
+void USBD_AUDIO_Suspend(USBD_HandleTypeDef *pdev)
+{
+  AUDIO_Stream_Idle(pdev);
+}
+
+/**
+  * @brief  AUDIO_Alt_Event
+  *         Powers the audio hardware layer up or down after a SET_INTERFACE on
+  *         the streaming interface, an idle timeout, a suspend, the stream
+  *         coming back or the class being deinitialized. Runs from thread mode.
+  * @param  ctx: device instance
+  * @retval None
+  */
+static void AUDIO_Alt_Event(void *ctx)
+{
+  USBD_HandleTypeDef *pdev = (USBD_HandleTypeDef *)ctx;
+  USBD_AUDIO_HandleTypeDef *haudio;
+  haudio = (USBD_AUDIO_HandleTypeDef *)pdev->pClassData;
+
+  if (haudio == NULL || haudio->alt_setting == 0U || audio_idle != 0U)
+  {
+    ((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->DeInit(0);
+  }
+  else
+  {
+    ((USBD_AUDIO_ItfTypeDef*)pdev->pUserData)->Init(USBD_AUDIO_FREQ,
+                                                    AUDIO_DEFAULT_VOLUME,
+                                                    0U);
+  }
+}
 
 /**
   * @brief  DeviceQualifierDescriptor
@@ -0,0 +1,233 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_bench.c
+  * @brief   Data path micro-benchmark.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                Benchmark
+  *          ===================================================================
+  *           Times the kernels of the playback data path with the DWT cycle
+  *           counter over synthetic packets: the ring copy done for every OUT
+  *           packet, the feedback computation done every SOF, the 44.1kHz
+  *           converter and the DSP pipeline. The same functions the driver
+  *           calls are timed, so a change to any of them shows up as a
+  *           before/after difference in the GET_BENCH reply.
+  *
+  *           Runs once from main() before the USB device is started, with
+  *           interrupts masked around every call; the class re-initialises
+  *           the DSP pipeline when it is configured. Every kernel is timed
+  *           twice, with the flash accelerator as configured at startup and
+  *           with prefetch and caches off, to show what the ART buys. Code
+  *           placed in RAM (RAM_ISR) does not depend on it.
+  *
+  *           USBD_AUDIO_DataOut and USBD_AUDIO_SOF are not called here: they
+  *           need a configured device and a running stream, which do not
+  *           exist at boot. The ring copy and the feedback computation stand
+  *           in for them, being where those handlers spend their time. The
+  *           handlers themselves are measured per call by the ISR profiler
+  *           (USE_ISR_PROFILE, PROFILE_DATAOUT and PROFILE_SOF) while
+  *           streaming, and on the host, in ns per packet together with the
+  *           same kernels, by Tests/host bench_audio ("make bench").
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_audio.h"
+#include "usbd_audio_bench.h"
+#include "profile.h"
+
+#if (USE_AUDIO_BENCH == 1U)
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_BENCH
+  * @brief Data path micro-benchmark
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_BENCH_Private_Defines
+  * @{
+  */
+/* 48.0 in 10.14, shifted left by 8 like the driver keeps it */
+#define AUDIO_BENCH_FB_NOM                            (48UL << 22)
+/* Frames in a 44.1kHz packet carrying the extra frame */
+#define AUDIO_BENCH_SRC_FRAMES                        45U
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_BENCH_Private_Variables
+  * @{
+  */
+static AUDIO_BENCH_ResultTypeDef AUDIO_BENCH_Result[AUDIO_BENCH_ART_NUM][AUDIO_BENCH_NUM];
+
+static uint8_t AUDIO_BENCH_Ring[AUDIO_TOTAL_BUF_SIZE];
+static uint32_t AUDIO_BENCH_Packet[AUDIO_OUT_PACKET / 4U];
+static uint32_t AUDIO_BENCH_Out[AUDIO_SRC_OUT_FRAMES(AUDIO_BENCH_SRC_FRAMES)];
+static AUDIO_SRC_TypeDef AUDIO_BENCH_Src;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_BENCH_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  AUDIO_BENCH_Add
+  *         Accounts one timed call.
+  * @param  res: kernel result
+  * @param  cycles: cycles of the call
+  * @param  total: running sum
+  * @retval None
+  */
+static void AUDIO_BENCH_Add(AUDIO_BENCH_ResultTypeDef *res, uint32_t cycles, uint64_t *total)
+{
+  if (cycles < res->min)
+  {
+    res->min = cycles;
+  }
+  if (cycles > res->max)
+  {
+    res->max = cycles;
+  }
+
+  *total += cycles;
+}
+
+/**
+  * @brief  AUDIO_BENCH_Kernels
+  *         Times every kernel AUDIO_BENCH_ITERATIONS times.
+  * @param  result: AUDIO_BENCH_NUM entries
+  * @retval None
+  */
+static void AUDIO_BENCH_Kernels(AUDIO_BENCH_ResultTypeDef *result)
+{
+  uint32_t primask;
+  uint32_t wr_ptr = 0U;
+  uint32_t i;
+  uint32_t k;
+
+  AUDIO_SRC_Reset(&AUDIO_BENCH_Src);
+  (void)AUDIO_DSP_Init();
+
+  for (k = 0U; k < AUDIO_BENCH_NUM; k++)
+  {
+    AUDIO_BENCH_ResultTypeDef *res = &result[k];
+    uint64_t total = 0U;
+
+    res->min = 0xFFFFFFFFU;
+    res->max = 0U;
+
+    for (i = 0U; i < AUDIO_BENCH_ITERATIONS; i++)
+    {
+      volatile uint32_t sink = 0U;
+      uint32_t start;
+      uint32_t cycles;
+
+      primask = __get_PRIMASK();
+      __disable_irq();
+      start = DWT->CYCCNT;
+
+      switch (k)
+      {
+        case AUDIO_BENCH_RING_WRITE:
+          wr_ptr = AUDIO_Ring_Write(AUDIO_BENCH_Ring, sizeof(AUDIO_BENCH_Ring), wr_ptr, AUDIO_BENCH_Packet, AUDIO_OUT_PACKET / 4U);
+          break;
+
+        case AUDIO_BENCH_FEEDBACK:
+          /* Sweep the whole writable range so that both signs of the deviation are seen */
+          sink = AUDIO_Feedback_Calc(i % (AUDIO_TOTAL_BUF_SIZE / 4U), AUDIO_TOTAL_BUF_SIZE / 8U,
+                                     AUDIO_BENCH_FB_NOM, AUDIO_FB_GAIN_DEFAULT);
+          break;
+
+        case AUDIO_BENCH_SRC:
+          sink = AUDIO_SRC_Process(&AUDIO_BENCH_Src, AUDIO_BENCH_Packet, AUDIO_BENCH_SRC_FRAMES, AUDIO_BENCH_Out);
+          break;
+
+        default:
+          AUDIO_DSP_Process(AUDIO_BENCH_Packet, AUDIO_BLOCK_FRAMES);
+          break;
+      }
+
+      cycles = DWT->CYCCNT - start;
+      __set_PRIMASK(primask);
+
+      (void)sink;
+      AUDIO_BENCH_Add(res, cycles, &total);
+    }
+
+    res->avg = (uint32_t)(total / AUDIO_BENCH_ITERATIONS);
+  }
+}
+
+/**
+  * @brief  AUDIO_BENCH_Run
+  *         Times the kernels with the flash accelerator on, then off.
+  * @retval None
+  */
+void AUDIO_BENCH_Run(void)
+{
+  uint32_t acr = FLASH->ACR;
+  uint32_t i;
+
+  PROFILE_CycleCounter_Init();
+
+  /* Full scale sawtooth, left and right in opposite directions */
+  for (i = 0U; i < AUDIO_OUT_PACKET / 4U; i++)
+  {
+    uint16_t v = (uint16_t)(i * (65536U / (AUDIO_OUT_PACKET / 4U)));
+
+    AUDIO_BENCH_Packet[i] = (uint32_t)v | ((uint32_t)(uint16_t)~v << 16);
+  }
+
+  AUDIO_BENCH_Kernels(AUDIO_BENCH_Result[AUDIO_BENCH_ART_ON]);
+
+  __HAL_FLASH_PREFETCH_BUFFER_DISABLE();
+  __HAL_FLASH_INSTRUCTION_CACHE_DISABLE();
+  __HAL_FLASH_DATA_CACHE_DISABLE();
+
+  AUDIO_BENCH_Kernels(AUDIO_BENCH_Result[AUDIO_BENCH_ART_OFF]);
+
+  /* Reset the caches while they are off, then restore the startup setting */
+  __HAL_FLASH_INSTRUCTION_CACHE_RESET();
+  __HAL_FLASH_DATA_CACHE_RESET();
+  FLASH->ACR = acr;
+}
+
+/**
+  * @brief  AUDIO_BENCH_Get
+  *         Results of the last AUDIO_BENCH_Run, AUDIO_BENCH_NUM entries.
+  * @param  art: AUDIO_BENCH_ART_ON or AUDIO_BENCH_ART_OFF
+  * @retval results, NULL for an unknown setting
+  */
+const AUDIO_BENCH_ResultTypeDef *AUDIO_BENCH_Get(uint32_t art)
+{
+  if (art >= AUDIO_BENCH_ART_NUM)
+  {
+    return NULL;
+  }
+
+  return AUDIO_BENCH_Result[art];
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#endif /* USE_AUDIO_BENCH */
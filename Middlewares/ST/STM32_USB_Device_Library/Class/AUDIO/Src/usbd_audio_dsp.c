@@ -0,0 +1,600 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_dsp.c
+  * @brief   Playback processing pipeline.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                DSP pipeline
+  *          ===================================================================
+  *           The pipeline is a fixed, ordered table of stages. Each stage has
+  *           a Process() entry that works in place on a block of 16-bit stereo
+  *           frames and a Reset() entry that clears its running state. Stage
+  *           state is laid out in a static arena when the pipeline is
+  *           initialized, so adding a stage only means adding a table entry.
+  *
+  *           Stages are enabled with a bit mask that the host can change at
+  *           run time. Every enabled stage is timed with the DWT cycle counter
+  *           so the cost of each stage can be read back.
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_audio.h"
+#include "usbd_audio_dsp.h"
+#include "stm32f4xx.h"
+#include "profile.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_DSP
+  * @brief Playback processing pipeline
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_DSP_Private_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  uint8_t flags;            /* AUDIO_PROC_xxx */
+  int8_t balance;           /* -127 .. 127 */
+  uint32_t mix[2];          /* Q14 output rows { L coef, R coef } packed for SMUAD */
+  int32_t dc[2];            /* DC estimate of each input channel, Q12 */
+} AUDIO_DSP_ChannelTypeDef;
+
+
+typedef struct
+{
+  uint32_t target;          /* Q30 gain set by the feature unit, 0 when muted */
+  uint32_t gain;            /* Q30 gain reached at the end of the last block */
+} AUDIO_DSP_VolumeTypeDef;
+
+
+typedef struct
+{
+  uint64_t sumsq[2];        /* running sum of squares of the current window */
+  uint32_t frames;          /* frames accumulated in the current window */
+  uint16_t peak[2];         /* running |sample| maximum of the current window */
+  uint16_t peak_hold[2];    /* peak of the last complete window */
+  uint32_t mean_sq[2];      /* mean square of the last complete window */
+} AUDIO_DSP_MeterTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_DSP_Private_Defines
+  * @{
+  */
+/* Stage timing. Predefine both to build the pipeline without the DWT, e.g. on a host */
+#ifndef AUDIO_DSP_CYCLES
+#define AUDIO_DSP_CYCLES()             (DWT->CYCCNT)
+#endif /* AUDIO_DSP_CYCLES */
+
+#ifndef AUDIO_DSP_CYCLES_START
+#define AUDIO_DSP_CYCLES_START()       PROFILE_CycleCounter_Init()
+#endif /* AUDIO_DSP_CYCLES_START */
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_DSP_Private_FunctionPrototypes
+  * @{
+  */
+static void AUDIO_DSP_Channel_Reset(void *state);
+static void AUDIO_DSP_Channel_Process(void *state, uint32_t *frames, uint32_t count);
+static void AUDIO_DSP_Volume_Reset(void *state);
+static void AUDIO_DSP_Volume_Process(void *state, uint32_t *frames, uint32_t count);
+static void AUDIO_DSP_Meter_Reset(void *state);
+static void AUDIO_DSP_Meter_Process(void *state, uint32_t *frames, uint32_t count);
+static uint16_t AUDIO_DSP_Sqrt(uint32_t x);
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_DSP_Private_Variables
+  * @{
+  */
+static const AUDIO_DSP_StageTypeDef AUDIO_DSP_Stages[AUDIO_DSP_STAGE_NUM] =
+{
+  /* AUDIO_DSP_STAGE_CHANNEL: DC blocker, balance, swap, mono, polarity */
+  { sizeof(AUDIO_DSP_ChannelTypeDef), AUDIO_DSP_Channel_Reset, AUDIO_DSP_Channel_Process },
+  /* AUDIO_DSP_STAGE_VOLUME: feature unit volume and mute */
+  { sizeof(AUDIO_DSP_VolumeTypeDef), AUDIO_DSP_Volume_Reset, AUDIO_DSP_Volume_Process },
+  /* AUDIO_DSP_STAGE_METER: peak/RMS level meters, last so they see the output */
+  { sizeof(AUDIO_DSP_MeterTypeDef), AUDIO_DSP_Meter_Reset, AUDIO_DSP_Meter_Process },
+};
+
+static uint64_t AUDIO_DSP_Arena[AUDIO_DSP_ARENA_SIZE / sizeof(uint64_t)];
+static void *AUDIO_DSP_State[AUDIO_DSP_STAGE_NUM];
+static AUDIO_DSP_StatsTypeDef AUDIO_DSP_Stats[AUDIO_DSP_STAGE_NUM];
+static uint32_t AUDIO_DSP_Enable = AUDIO_DSP_ENABLE_ALL;
+
+/* Q30 gain of each AUDIO_VOLUME_RES step from AUDIO_VOLUME_MAX (0dB) down to AUDIO_VOLUME_MIN */
+static const uint32_t AUDIO_DSP_VolumeTable[((AUDIO_VOLUME_MAX - AUDIO_VOLUME_MIN) / AUDIO_VOLUME_RES) + 1] =
+{
+  1073741824U,  956973408U,  852903448U,  760150998U,  677485290U,  603809400U,   /*   0dB */
+   538145694U,  479622855U,  427464319U,  380977976U,  339546978U,  302621563U,   /*  -6dB */
+   269711752U,  240380852U,  214239660U,  190941298U,  170176611U,  151670064U,   /* -12dB */
+   135176087U,  120475814U,  107374182U,   95697341U,   85290345U,   76015100U,   /* -18dB */
+    67748529U,   60380940U,   53814569U,   47962285U,   42746432U,   38097798U,   /* -24dB */
+    33954698U,   30262156U,   26971175U,   24038085U,   21423966U,   19094130U,   /* -30dB */
+    17017661U,   15167006U,   13517609U,   12047581U,   10737418U,    9569734U,   /* -36dB */
+     8529034U,    7601510U,    6774853U,    6038094U,    5381457U,    4796229U,   /* -42dB */
+     4274643U,    3809780U,    3395470U,    3026216U,    2697118U,    2403809U,   /* -48dB */
+     2142397U,    1909413U,    1701766U,    1516701U,    1351761U,    1204758U,   /* -54dB */
+     1073742U,     956973U,     852903U,     760151U,     677485U,     603809U,   /* -60dB */
+      538146U,     479623U,     427464U,     380978U,     339547U,     302622U,   /* -66dB */
+      269712U,     240381U,     214240U,     190941U,     170177U,     151670U,   /* -72dB */
+      135176U,     120476U,     107374U,   /* -78dB */
+};
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_DSP_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  AUDIO_DSP_Init
+  *         Lays out the stage states in the arena, restores the default
+  *         settings and starts the DWT cycle counter.
+  * @retval status
+  */
+uint8_t AUDIO_DSP_Init(void)
+{
+  uint32_t offset = 0U;
+
+  (void)USBD_memset(AUDIO_DSP_Arena, 0, sizeof(AUDIO_DSP_Arena));
+
+  for (uint32_t i = 0U; i < AUDIO_DSP_STAGE_NUM; i++)
+  {
+    if (offset + AUDIO_DSP_Stages[i].state_size > sizeof(AUDIO_DSP_Arena))
+    {
+      return (uint8_t)USBD_EMEM;
+    }
+
+    AUDIO_DSP_State[i] = (uint8_t *)AUDIO_DSP_Arena + offset;
+    /* Keep every state 8-byte aligned for the 64-bit accumulators */
+    offset += (AUDIO_DSP_Stages[i].state_size + 7U) & ~7U;
+  }
+
+  AUDIO_DSP_CYCLES_START();
+
+  AUDIO_DSP_Enable = AUDIO_DSP_ENABLE_ALL;
+  AUDIO_DSP_Channel_Set(0U, 0);
+  AUDIO_DSP_Volume_Set(AUDIO_VOLUME_MAX, 0U);
+  AUDIO_DSP_Reset();
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  AUDIO_DSP_Reset
+  *         Clears the running state of every stage and the cycle statistics.
+  * @retval None
+  */
+void AUDIO_DSP_Reset(void)
+{
+  for (uint32_t i = 0U; i < AUDIO_DSP_STAGE_NUM; i++)
+  {
+    AUDIO_DSP_Stages[i].Reset(AUDIO_DSP_State[i]);
+    AUDIO_DSP_Stats[i].cycles_last = 0U;
+    AUDIO_DSP_Stats[i].cycles_max = 0U;
+  }
+}
+
+/**
+  * @brief  AUDIO_DSP_Process
+  *         Runs the enabled stages over a block, in order.
+  * @param  frames: 16-bit stereo frames, L in the low half-word, processed in place
+  * @param  count: number of frames
+  * @retval None
+  */
+RAM_ISR void AUDIO_DSP_Process(uint32_t *frames, uint32_t count)
+{
+  uint32_t enable = AUDIO_DSP_Enable;
+
+  for (uint32_t i = 0U; i < AUDIO_DSP_STAGE_NUM; i++)
+  {
+    if ((enable & (1UL << i)) != 0U)
+    {
+      uint32_t start = AUDIO_DSP_CYCLES();
+      uint32_t cycles;
+
+      AUDIO_DSP_Stages[i].Process(AUDIO_DSP_State[i], frames, count);
+
+      cycles = AUDIO_DSP_CYCLES() - start;
+      AUDIO_DSP_Stats[i].cycles_last = cycles;
+      if (cycles > AUDIO_DSP_Stats[i].cycles_max)
+      {
+        AUDIO_DSP_Stats[i].cycles_max = cycles;
+      }
+    }
+  }
+}
+
+/**
+  * @brief  AUDIO_DSP_SetEnable
+  *         Selects the stages that run. Stages that get switched on start from
+  *         a clean state instead of whatever they held when switched off.
+  * @param  mask: bit n enables stage n
+  * @retval None
+  */
+void AUDIO_DSP_SetEnable(uint32_t mask)
+{
+  uint32_t turned_on;
+
+  mask &= AUDIO_DSP_ENABLE_ALL;
+  turned_on = mask & ~AUDIO_DSP_Enable;
+
+  for (uint32_t i = 0U; i < AUDIO_DSP_STAGE_NUM; i++)
+  {
+    if ((turned_on & (1UL << i)) != 0U)
+    {
+      AUDIO_DSP_Stages[i].Reset(AUDIO_DSP_State[i]);
+    }
+  }
+
+  AUDIO_DSP_Enable = mask;
+}
+
+/**
+  * @brief  AUDIO_DSP_GetEnable
+  * @retval mask of the enabled stages
+  */
+uint32_t AUDIO_DSP_GetEnable(void)
+{
+  return AUDIO_DSP_Enable;
+}
+
+/**
+  * @brief  AUDIO_DSP_GetStats
+  * @retval per stage cycle statistics, AUDIO_DSP_STAGE_NUM entries
+  */
+const AUDIO_DSP_StatsTypeDef *AUDIO_DSP_GetStats(void)
+{
+  return AUDIO_DSP_Stats;
+}
+
+/**
+  * @brief  AUDIO_DSP_Channel_Set
+  *         Rebuilds the channel stage mixing matrix from the flags and balance.
+  * @param  flags: AUDIO_PROC_xxx
+  * @param  balance: -127 (left only) .. 127 (right only)
+  * @retval None
+  */
+void AUDIO_DSP_Channel_Set(uint8_t flags, int8_t balance)
+{
+  AUDIO_DSP_ChannelTypeDef *ch = (AUDIO_DSP_ChannelTypeDef *)AUDIO_DSP_State[AUDIO_DSP_STAGE_CHANNEL];
+  int32_t gain_l = 16384;
+  int32_t gain_r = 16384;
+  int32_t row_l[2] = {16384, 0};
+  int32_t row_r[2] = {0, 16384};
+
+  if (balance < -127)
+  {
+    balance = -127;
+  }
+
+  if (balance > 0)
+  {
+    gain_l = (gain_l * (127 - balance)) / 127;
+  }
+  else
+  {
+    gain_r = (gain_r * (127 + balance)) / 127;
+  }
+
+  if ((flags & AUDIO_PROC_INVERT_L) != 0U)
+  {
+    gain_l = -gain_l;
+  }
+  if ((flags & AUDIO_PROC_INVERT_R) != 0U)
+  {
+    gain_r = -gain_r;
+  }
+
+  if ((flags & AUDIO_PROC_MONO) != 0U)
+  {
+    row_l[0] = row_l[1] = row_r[0] = row_r[1] = 8192;
+  }
+  else if ((flags & AUDIO_PROC_SWAP) != 0U)
+  {
+    row_l[0] = 0;
+    row_l[1] = 16384;
+    row_r[0] = 16384;
+    row_r[1] = 0;
+  }
+
+  ch->mix[0] = __PKHBT((row_l[0] * gain_l) >> 14, (row_l[1] * gain_l) >> 14, 16);
+  ch->mix[1] = __PKHBT((row_r[0] * gain_r) >> 14, (row_r[1] * gain_r) >> 14, 16);
+  ch->flags = flags;
+  ch->balance = balance;
+}
+
+/**
+  * @brief  AUDIO_DSP_Channel_Get
+  * @param  flags: AUDIO_PROC_xxx
+  * @param  balance: -127 .. 127
+  * @retval None
+  */
+void AUDIO_DSP_Channel_Get(uint8_t *flags, int8_t *balance)
+{
+  AUDIO_DSP_ChannelTypeDef *ch = (AUDIO_DSP_ChannelTypeDef *)AUDIO_DSP_State[AUDIO_DSP_STAGE_CHANNEL];
+
+  *flags = ch->flags;
+  *balance = ch->balance;
+}
+
+/**
+  * @brief  AUDIO_DSP_Channel_Reset
+  *         Clears the DC estimates, the settings are kept.
+  * @param  state: stage state
+  * @retval None
+  */
+static void AUDIO_DSP_Channel_Reset(void *state)
+{
+  AUDIO_DSP_ChannelTypeDef *ch = (AUDIO_DSP_ChannelTypeDef *)state;
+
+  ch->dc[0] = 0;
+  ch->dc[1] = 0;
+}
+
+/**
+  * @brief  AUDIO_DSP_Channel_Process
+  *         DC blocker followed by the 2x2 balance/swap/mono/polarity matrix.
+  *         The flags are folded into the matrix when they are set, so the loop
+  *         itself has no per-sample branches.
+  * @param  state: stage state
+  * @param  frames: block, processed in place
+  * @param  count: number of frames
+  * @retval None
+  */
+RAM_ISR static void AUDIO_DSP_Channel_Process(void *state, uint32_t *frames, uint32_t count)
+{
+  AUDIO_DSP_ChannelTypeDef *ch = (AUDIO_DSP_ChannelTypeDef *)state;
+  uint32_t mix_l = ch->mix[0];
+  uint32_t mix_r = ch->mix[1];
+  int32_t dc_l = ch->dc[0];
+  int32_t dc_r = ch->dc[1];
+  /* The DC estimate always tracks, the mask only decides whether it is subtracted */
+  int32_t dc_mask = ((ch->flags & AUDIO_PROC_DC_BLOCK) != 0U) ? -1 : 0;
+
+  for (uint32_t i = 0U; i < count; i++)
+  {
+    uint32_t frame = frames[i];
+    int32_t smp_l = (int16_t)(frame & 0xFFFFU);
+    int32_t smp_r = (int16_t)(frame >> 16);
+
+    /* First order DC blocker: subtract a one-pole low-pass estimate of the input */
+    dc_l += ((smp_l << 12) - dc_l) >> AUDIO_PROC_DC_SHIFT;
+    dc_r += ((smp_r << 12) - dc_r) >> AUDIO_PROC_DC_SHIFT;
+    smp_l = __SSAT(smp_l - ((dc_l >> 12) & dc_mask), 16);
+    smp_r = __SSAT(smp_r - ((dc_r >> 12) & dc_mask), 16);
+
+    frame = __PKHBT(smp_l, smp_r, 16);
+    smp_l = __SSAT((int32_t)__SMUAD(frame, mix_l) >> 14, 16);
+    smp_r = __SSAT((int32_t)__SMUAD(frame, mix_r) >> 14, 16);
+
+    frames[i] = __PKHBT(smp_l, smp_r, 16);
+  }
+
+  ch->dc[0] = dc_l;
+  ch->dc[1] = dc_r;
+}
+
+/**
+  * @brief  AUDIO_DSP_Volume_Set
+  *         Sets the gain of the volume stage. The stage ramps to it over the
+  *         next block, so changes and mute do not click.
+  * @param  volume: 1/256dB, AUDIO_VOLUME_MIN .. AUDIO_VOLUME_MAX, rounded down to AUDIO_VOLUME_RES
+  * @param  mute: 1 to mute
+  * @retval None
+  */
+void AUDIO_DSP_Volume_Set(int16_t volume, uint8_t mute)
+{
+  AUDIO_DSP_VolumeTypeDef *vol = (AUDIO_DSP_VolumeTypeDef *)AUDIO_DSP_State[AUDIO_DSP_STAGE_VOLUME];
+  int32_t step;
+
+  if (volume < AUDIO_VOLUME_MIN)
+  {
+    volume = AUDIO_VOLUME_MIN;
+  }
+  if (volume > AUDIO_VOLUME_MAX)
+  {
+    volume = AUDIO_VOLUME_MAX;
+  }
+
+  step = (AUDIO_VOLUME_MAX - volume) / AUDIO_VOLUME_RES;
+
+  /* A single word write, the DMA interrupt may read it at any time */
+  vol->target = (mute != 0U) ? 0U : AUDIO_DSP_VolumeTable[step];
+}
+
+/**
+  * @brief  AUDIO_DSP_Volume_Reset
+  *         Jumps to the target gain, the settings are kept.
+  * @param  state: stage state
+  * @retval None
+  */
+static void AUDIO_DSP_Volume_Reset(void *state)
+{
+  AUDIO_DSP_VolumeTypeDef *vol = (AUDIO_DSP_VolumeTypeDef *)state;
+
+  vol->gain = vol->target;
+}
+
+/**
+  * @brief  AUDIO_DSP_Volume_Process
+  *         Scales the block by the Q30 gain, ramping linearly when the target
+  *         has changed. 0dB leaves the samples untouched.
+  * @param  state: stage state
+  * @param  frames: block, processed in place
+  * @param  count: number of frames
+  * @retval None
+  */
+RAM_ISR static void AUDIO_DSP_Volume_Process(void *state, uint32_t *frames, uint32_t count)
+{
+  AUDIO_DSP_VolumeTypeDef *vol = (AUDIO_DSP_VolumeTypeDef *)state;
+  uint32_t target = vol->target;
+  int32_t gain = (int32_t)vol->gain;
+  int32_t step;
+
+  if (target == vol->gain && target == AUDIO_DSP_VolumeTable[0])
+  {
+    return;
+  }
+
+  step = ((int32_t)target - gain) / (int32_t)count;
+
+  for (uint32_t i = 0U; i < count; i++)
+  {
+    uint32_t frame = frames[i];
+    int32_t smp_l = (int16_t)(frame & 0xFFFFU);
+    int32_t smp_r = (int16_t)(frame >> 16);
+
+    gain += step;
+    smp_l = (int32_t)(((int64_t)smp_l * gain) >> 30);
+    smp_r = (int32_t)(((int64_t)smp_r * gain) >> 30);
+
+    frames[i] = __PKHBT(smp_l, smp_r, 16);
+  }
+
+  vol->gain = target;
+}
+
+/**
+  * @brief  AUDIO_DSP_Meter_Read
+  *         Returns the levels latched over the last AUDIO_METER_WINDOW frames,
+  *         32767 = 0dBFS. The square root is taken here rather than in the
+  *         data path.
+  * @param  peak: peak { L, R }
+  * @param  rms: RMS { L, R }
+  * @retval None
+  */
+void AUDIO_DSP_Meter_Read(uint16_t *peak, uint16_t *rms)
+{
+  AUDIO_DSP_MeterTypeDef *meter = (AUDIO_DSP_MeterTypeDef *)AUDIO_DSP_State[AUDIO_DSP_STAGE_METER];
+
+  peak[0] = meter->peak_hold[0];
+  peak[1] = meter->peak_hold[1];
+  rms[0] = AUDIO_DSP_Sqrt(meter->mean_sq[0]);
+  rms[1] = AUDIO_DSP_Sqrt(meter->mean_sq[1]);
+}
+
+/**
+  * @brief  AUDIO_DSP_Meter_Reset
+  *         Clears the running and latched level meters.
+  * @param  state: stage state
+  * @retval None
+  */
+static void AUDIO_DSP_Meter_Reset(void *state)
+{
+  (void)USBD_memset(state, 0, sizeof(AUDIO_DSP_MeterTypeDef));
+}
+
+/**
+  * @brief  AUDIO_DSP_Meter_Process
+  *         Accumulates peak and sum of squares in registers and writes them
+  *         back once per block.
+  * @param  state: stage state
+  * @param  frames: block, left untouched
+  * @param  count: number of frames
+  * @retval None
+  */
+RAM_ISR static void AUDIO_DSP_Meter_Process(void *state, uint32_t *frames, uint32_t count)
+{
+  AUDIO_DSP_MeterTypeDef *meter = (AUDIO_DSP_MeterTypeDef *)state;
+  uint32_t peak_l = meter->peak[0];
+  uint32_t peak_r = meter->peak[1];
+  uint64_t sumsq_l = 0U;
+  uint64_t sumsq_r = 0U;
+
+  for (uint32_t i = 0U; i < count; i++)
+  {
+    int32_t smp_l = (int16_t)(frames[i] & 0xFFFFU);
+    int32_t smp_r = (int16_t)(frames[i] >> 16);
+    uint32_t abs_l = (uint32_t)((smp_l < 0) ? -smp_l : smp_l);
+    uint32_t abs_r = (uint32_t)((smp_r < 0) ? -smp_r : smp_r);
+
+    peak_l = (abs_l > peak_l) ? abs_l : peak_l;
+    peak_r = (abs_r > peak_r) ? abs_r : peak_r;
+    sumsq_l += (uint64_t)(smp_l * smp_l);
+    sumsq_r += (uint64_t)(smp_r * smp_r);
+  }
+
+  meter->sumsq[0] += sumsq_l;
+  meter->sumsq[1] += sumsq_r;
+  meter->frames += count;
+
+  if (meter->frames >= AUDIO_METER_WINDOW)
+  {
+    meter->peak_hold[0] = (uint16_t)peak_l;
+    meter->peak_hold[1] = (uint16_t)peak_r;
+    meter->mean_sq[0] = (uint32_t)(meter->sumsq[0] / meter->frames);
+    meter->mean_sq[1] = (uint32_t)(meter->sumsq[1] / meter->frames);
+    meter->sumsq[0] = 0U;
+    meter->sumsq[1] = 0U;
+    meter->frames = 0U;
+    peak_l = 0U;
+    peak_r = 0U;
+  }
+
+  meter->peak[0] = (uint16_t)peak_l;
+  meter->peak[1] = (uint16_t)peak_r;
+}
+
+/**
+  * @brief  AUDIO_DSP_Sqrt
+  *         Integer square root.
+  * @param  x: value
+  * @retval floor(sqrt(x))
+  */
+static uint16_t AUDIO_DSP_Sqrt(uint32_t x)
+{
+  uint32_t res = 0U;
+  uint32_t bit = 1UL << 30;
+
+  while (bit > x)
+  {
+    bit >>= 2;
+  }
+
+  while (bit != 0U)
+  {
+    if (x >= res + bit)
+    {
+      x -= res + bit;
+      res = (res >> 1) + bit;
+    }
+    else
+    {
+      res >>= 1;
+    }
+    bit >>= 2;
+  }
+
+  return (uint16_t)res;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,979 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_src.c
+  * @brief   Fixed ratio 44.1kHz to 48kHz sample rate converter.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                Polyphase SRC
+  *          ===================================================================
+  *           Boards whose PLLI2S only reaches 48kHz play 44.1kHz streams through
+  *           this converter. The 44.1kHz input is interpolated by L = 160 and
+  *           decimated by M = 147 with a polyphase FIR, so only the branch that
+  *           lands on an output sample is ever computed.
+  *
+  *           Prototype filter: 6400 taps (160 branches x 40 taps), Kaiser
+  *           windowed sinc, beta = 8.5, -6dB at 21.2kHz, scaled by L and
+  *           quantized to Q30. The prototype is linear phase, so branch p is
+  *           branch L-1-p reversed in time and only 80 branches are stored
+  *           (12.8KB of flash).
+  *
+  *           Measured on the host (Tests/host, test_src) with -1dBFS 16-bit
+  *           stereo tones in 44/45 frame packets:
+  *             - flat within 0.01dB up to 18kHz, then the transition band:
+  *               -0.09dB at 19kHz, -1.1dB at 20kHz
+  *             - THD+N over 20Hz-20kHz: -92dB or better at every tone
+  *             - THD+N over the whole 0-24kHz output: -94dB at 1kHz, -90dB
+  *               at 19kHz, -72dB at 20kHz, whose image at 24.1kHz is only
+  *               partly rejected and folds back to 23.9kHz
+  *
+  *           Cost estimate on the Cortex-M4: per tap one LDR of the frame, one
+  *           LDR of the coefficient, SXTH/ASR to split the channels and two
+  *           SMLAL, about 6 cycles. 40 taps plus loop overhead is ~260 cycles
+  *           per output frame, ~12.5k cycles per 1ms packet, i.e. ~15% of the
+  *           84MHz core while a 44.1kHz stream is playing.
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_audio_src.h"
+#include <string.h>
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_SRC
+  * @brief Fixed ratio 44.1kHz to 48kHz sample rate converter
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_SRC_Private_Variables
+  * @{
+  */
+
+/* Polyphase branches 0..L/2-1, oldest tap first, Q30 */
+static const int32_t AUDIO_SRC_Coef[AUDIO_SRC_L / 2U][AUDIO_SRC_TAPS] =
+{
+  {
+          72855,     -200445,      446124,     -869908,     1542289,
+       -2538961,     3933040,    -5785295,     8133401,   -10981546,
+       14291899,   -17979381,    21910825,   -25908891,    29759920,
+      -33222442,    36025605,   -37809209,    37587149,  1032319231,
+       44188894,   -40951111,    37953338,   -34507449,    30640650,
+      -26513393,    22319544,   -18248073,    14461410,   -11082504,
+        8188753,    -5811911,     3942894,    -2540129,     1539840,
+        -866704,      443508,     -198818,       72111,      -16309,
+  },
+  {
+          73558,     -201978,      448550,     -872767,     1544155,
+       -2536873,     3921807,    -5756708,     8075351,   -10877042,
+       14117900,   -17705225,    21495722,   -25297292,    28871848,
+      -31930840,    34094435,   -34674899,    31055395,  1032195797,
+       50859653,   -44099583,    39876938,   -35785378,    31513692,
+      -27110556,    22721708,   -18511182,    14626354,   -11179864,
+        8241377,    -5836538,     3951358,    -2540371,     1536808,
+        -863154,      440703,     -197097,       71328,      -16134,
+  },
+  {
+          74222,     -203418,      450788,     -875282,     1545442,
+       -2533870,     3909206,    -5726170,     8014637,   -10769043,
+       13939493,   -17425723,    21074408,   -24678842,    27976776,
+      -30633131,    32160522,   -31549198,    24594587,  1031948956,
+       57598429,   -47253593,    41795705,   -37055742,    32378705,
+      -27700137,    23117149,   -18768593,    14786653,   -11273576,
+        8291241,    -5859156,     3958422,    -2539682,     1533188,
+        -859255,      437707,     -195281,       70504,      -15945,
+  },
+  {
+          74846,     -204764,      452837,     -877454,     1546153,
+       -2529958,     3895249,    -5693703,     7951292,   -10657603,
+       13756758,   -17140995,    20647056,   -24053787,    27075052,
+      -29329799,    30224560,   -28433108,    18205663,  1031578760,
+       64404206,   -50412101,    43708939,   -38318058,    33235348,
+      -28281898,    23505699,   -19020191,    14942231,   -11363590,
+        8338314,    -5879750,     3964076,    -2538056,     1528978,
+        -855008,      434520,     -193372,       69640,      -15743,
+  },
+  {
+          75431,     -206018,      454699,     -879286,     1546291,
+       -2525145,     3879948,    -5659325,     7885352,   -10542776,
+       13569780,   -16851165,    20213843,   -23422376,    26167023,
+      -28021332,    28287237,   -25327625,    11889536,  1031085291,
+       71275946,   -53574059,    45615938,   -39571841,    34083283,
+      -28855599,    23887194,   -19265864,    15093013,   -11449860,
+        8382568,    -5898300,     3968311,    -2535490,     1524177,
+        -850412,      431141,     -191367,       68736,      -15528,
+  },
+  {
+          75977,     -207179,      456374,     -880778,     1545861,
+       -2519438,     3863315,    -5623060,     7816851,   -10424618,
+       13378642,   -16556354,    19774945,   -22784857,    25253036,
+      -26708215,    26349241,   -22233737,     5647101,  1030468656,
+       78212594,   -56738411,    47515998,   -40816610,    34922173,
+      -29421006,    24261469,   -19505500,    15238927,   -11532337,
+        8423974,    -5914792,     3971119,    -2531978,     1518782,
+        -845465,      427572,     -189268,       67791,      -15299,
+  },
+  {
+          76484,     -208249,      457863,     -881933,     1544865,
+       -2512842,     3845363,    -5584928,     7745825,   -10303185,
+       13183429,   -16256689,    19330540,   -22141482,    24333441,
+      -25390933,    24411255,   -19152417,     -520769,  1029728988,
+       85213074,   -59904093,    49408416,   -42051883,    35751681,
+      -29977884,    24628364,   -19738991,    15379900,   -11610978,
+        8462504,    -5929209,     3972490,    -2527517,     1512792,
+        -840168,      423811,     -187074,       66805,      -15056,
+  },
+  {
+          76952,     -209227,      459168,     -882753,     1543308,
+       -2505366,     3826105,    -5544953,     7672311,   -10178535,
+       12984228,   -15952294,    18880808,   -21492503,    23408587,
+      -24069971,    22473960,   -16084632,    -6613223,  1028866448,
+       92276291,   -63070033,    51292487,   -43277181,    36571477,
+      -30526002,    24987719,   -19966230,    15515862,   -11685737,
+        8498131,    -5941536,     3972417,    -2522103,     1506205,
+        -834519,      419858,     -184785,       65778,      -14800,
+  },
+  {
+          77383,     -210114,      460289,     -883239,     1541193,
+       -2497018,     3805556,    -5503159,     7596347,   -10050726,
+       12781125,   -15643298,    18425930,   -20838171,    22478824,
+      -22745814,    20538033,   -13031338,   -12629431,  1027881223,
+       99401131,   -66235153,    53167505,   -44492025,    37381228,
+      -31065132,    25339378,   -20187110,    15646744,   -11756572,
+        8530831,    -5951758,     3970892,    -2515732,     1499020,
+        -828519,      415713,     -182402,       64710,      -14530,
+  },
+  {
+          77775,     -210911,      461227,     -883394,     1538525,
+       -2487805,     3783729,    -5459568,     7517971,    -9919817,
+       12574210,   -15329828,    17966089,   -20178743,    21544503,
+      -21418945,    18604147,    -9993478,   -18568583,  1026773527,
+      106586462,   -69398370,    55032763,   -45695938,    38180606,
+      -31595046,    25683185,   -20401529,    15772480,   -11823440,
+        8560578,    -5959863,     3967910,    -2508402,     1491236,
+        -822167,      411377,     -179923,       63602,      -14245,
+  },
+  {
+          78130,     -211618,      461984,     -883220,     1535309,
+       -2477735,     3760639,    -5414205,     7437222,    -9785868,
+       12363572,   -15012014,    17501468,   -19514471,    20605975,
+      -20089847,    16672971,    -6971987,   -24429893,  1025543601,
+      113831134,   -72558590,    56887557,   -46888446,    38969286,
+      -32115519,    26018988,   -20609385,    15893003,   -11886302,
+        8587348,    -5965838,     3963462,    -2500110,     1482852,
+        -815463,      406849,     -177350,       62452,      -13947,
+  },
+  {
+          78448,     -212236,      462560,     -882720,     1531549,
+       -2466818,     3736300,    -5367095,     7354140,    -9648940,
+       12149301,   -14689987,    17032250,   -18845613,    19663591,
+      -18759001,    14745172,    -3967788,   -30212596,  1024191710,
+      121133977,   -75714717,    58731180,   -48069076,    39746944,
+      -32626331,    26346636,   -20810578,    16008251,   -11945117,
+        8611120,    -5969669,     3957545,    -2490854,     1473868,
+        -808407,      402129,     -174682,       61262,      -13635,
+  },
+  {
+          78728,     -212765,      462957,     -881896,     1527249,
+       -2455061,     3710729,    -5318264,     7268765,    -9509095,
+       11931489,   -14363879,    16558623,   -18172424,    18717703,
+      -17426887,    12821410,     -981791,   -35915948,  1022718149,
+      128493804,   -78865646,    60562926,   -49237357,    40513259,
+      -33127263,    26665982,   -21005011,    16118160,   -11999849,
+        8631870,    -5971346,     3950151,    -2480632,     1464283,
+        -800999,      397219,     -171919,       60030,      -13308,
+  },
+  {
+          78972,     -213207,      463176,     -880750,     1522415,
+       -2442475,     3683941,    -5267737,     7181138,    -9366396,
+       11710228,   -14033823,    16080770,   -17495162,    17768660,
+      -16093982,    10902341,     1985103,   -41539229,  1021123237,
+      135909410,   -82010270,    62382091,   -50392822,    41267914,
+      -33618097,    26976881,   -21192588,    16222670,   -12050460,
+        8649579,    -5970859,     3941277,    -2469441,     1454097,
+        -793241,      392117,     -169062,       58758,      -12967,
+  },
+  {
+          79180,     -213561,      463219,     -879286,     1517053,
+       -2429068,     3655951,    -5215541,     7091301,    -9220905,
+       11485612,   -13699951,    15598881,   -16814085,    16816815,
+      -14760765,     8988617,     4932007,   -47081739,  1019407320,
+      143379574,   -85147473,    64187972,   -51535006,    42010594,
+      -34098621,    27279189,   -21373216,    16321723,   -12096915,
+        8664227,    -5968196,     3930919,    -2457282,     1443310,
+        -785131,      386826,     -166111,       57445,      -12612,
+  },
+  {
+          79352,     -213828,      463087,     -877506,     1511166,
+       -2414851,     3626777,    -5161703,     6999296,    -9072688,
+       11257735,   -13362399,    15113143,   -16129449,    15862517,
+      -13427710,     7080886,     7858043,   -52542803,  1017570769,
+      150903056,   -88276135,    65979864,   -52663444,    42740987,
+      -34568623,    27572766,   -21546804,    16415261,   -12139181,
+        8675796,    -5963349,     3919071,    -2444152,     1431922,
+        -776672,      381344,     -163066,       56091,      -12242,
+  },
+  {
+          79488,     -214010,      462782,     -875413,     1504761,
+       -2399831,     3596435,    -5106249,     6905166,    -8921809,
+       11026691,   -13021301,    14623744,   -15441515,    14906117,
+      -12095290,     5179789,    10762349,   -57921765,  1015613983,
+      158478599,   -91395134,    67757066,   -53777679,    43458784,
+      -35027898,    27857475,   -21713263,    16503230,   -12177225,
+        8684266,    -5956309,     3905732,    -2430052,     1419935,
+        -767863,      375673,     -159928,       54696,      -11857,
+  },
+  {
+          79589,     -214107,      462304,     -873010,     1497844,
+       -2384021,     3564942,    -5049209,     6808955,    -8768333,
+       10792578,   -12676795,    14130874,   -14750539,    13947964,
+      -10763976,     3285962,    13644073,   -63217995,  1013537386,
+      166104931,   -94503339,    69518879,   -54877252,    44163680,
+      -35476239,    28133180,   -21872506,    16585575,   -12211017,
+        8689623,    -5947069,     3890899,    -2414981,     1407348,
+        -758705,      369814,     -156697,       53260,      -11458,
+  },
+  {
+          79656,     -214120,      461657,     -870301,     1490420,
+       -2367430,     3532316,    -4990610,     6710707,    -8612327,
+       10555490,   -12329017,    13634723,   -14056782,    12988408,
+       -9434236,     1400037,    16502375,   -68430883,  1011341427,
+      173780763,   -97599619,    71264605,   -55961711,    44855374,
+      -35913446,    28399750,   -22024449,    16662246,   -12240525,
+        8691850,    -5935622,     3874569,    -2398939,     1394162,
+        -749200,      363767,     -153372,       51784,      -11045,
+  },
+  {
+          79688,     -214050,      460840,     -867288,     1482495,
+       -2350069,     3498574,    -4930482,     6610466,    -8453858,
+       10315525,   -11978104,    13135480,   -13360502,    12027797,
+       -8106537,     -477362,    19336428,   -73559843,  1009026582,
+      181504789,  -100682837,    72993547,   -57030606,    45533567,
+      -36339322,    28657055,   -22169010,    16733192,   -12265723,
+        8690934,    -5921962,     3856741,    -2381927,     1380380,
+        -739348,      357533,     -149956,       50268,      -10617,
+  },
+  {
+          79687,     -213897,      459857,     -863974,     1474076,
+       -2331948,     3463735,    -4868852,     6508278,    -8292993,
+       10072782,   -11624194,    12633336,   -12661958,    11066477,
+       -6781342,    -2345614,    22145421,   -78604313,  1006593353,
+      189275688,  -103751853,    74705012,   -58083490,    46197965,
+      -36753670,    28904968,   -22306109,    16798366,   -12286583,
+        8686860,    -5906083,     3837413,    -2363946,     1366002,
+        -729152,      351112,     -146447,       48712,      -10174,
+  },
+  {
+          79652,     -213662,      458708,     -860364,     1465168,
+       -2313079,     3427817,    -4805751,     6404188,    -8129800,
+        9827358,   -11267427,    12128484,   -11961408,    10104795,
+       -5459111,    -4204108,    24928551,   -83563750,  1004042266,
+      197092124,  -106805524,    76398308,   -59119921,    46848276,
+      -37156301,    29143367,   -22435669,    16857722,   -12303081,
+        8679617,    -5887980,     3816586,    -2344997,     1351030,
+        -718612,      344507,     -142848,       47115,       -9717,
+  },
+  {
+          79584,     -213347,      457397,     -856460,     1455777,
+       -2293472,     3390838,    -4741209,     6298242,    -7964349,
+        9579353,   -10907941,    11621113,   -11259111,     9143096,
+       -4140304,    -6052234,    27685032,   -88437639,  1001373873,
+      204952744,  -109842703,    78072748,   -60139460,    47484215,
+      -37547027,    29372129,   -22557615,    16911216,   -12315193,
+        8669193,    -5867651,     3794260,    -2325082,     1335466,
+        -707730,      337717,     -139157,       45479,       -9245,
+  },
+  {
+          79484,     -212952,      455923,     -852267,     1445912,
+       -2273139,     3352819,    -4675256,     6190488,    -7796708,
+        9328867,   -10545877,    11111416,   -10555325,     8181723,
+       -2825374,    -7889394,    30414091,   -93225484,   998588752,
+      212856182,  -112862243,    79727646,   -61141673,    48105498,
+      -37925662,    29591139,   -22671875,    16958806,   -12322895,
+        8655579,    -5845092,     3770434,    -2304203,     1319312,
+        -696508,      330745,     -135377,       43803,       -8758,
+  },
+  {
+          79352,     -212478,      454290,     -847787,     1435577,
+       -2252093,     3313778,    -4607924,     6080971,    -7626947,
+        9075999,   -10181374,    10599584,    -9850308,     7221020,
+       -1514773,    -9714992,    33114967,   -97926813,   995687504,
+      220801057,  -115862992,    81362320,   -62126130,    48711846,
+      -38292028,    29800281,   -22778379,    17000452,   -12326169,
+        8638766,    -5820301,     3745110,    -2282361,     1302571,
+        -684947,      323590,     -131506,       42088,       -8257,
+  },
+  {
+          79188,     -211927,      452499,     -843025,     1424781,
+       -2230343,     3273734,    -4539242,     5969741,    -7455136,
+        8820850,    -9814572,    10085810,    -9144318,     6261326,
+        -208950,   -11528442,    35786914,  -102541178,   992670757,
+      228785973,  -118843798,    82976092,   -63092405,    49302986,
+      -38645947,    29999444,   -22877060,    17036116,   -12324994,
+        8618745,    -5793276,     3718291,    -2259560,     1285245,
+        -673050,      316256,     -127547,       40333,       -7741,
+  },
+  {
+          78994,     -211299,      450553,     -837985,     1413529,
+       -2207903,     3232708,    -4469242,     5856844,    -7281346,
+        8563522,    -9445614,     9570284,    -8437610,     5302981,
+        1091651,   -13329162,    38429199,  -107068154,   989539162,
+      236809520,  -121803507,    84568286,   -64040076,    49878647,
+      -38987247,    30188521,   -22967853,    17065762,   -12319353,
+        8595512,    -5764018,     3689977,    -2235804,     1267336,
+        -660819,      308742,     -123500,       38540,       -7211,
+  },
+  {
+          78768,     -210595,      448453,     -832669,     1401830,
+       -2184786,     3190719,    -4397957,     5742329,    -7105648,
+        8304115,    -9074638,     9053199,    -7730441,     4346322,
+        2386588,   -15116580,    41041105,  -111507339,   986293397,
+      244870276,  -124740963,    86138233,   -64968728,    50438564,
+      -39315759,    30367405,   -23050695,    17089355,   -12309229,
+        8569059,    -5732526,     3660173,    -2211094,     1248849,
+        -648256,      301051,     -119366,       36708,       -6666,
+  },
+  {
+          78513,     -209816,      446202,     -827084,     1389689,
+       -2161002,     3147789,    -4325419,     5626245,    -6928114,
+        8042732,    -8701788,     8534746,    -7023067,     3391686,
+        3675425,   -16890130,    43621926,  -115858354,   982934162,
+      252966803,  -127655010,    87685266,   -65877949,    50982476,
+      -39631317,    30535996,   -23125528,    17106865,   -12294609,
+        8539382,    -5698801,     3628881,    -2185436,     1229787,
+        -635364,      293184,     -115145,       34838,       -6106,
+  },
+  {
+          78228,     -208964,      443801,     -821231,     1377115,
+       -2136565,     3103937,    -4251659,     5508641,    -6748815,
+        7779474,    -8327204,     8015116,    -6315741,     2439405,
+        4957727,   -18649253,    46170974,  -120120843,   979462182,
+      261097653,  -130544491,    89208723,   -66767333,    51510127,
+      -39933761,    30694195,   -23192295,    17118262,   -12275479,
+        8506480,    -5662847,     3596106,    -2158833,     1210152,
+        -622144,      285142,     -110839,       32931,       -5532,
+  },
+  {
+          77914,     -208039,      441253,     -815116,     1364116,
+       -2111487,     3059185,    -4176711,     5389566,    -6567824,
+        7514445,    -7951028,     7494502,    -5608718,     1489811,
+        6233065,   -20393397,    48687574,  -124294473,   975878206,
+      269261364,  -133408249,    90707947,   -67636479,    52021265,
+      -40222933,    30841908,   -23250942,    17123517,   -12251829,
+        8470349,    -5624664,     3561851,    -2131291,     1189950,
+        -608601,      276928,     -106448,       30985,       -4943,
+  },
+  {
+          77572,     -207043,      438560,     -808742,     1350697,
+       -2085782,     3013553,    -4100607,     5269071,    -6385213,
+        7247747,    -7573401,     6973093,    -4902249,      543234,
+        7501013,   -22122020,    51171064,  -128378936,   972183007,
+      277456460,  -136245126,    92182286,   -68484991,    52515644,
+      -40498683,    30979043,   -23301417,    17122605,   -12223647,
+        8430989,    -5584258,     3526123,    -2102814,     1169183,
+        -594736,      268542,     -101973,       29003,       -4341,
+  },
+  {
+          77202,     -205976,      435725,     -802115,     1336868,
+       -2059462,     2967064,    -4023382,     5147205,    -6201055,
+        6979482,    -7194465,     6451080,    -4196586,     -400000,
+        8761152,   -23834586,    53620798,  -132373945,   968377382,
+      285681456,  -139053966,    93631093,   -69312480,    52993022,
+      -40760860,    31105512,   -23343672,    17115503,   -12190927,
+        8388400,    -5541632,     3488927,    -2073407,     1147856,
+        -580554,      259988,      -97415,       26984,       -3724,
+  },
+  {
+          76804,     -204840,      432749,     -795238,     1322636,
+       -2032541,     2919737,    -3945067,     5024018,    -6015424,
+        6709754,    -6814361,     5928653,    -3491979,    -1339566,
+       10013064,   -25530567,    56036146,  -136279239,   964462151,
+      293934853,  -141833613,    95053726,   -70118562,    53453164,
+      -41009321,    31221231,   -23377662,    17102190,   -12153662,
+        8342584,    -5496792,     3450269,    -2043076,     1125974,
+        -566056,      251267,      -92776,       24929,       -3092,
+  },
+  {
+          76380,     -203637,      429635,     -788115,     1308008,
+       -2005032,     2871596,    -3865698,     4899561,    -5828392,
+        6438666,    -6433231,     5406001,    -2788677,    -2275141,
+       11256337,   -27209445,    58416492,  -140094576,   960438156,
+      302215143,  -144582912,    96449551,   -70902857,    53895839,
+      -41243927,    31326119,   -23403342,    17082646,   -12111846,
+        8293544,    -5449743,     3410156,    -2011828,     1103542,
+        -551246,      242381,      -88055,       22837,       -2447,
+  },
+  {
+          75929,     -202366,      426385,     -780752,     1292994,
+       -1976949,     2822662,    -3785308,     4773886,    -5640033,
+        6166322,    -6051216,     4883313,    -2086928,    -3206406,
+       12490563,   -28870708,    60761235,  -143819742,   956306263,
+      310520805,  -147300709,    97817936,   -71664995,    54320820,
+      -41464542,    31420099,   -23420675,    17056855,   -12065477,
+        8241284,    -5400494,     3368595,    -1979669,     1080564,
+        -536129,      233332,      -83256,       20711,       -1788,
+  },
+  {
+          75452,     -201030,      423002,     -773153,     1277600,
+       -1948305,     2772957,    -3703931,     4647042,    -5450422,
+        5892824,    -5668457,     4360778,    -1386978,    -4133044,
+       13715341,   -30513854,    63069790,  -147454543,   952067363,
+      318850309,  -149985853,    99158260,   -72404609,    54727887,
+      -41671036,    31503097,   -23429621,    17024802,   -12014553,
+        8185808,    -5349051,     3325595,    -1946605,     1057046,
+        -520706,      224122,      -78378,       18550,       -1115,
+  },
+  {
+          74950,     -199629,      419488,     -765321,     1261835,
+       -1919114,     2722503,    -3621602,     4519082,    -5259631,
+        5618276,    -5285095,     3838582,     -689070,    -5054742,
+       14930273,   -32138388,    65341585,  -150998810,   947722365,
+      327202112,  -152637194,   100469903,   -73121339,    55116826,
+      -41863283,    31575044,   -23430147,    16986475,   -11959074,
+        8127124,    -5295423,     3281164,    -1912645,     1032994,
+        -504983,      214753,      -73422,       16354,        -428,
+  },
+  {
+          74424,     -198166,      415845,     -757263,     1245707,
+       -1889390,     2671323,    -3538355,     4390057,    -5067734,
+        5342781,    -4901270,     3316911,        6551,    -5971187,
+       16134967,   -33743826,    67576066,  -154452395,   943272204,
+      335574666,  -155253585,   101752257,   -73814833,    55487428,
+      -42041161,    31635873,   -23422221,    16941863,   -11899042,
+        8065238,    -5239621,     3235311,    -1877795,     1008412,
+        -488962,      205229,      -68391,       14124,         273,
+  },
+  {
+          73874,     -196640,      412077,     -748982,     1229225,
+       -1859146,     2619439,    -3454225,     4260018,    -4874807,
+        5066442,    -4517122,     2795953,      699645,    -6882073,
+       17329034,   -35329692,    69772694,  -157815176,   938717835,
+      343966409,  -157833880,   103004718,   -74484744,    55839489,
+      -42204553,    31685522,   -23405816,    16890958,   -11834460,
+        8000160,    -5181653,     3188046,    -1842063,      983307,
+        -472649,      195551,      -63285,       11862,         986,
+  },
+  {
+          73300,     -195054,      408185,     -740484,     1212397,
+       -1828398,     2566874,    -3369248,     4129017,    -4680923,
+        4789363,    -4132791,     2275891,     1389972,    -7787094,
+       18512094,   -36895516,    71930945,  -161087052,   934060237,
+      352375773,  -160376939,   104226689,   -75130733,    56172812,
+      -42353349,    31723933,   -23380905,    16833755,   -11765334,
+        7931900,    -5121532,     3139380,    -1805459,      957685,
+        -456046,      185722,      -58106,        9566,        1714,
+  },
+  {
+          72703,     -193408,      404172,     -731772,     1195232,
+       -1797159,     2513650,    -3283457,     3997106,    -4486156,
+        4511647,    -3748417,     1756910,     2077295,    -8685949,
+       19683768,   -38440842,    74050311,  -164267944,   929300407,
+      360801178,  -162881623,   105417581,   -75752468,    56487206,
+      -42487440,    31751051,   -23347467,    16770251,   -11691670,
+        7860468,    -5059270,     3089322,    -1767990,      931552,
+        -439159,      175744,      -52855,        7238,        2454,
+  },
+  {
+          72083,     -191704,      400041,     -722853,     1177737,
+       -1765444,     2459792,    -3196889,     3864337,    -4290580,
+        4233397,    -3364137,     1239191,     2761378,    -9578339,
+       20843687,   -39965220,    76130299,  -167357800,   924439367,
+      369241039,  -165346798,   106576813,   -76349622,    56782484,
+      -42606725,    31766824,   -23305482,    16700443,   -11613476,
+        7785877,    -4994879,     3037885,    -1729666,      904916,
+        -421992,      165620,      -47533,        4879,        3208,
+  },
+  {
+          71443,     -189943,      395794,     -713730,     1159922,
+       -1733267,     2405321,    -3109578,     3730763,    -4094270,
+        3954715,    -2980091,      722917,     3441987,   -10463968,
+       21991485,   -41468210,    78170432,  -170356587,   919478158,
+      377693761,  -167771335,   107703811,   -76921877,    57058468,
+      -42711106,    31771207,   -23254932,    16624334,   -11530763,
+        7708142,    -4928373,     2985080,    -1690497,      877782,
+        -404548,      155353,      -42142,        2489,        3974,
+  },
+  {
+          70780,     -188126,      391434,     -704410,     1141795,
+       -1700643,     2350261,    -3021560,     3596435,    -3897301,
+        3675703,    -2596415,      208268,     4118890,   -11342547,
+       23126801,   -42949382,    80170251,  -173264296,   914417841,
+      386157742,  -170154106,   108798009,   -77468924,    57314983,
+      -42800491,    31764156,   -23195806,    16541926,   -11443543,
+        7627276,    -4859766,     2930920,    -1650492,      850159,
+        -386834,      144946,      -36684,          69,        4753,
+  },
+  {
+          70098,     -186256,      386964,     -694896,     1123366,
+       -1667586,     2294635,    -2932871,     3461405,    -3699745,
+        3396464,    -2213247,     -304576,     4791859,   -12213785,
+       24249283,   -44408314,    82129310,  -176080941,   909259500,
+      394631374,  -172493992,   109858851,   -77990458,    57551864,
+      -42874793,    31745632,   -23128092,    16453226,   -11351828,
+        7543295,    -4789075,     2875418,    -1609661,      822053,
+        -368854,      134402,      -31159,       -2381,        5544,
+  },
+  {
+          69395,     -184332,      382386,     -685193,     1104642,
+       -1634111,     2238467,    -2843546,     3325726,    -3501677,
+        3117099,    -1830723,     -815439,     5460667,   -13077401,
+       25358581,   -45844596,    84047181,  -178806559,   904004238,
+      403113039,  -174789876,   110885788,   -78486185,    57768950,
+      -42933930,    31715600,   -23051784,    16358241,   -11255635,
+        7456218,    -4716314,     2818589,    -1568015,      793472,
+        -350613,      123723,      -25571,       -4859,        6347,
+  },
+  {
+          68673,     -182357,      377703,     -675308,     1085634,
+       -1600233,     2181781,    -2753620,     3189449,    -3303172,
+        2837711,    -1448978,    -1324143,     6125087,   -13933112,
+       26454355,   -47257825,    85923451,  -181441208,   898653176,
+      411601116,  -177040648,   111878279,   -78955816,    57966085,
+      -42977824,    31674029,   -22966877,    16256982,   -11154980,
+        7366061,    -4641502,     2760445,    -1525565,      764423,
+        -332115,      112912,      -19919,       -7366,        7163,
+  },
+  {
+          67932,     -180331,      372917,     -665244,     1066349,
+       -1565967,     2124598,    -2663131,     3052628,    -3104302,
+        2558400,    -1068148,    -1830513,     6784899,   -14780643,
+       27536268,   -48647610,    87757723,  -183984971,   893207459,
+      420093975,  -179245204,   112835793,   -79399072,    58143123,
+      -43006405,    31620892,   -22873370,    16149461,   -11049882,
+        7272846,    -4564657,     2701002,    -1482322,      734915,
+        -313367,      101973,      -14206,       -9900,        7990,
+  },
+  {
+          67173,     -178257,      368032,     -655008,     1046796,
+       -1531327,     2066944,    -2572112,     2915314,    -2905141,
+        2279266,     -688365,    -2334376,     7439881,   -15619721,
+       28603990,   -50013569,    89549618,  -186437952,   887668246,
+      428589984,  -181402444,   113757810,   -79815681,    58299922,
+      -43019605,    31556167,   -22771266,    16035694,   -10940360,
+        7176593,    -4485796,     2640276,    -1438297,      704957,
+        -294373,       90910,       -8433,      -12461,        8829,
+  },
+  {
+          66396,     -176135,      363050,     -644604,     1026986,
+       -1496328,     2008841,    -2480600,     2777559,    -2705763,
+        2000410,     -309764,    -2835559,     8089817,   -16450077,
+       29657199,   -51355330,    91298770,  -188800276,   882036719,
+      437087501,  -183511277,   114643815,   -80205380,    58436349,
+      -43017364,    31479834,   -22660568,    15915697,   -10826438,
+        7077323,    -4404940,     2578281,    -1393504,      674555,
+        -275140,       79724,       -2603,      -15048,        9679,
+  },
+  {
+          65603,     -173967,      357974,     -634036,     1006926,
+       -1460986,     1950314,    -2388631,     2639416,    -2506241,
+        1721932,       67525,    -3333893,     8734491,   -17271446,
+       30695577,   -52672531,    93004832,  -191072091,   876314078,
+      445584884,  -185570617,   115493307,   -80567913,    58552274,
+      -42999625,    31391878,   -22541286,    15789491,   -10708138,
+        6975061,    -4322109,     2515036,    -1347954,      643720,
+        -255672,       68420,        3283,      -17660,       10541,
+  },
+  {
+          64793,     -171753,      352807,     -623312,      986626,
+       -1425316,     1891386,    -2296241,     2500936,    -2306648,
+        1443931,      443369,    -3829207,     9373691,   -18083569,
+       31718814,   -53964821,    94667473,  -193253569,   870501540,
+      454080483,  -187579387,   116305792,   -80903033,    58647578,
+      -42966337,    31292291,   -22413431,    15657097,   -10585487,
+        6869831,    -4237325,     2450555,    -1301660,      612459,
+        -235975,       57001,        9223,      -20296,       11413,
+  },
+  {
+          63967,     -169497,      347551,     -612435,      966095,
+       -1389332,     1832081,    -2203465,     2362171,    -2107057,
+        1166505,      817639,    -4321336,    10007208,   -18886188,
+       32726606,   -55231857,    96286376,  -195344901,   864600342,
+      462572645,  -189536515,   117080787,   -81210504,    58722147,
+      -42917456,    31181064,   -22277018,    15518539,   -10458510,
+        6761657,    -4150608,     2384859,    -1254635,      580782,
+        -216055,       45470,       15216,      -22955,       12295,
+  },
+  {
+          63126,     -167198,      342209,     -601411,      945342,
+       -1353049,     1772422,    -2110339,     2223174,    -1907539,
+         889753,     1190205,    -4810113,    10634835,   -19679053,
+       33718656,   -56473309,    97861242,  -197346302,   858611737,
+      471059714,  -191440940,   117817820,   -81490094,    58775872,
+      -42852942,    31058196,   -22132064,    15373845,   -10327237,
+        6650568,    -4061983,     2317963,    -1206892,      548699,
+        -195919,       33832,       21259,      -25637,       13188,
+  },
+  {
+          62270,     -164859,      336784,     -590245,      924376,
+       -1316484,     1712434,    -2016898,     2083994,    -1708167,
+         613772,     1560941,    -5295375,    11256368,   -20461916,
+       34694674,   -57688856,    99391789,  -199258007,   852536996,
+      479540031,  -193291605,   118516427,   -81741584,    58808655,
+      -42772760,    30923688,   -21978590,    15223043,   -10191699,
+        6536591,    -3971472,     2249887,    -1158445,      516218,
+        -175572,       22089,       27351,      -28341,       14091,
+  },
+  {
+          61401,     -162480,      331279,     -578943,      903207,
+       -1279651,     1652140,    -1923179,     1944685,    -1509012,
+         338658,     1929718,    -5776961,    11871607,   -21234534,
+       35654375,   -58878188,   100877749,  -201080273,   846377407,
+      488011932,  -195087465,   119176158,   -81964762,    58820402,
+      -42676881,    30777548,   -21816620,    15066164,   -10051927,
+        6419756,    -3879101,     2180650,    -1109308,      483350,
+        -155021,       10245,       33489,      -31065,       15004,
+  },
+  {
+          60518,     -160063,      325697,     -567509,      881843,
+       -1242564,     1591564,    -1829217,     1805297,    -1310146,
+          64507,     2296411,    -6254710,    12480353,   -21996669,
+       36597484,   -60041004,   102318873,  -202813378,   840134277,
+      496473752,  -196827483,   119796571,   -82159425,    58811027,
+      -42565283,    30619785,   -21646182,    14903242,    -9907955,
+        6300092,    -3784893,     2110272,    -1059496,      450104,
+        -134272,       -1695,       39672,      -33810,       15926,
+  },
+  {
+          59622,     -157610,      320040,     -555950,      860295,
+       -1205240,     1530729,    -1735047,     1665881,    -1111640,
+        -208584,     2660896,    -6728465,    13082411,   -22748087,
+       37523730,   -61177015,   103714926,  -204457623,   833808926,
+      504923825,  -198510629,   120377236,   -82325379,    58780451,
+      -42437947,    30450413,   -21467305,    14734314,    -9759818,
+        6177631,    -3688877,     2038772,    -1009023,      416490,
+        -113331,      -13729,       45897,      -36573,       16857,
+  },
+  {
+          58714,     -155121,      314312,     -544270,      838570,
+       -1167694,     1469659,    -1640705,     1526488,     -913563,
+        -480522,     3023051,    -7198069,    13677589,   -23488558,
+       38432850,   -62285943,   105065690,  -206013327,   827402693,
+      513360483,  -200135886,   120917736,   -82462441,    58728604,
+      -42294861,    30269453,   -21280024,    14559416,    -9607554,
+        6052406,    -3591077,     1966172,     -957905,      382520,
+         -92206,      -25852,       52163,      -39355,       17796,
+  },
+  {
+          57794,     -152599,      308515,     -532474,      816679,
+       -1129940,     1408378,    -1546226,     1387168,     -715987,
+        -751213,     3382752,    -7663369,    14265699,   -24217860,
+       39324589,   -63367520,   106370964,  -207480833,   820916930,
+      521782054,  -201702244,   121417662,   -82570434,    58655421,
+      -42136019,    30076927,   -21084374,    14378591,    -9451202,
+        5924451,    -3491523,     1892493,     -906156,      348202,
+         -70902,      -38060,       58467,      -42153,       18744,
+  },
+  {
+          56864,     -150044,      302652,     -520569,      794631,
+       -1091994,     1346910,    -1451645,     1247973,     -518981,
+       -1020564,     3739879,    -8124214,    14846556,   -24935771,
+       40198698,   -64421487,   107630563,  -208860503,   814353008,
+      530186868,  -203208703,   121876620,   -82649195,    58560844,
+      -41961420,    29872862,   -20880396,    14191880,    -9290801,
+        5793800,    -3390242,     1817756,     -853793,      313549,
+         -49427,      -50349,       64807,      -44968,       19700,
+  },
+  {
+          55922,     -147458,      296725,     -508559,      772435,
+       -1053870,     1285278,    -1356998,     1108952,     -322613,
+       -1288482,     4094314,    -8580453,    15419977,   -25642078,
+       41054936,   -65447600,   108844317,  -210152719,   807712309,
+      538573255,  -204654276,   122294225,   -82698566,    58444826,
+      -41771068,    29657290,   -20668133,    13999329,    -9126394,
+        5660491,    -3287263,     1741984,     -800831,      278571,
+         -27787,      -62716,       71181,      -47798,       20664,
+  },
+  {
+          54971,     -144842,      290739,     -496449,      750100,
+       -1015585,     1223505,    -1262318,      970154,     -126952,
+       -1554877,     4445938,    -9031939,    15985784,   -26336571,
+       41893069,   -66445620,   110012074,  -211357885,   800996234,
+      546939543,  -206037984,   122670107,   -82718402,    58307323,
+      -41564974,    29430246,   -20447631,    13800986,    -8958025,
+        5524559,    -3182616,     1665200,     -747287,      243278,
+          -5990,      -75155,       77587,      -50641,       21635,
+  },
+  {
+          54011,     -142198,      284695,     -484245,      727635,
+        -977153,     1161615,    -1167641,      831630,       67934,
+       -1819658,     4794636,    -9478528,    16543800,   -27019045,
+       42712870,   -67415325,   111133696,  -212476423,   794206194,
+      555284061,  -207358860,   123003904,   -82708565,    58148301,
+      -41343154,    29191772,   -20218939,    13596899,    -8785738,
+        5386044,    -3076332,     1587426,     -693177,      207683,
+          15958,      -87663,       84022,      -53498,       22613,
+  },
+  {
+          53042,     -139528,      278596,     -471953,      705050,
+        -938590,     1099631,    -1073002,      693428,      261977,
+       -2082736,     5140293,    -9920077,    17093855,   -27689300,
+       43514119,   -68356498,   112209064,  -213508778,   787343618,
+      563605141,  -208615949,   123295271,   -82668930,    57967733,
+      -41105630,    28941911,   -19982109,    13387122,    -8609581,
+        5244985,    -2968443,     1508686,     -638519,      171796,
+          38048,     -100236,       90485,      -56367,       23598,
+  },
+  {
+          52065,     -136831,      272446,     -459577,      682354,
+        -899909,     1037577,     -978434,      555597,      455111,
+       -2344023,     5482795,   -10356445,    17635778,   -28347143,
+       44296605,   -69268938,   113238072,  -214455411,   780409946,
+      571901113,  -209808307,   123543872,   -82599378,    57765600,
+      -40852428,    28680712,   -19737198,    13171708,    -8429602,
+        5101422,    -2858980,     1429004,     -583329,      135630,
+          60274,     -112868,       96973,      -59246,       24589,
+  },
+  {
+          51080,     -134111,      266247,     -447123,      659556,
+        -861127,      975476,     -883973,      418186,      647269,
+       -2603430,     5822031,   -10787493,    18169406,   -28992383,
+       45060123,   -70152451,   114220632,  -215316806,   773406633,
+      580170310,  -210935002,   123749386,   -82499803,    57541890,
+      -40583582,    28408229,   -19484264,    12950714,    -8245851,
+        4955397,    -2747976,     1348405,     -527626,       99195,
+          82628,     -125557,      103483,      -62136,       25586,
+  },
+  {
+          50089,     -131367,      260001,     -434597,      636665,
+        -822258,      913350,     -789651,      281243,      838386,
+       -2860873,     6157891,   -11213087,    18694577,   -29624836,
+       45804477,   -71006856,   115156671,  -216093465,   766335145,
+      588411068,  -211995114,   123911503,   -82370109,    57296599,
+      -40299132,    28124517,   -19223369,    12724199,    -8058380,
+        4806953,    -2635465,     1266915,     -471426,       62505,
+         105103,     -138297,      110014,      -65034,       26588,
+  },
+  {
+          49091,     -128603,      253713,     -422003,      613690,
+        -783317,      851222,     -695503,      144816,     1028397,
+       -3116265,     6490267,   -11633094,    19211133,   -30244323,
+       46529475,   -71831982,   116046133,  -216785908,   759196962,
+      596621725,  -212987737,   124029928,   -82210208,    57029730,
+      -39999121,    27829639,   -18954577,    12492224,    -7867242,
+        4656133,    -2521481,     1184558,     -414748,       25571,
+         127691,     -151084,      116563,      -67940,       27595,
+  },
+  {
+          48087,     -125818,      247384,     -409346,      590641,
+        -744319,      789117,     -601562,        8951,     1217238,
+       -3369522,     6819051,   -12047382,    19718919,   -30850671,
+       47234938,   -72627671,   116888976,  -217394676,   751993577,
+      604800622,  -213911977,   124104378,   -82020025,    56741294,
+      -39683600,    27523660,   -18677957,    12254851,    -7672492,
+        4502984,    -2406059,     1101360,     -357611,      -11595,
+         150384,     -163913,      123127,      -70852,       28607,
+  },
+  {
+          47077,     -123014,      241018,     -396633,      567527,
+        -705278,      727055,     -507861,     -126304,     1404845,
+       -3620561,     7144138,   -12455823,    20217786,   -31443711,
+       47920689,   -73393772,   117685177,  -217920328,   744726491,
+      612946102,  -214766952,   124134583,   -81799492,    56431310,
+      -39352625,    27206651,   -18393580,    12012147,    -7474185,
+        4347549,    -2289234,     1017349,     -300032,      -48979,
+         173174,     -176780,      129704,      -73770,       29623,
+  },
+  {
+          46064,     -120194,      234616,     -383868,      544356,
+        -666210,      665060,     -414434,     -260902,     1591155,
+       -3869300,     7465427,   -12858292,    20707586,   -32023279,
+       48586564,   -74130148,   118434724,  -218363440,   737397221,
+      621056513,  -215551795,   124120287,   -81548554,    56099805,
+      -39006258,    26878685,   -18101521,    11764180,    -7272381,
+        4189877,    -2171044,      932550,     -242031,      -86570,
+         196054,     -189680,      136291,      -76692,       30642,
+  },
+  {
+          45045,     -117357,      228183,     -371056,      521138,
+        -627128,      603154,     -321314,     -394799,     1776106,
+       -4115658,     7782813,   -13254665,    21188177,   -32589220,
+       49232402,   -74836673,   119137626,  -218724608,   730007292,
+      629130207,  -216265652,   124061248,   -81267165,    55746812,
+      -38644567,    26539841,   -17801855,    11511017,    -7067137,
+        4030014,    -2051524,      846991,     -183627,     -124355,
+         219016,     -202608,      142887,      -79617,       31665,
+  },
+  {
+          44024,     -114505,      221721,     -358204,      497881,
+        -588048,      541360,     -228532,     -527948,     1959637,
+       -4359556,     8096199,   -13644823,    21659419,   -33141380,
+       49858054,   -75513231,   119793902,  -219004446,   722558242,
+      637165541,  -216907685,   123957238,   -80955290,    55372375,
+      -38267625,    26190201,   -17494664,    11252733,    -6858516,
+        3868011,    -1930713,      760700,     -124840,     -162321,
+         242050,     -215560,      149488,      -82544,       32691,
+  },
+  {
+          42999,     -111640,      215232,     -345315,      474596,
+        -548984,      479699,     -136122,     -660304,     2141688,
+       -4600915,     8405486,   -14028648,    22121178,   -33679612,
+       50463374,   -76159716,   120403591,  -219203585,   715051616,
+      645160877,  -217477068,   123808041,   -80612906,    54976543,
+      -37875510,    25829852,   -17180031,    10989400,    -6646579,
+        3703917,    -1808649,      673704,      -65689,     -200454,
+         265150,     -228531,      156092,      -85471,       33719,
+  },
+  {
+          41971,     -108764,      208719,     -332395,      451289,
+        -509950,      418193,      -44115,     -791823,     2322198,
+       -4839658,     8710579,   -14406025,    22573321,   -34203776,
+       51048228,   -76776034,   120966746,  -219322674,   707488971,
+      653114581,  -217972990,   123613459,   -80239997,    54559373,
+      -37468309,    25458885,   -16858043,    10721096,    -6431390,
+        3537783,    -1685371,      586033,       -6193,     -238742,
+         288307,     -241517,      162697,      -88398,       34749,
+  },
+  {
+          40941,     -105876,      202186,     -319449,      427971,
+        -470960,      356864,       47458,     -922460,     2501108,
+       -5075709,     9011382,   -14776842,    23015721,   -34713735,
+       51612487,   -77362104,   121483434,  -219362380,   699871874,
+      661025026,  -218394656,   123373303,   -79836561,    54120932,
+      -37046111,    25077396,   -16528787,    10447897,    -6213014,
+        3369661,    -1560918,      497715,       53627,     -277172,
+         311512,     -254511,      169299,      -91322,       35780,
+  },
+  {
+          39910,     -102979,      195634,     -306483,      404651,
+        -432030,      295734,      138564,    -1052172,     2678360,
+       -5308993,     9307803,   -15140988,    23448254,   -35209360,
+       52156032,   -77917851,   121953738,  -219323386,   692201900,
+      668890591,  -218741285,   123087404,   -79402605,    53661292,
+      -36609012,    24685482,   -16192358,    10169885,    -5991517,
+        3199603,    -1435331,      408780,      113750,     -315729,
+         334758,     -267510,      175897,      -94244,       36812,
+  },
+  {
+          38878,     -100074,      189067,     -293501,      381336,
+        -393171,      234824,      229174,    -1180916,     2853898,
+       -5539437,     9599753,   -15498359,    23870802,   -35690526,
+       52678749,   -78443216,   122377756,  -219206391,   684480632,
+      676709662,  -219012113,   122755602,   -78938147,    53180535,
+      -36157114,    24283249,   -15848849,     9887143,    -5766969,
+        3027664,    -1308650,      319256,      174156,     -354400,
+         358035,     -280508,      182487,      -97162,       37845,
+  },
+};
+/**
+  * @}
+  */
+
+/** @defgroup USBD_AUDIO_SRC_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  AUDIO_SRC_Sat16
+  *         Rounds a Q30 accumulator and saturates it to a 16-bit sample.
+  * @param  acc: accumulator
+  * @retval sample
+  */
+static inline int32_t AUDIO_SRC_Sat16(int64_t acc)
+{
+  int32_t smp = (int32_t)((acc + (1LL << 29)) >> 30);
+
+  if (smp > 32767)
+  {
+    smp = 32767;
+  }
+  else if (smp < -32768)
+  {
+    smp = -32768;
+  }
+
+  return smp;
+}
+
+/**
+  * @brief  AUDIO_SRC_Reset
+  *         Clears the history and restarts the phase.
+  * @param  src: converter state
+  * @retval None
+  */
+void AUDIO_SRC_Reset(AUDIO_SRC_TypeDef *src)
+{
+  (void)memset(src, 0, sizeof(AUDIO_SRC_TypeDef));
+}
+
+/**
+  * @brief  AUDIO_SRC_Process
+  *         Converts a block of interleaved 16-bit stereo frames.
+  * @param  src: converter state
+  * @param  in: input frames at 44.1kHz, L in the low half-word
+  * @param  frames: number of input frames
+  * @param  out: output frames at 48kHz, room for AUDIO_SRC_OUT_FRAMES(frames)
+  * @retval number of output frames
+  */
+uint32_t AUDIO_SRC_Process(AUDIO_SRC_TypeDef *src, const uint32_t *in,
+                           uint32_t frames, uint32_t *out)
+{
+  uint32_t pos = src->pos;
+  uint32_t phase = src->phase;
+  uint32_t count = 0U;
+
+  for (uint32_t i = 0U; i < frames; i++)
+  {
+    src->hist[pos] = in[i];
+    src->hist[pos + AUDIO_SRC_TAPS] = in[i];
+    pos = (pos + 1U < AUDIO_SRC_TAPS) ? (pos + 1U) : 0U;
+
+    /* Every output whose interpolated position falls on this input frame */
+    while (phase < AUDIO_SRC_L)
+    {
+      const uint32_t *win = &src->hist[pos];
+      int64_t acc_l = 0;
+      int64_t acc_r = 0;
+
+      if (phase < (AUDIO_SRC_L / 2U))
+      {
+        const int32_t *coef = AUDIO_SRC_Coef[phase];
+
+        for (uint32_t k = 0U; k < AUDIO_SRC_TAPS; k++)
+        {
+          uint32_t frame = win[k];
+          acc_l += (int64_t)(int16_t)(frame & 0xFFFFU) * coef[k];
+          acc_r += (int64_t)((int32_t)frame >> 16) * coef[k];
+        }
+      }
+      else
+      {
+        /* Upper half of the branches is the lower half mirrored in time */
+        const int32_t *coef = &AUDIO_SRC_Coef[AUDIO_SRC_L - 1U - phase][AUDIO_SRC_TAPS - 1U];
+
+        for (uint32_t k = 0U; k < AUDIO_SRC_TAPS; k++)
+        {
+          uint32_t frame = win[k];
+          acc_l += (int64_t)(int16_t)(frame & 0xFFFFU) * *coef;
+          acc_r += (int64_t)((int32_t)frame >> 16) * *coef;
+          coef--;
+        }
+      }
+
+      out[count++] = ((uint32_t)AUDIO_SRC_Sat16(acc_l) & 0xFFFFU) |
+                     ((uint32_t)AUDIO_SRC_Sat16(acc_r) << 16);
+      phase += AUDIO_SRC_M;
+    }
+    phase -= AUDIO_SRC_L;
+  }
+
+  src->pos = pos;
+  src->phase = phase;
+
+  return count;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
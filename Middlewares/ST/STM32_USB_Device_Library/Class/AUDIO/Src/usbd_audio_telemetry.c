@@ -0,0 +1,200 @@
+/**
+  ******************************************************************************
+  * @file    usbd_audio_telemetry.c
+  * @brief   Streaming telemetry counters.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                Telemetry
+  *          ===================================================================
+  *           Counters of the events that make playback glitch (underruns,
+  *           overruns, dropped and incomplete isochronous transfers), plus the
+  *           buffer fill level and feedback value range. Counters are bumped
+  *           with LDREX/STREX from whatever interrupt sees the event; the fill
+  *           and feedback statistics are only updated from the feedback work.
+  *           Always built, the cost is a few cycles per event. Two boot
+  *           timestamps, to attach and to first audio, survive a reset of
+  *           the counters.
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_audio_telemetry.h"
+#include "stm32f4xx_hal.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_TELEMETRY
+  * @brief Streaming telemetry counters
+  * @{
+  */
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Private_Variables
+  * @{
+  */
+AUDIO_TLM_TypeDef AUDIO_Tlm =
+{
+  .fill_min = 0xFFFFFFFFU,
+  .fb_min = 0xFFFFFFFFU,
+};
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_AUDIO_TELEMETRY_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  AUDIO_TLM_Reset
+  *         Clears every counter and statistic.
+  * @retval None
+  */
+void AUDIO_TLM_Reset(void)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t *dst = (uint32_t *)&AUDIO_Tlm;
+  uint32_t attach;
+  uint32_t audio;
+
+  __disable_irq();
+
+  attach = AUDIO_Tlm.boot_attach_us;
+  audio = AUDIO_Tlm.boot_audio_us;
+
+  for (uint32_t i = 0U; i < sizeof(AUDIO_Tlm) / sizeof(uint32_t); i++)
+  {
+    dst[i] = 0U;
+  }
+
+  AUDIO_Tlm.fill_min = 0xFFFFFFFFU;
+  AUDIO_Tlm.fb_min = 0xFFFFFFFFU;
+  AUDIO_Tlm.boot_attach_us = attach;
+  AUDIO_Tlm.boot_audio_us = audio;
+
+  __set_PRIMASK(primask);
+}
+
+/**
+  * @brief  AUDIO_TLM_Read
+  *         Takes a consistent copy of the telemetry block.
+  * @param  snap: copy
+  * @retval None
+  */
+void AUDIO_TLM_Read(AUDIO_TLM_TypeDef *snap)
+{
+  uint32_t primask = __get_PRIMASK();
+
+  __disable_irq();
+  *snap = AUDIO_Tlm;
+  __set_PRIMASK(primask);
+
+  if (snap->fill_samples == 0U)
+  {
+    snap->fill_min = 0U;
+    snap->fb_min = 0U;
+  }
+}
+
+/**
+  * @brief  AUDIO_TLM_Fill
+  *         Adds a buffer fill level sample.
+  * @param  frames: frames buffered
+  * @param  capacity: frames the buffers can hold
+  * @retval None
+  */
+void AUDIO_TLM_Fill(uint32_t frames, uint32_t capacity)
+{
+  uint32_t bucket = (frames * AUDIO_TLM_FILL_BUCKETS) / capacity;
+
+  if (bucket >= AUDIO_TLM_FILL_BUCKETS)
+  {
+    bucket = AUDIO_TLM_FILL_BUCKETS - 1U;
+  }
+
+  AUDIO_Tlm.fill_samples++;
+  AUDIO_Tlm.fill_hist[bucket]++;
+
+  if (frames < AUDIO_Tlm.fill_min)
+  {
+    AUDIO_Tlm.fill_min = frames;
+  }
+  if (frames > AUDIO_Tlm.fill_max)
+  {
+    AUDIO_Tlm.fill_max = frames;
+  }
+}
+
+/**
+  * @brief  AUDIO_TLM_Feedback
+  *         Records a new feedback value.
+  * @param  fb: feedback, 10.14 shifted left by 8
+  * @retval None
+  */
+void AUDIO_TLM_Feedback(uint32_t fb)
+{
+  AUDIO_Tlm.fb_last = fb;
+
+  if (fb < AUDIO_Tlm.fb_min)
+  {
+    AUDIO_Tlm.fb_min = fb;
+  }
+  if (fb > AUDIO_Tlm.fb_max)
+  {
+    AUDIO_Tlm.fb_max = fb;
+  }
+}
+
+/**
+  * @brief  AUDIO_TLM_Micros
+  *         Microseconds since HAL_Init, from the HAL tick and the SysTick
+  *         count, so it stays right across the switch to the PLL clock.
+  * @retval time in us
+  */
+uint32_t AUDIO_TLM_Micros(void)
+{
+  uint32_t tick;
+  uint32_t val;
+  uint32_t load;
+
+  /* Read again if the tick moved while the counter was sampled */
+  do
+  {
+    tick = HAL_GetTick();
+    val = SysTick->VAL;
+    load = SysTick->LOAD;
+  } while (tick != HAL_GetTick());
+
+  return (tick * 1000U) + (((load - val) * 1000U) / (load + 1U));
+}
+
+/**
+  * @brief  AUDIO_TLM_Stamp
+  *         Records the time since reset, only the first time.
+  * @param  stamp: boot timestamp field of AUDIO_Tlm
+  * @retval None
+  */
+void AUDIO_TLM_Stamp(uint32_t *stamp)
+{
+  if (*stamp == 0U)
+  {
+    *stamp = AUDIO_TLM_Micros();
+  }
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
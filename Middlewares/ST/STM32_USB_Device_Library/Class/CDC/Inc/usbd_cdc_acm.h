@@ -0,0 +1,119 @@
+/**
+  ******************************************************************************
+  * @file    usbd_cdc_acm.h
+  * @brief   Header file for the usbd_cdc_acm.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_ACM_H
+#define __USBD_CDC_ACM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CDC_ACM
+  * @brief CDC-ACM virtual COM port
+  * @{
+  */
+
+
+/** @defgroup USBD_CDC_ACM_Exported_Defines
+  * @{
+  */
+/* Interface numbers of the function in the configuration it is part of */
+#ifndef CDC_ACM_CMD_ITF_NBR
+#define CDC_ACM_CMD_ITF_NBR                           0x02U
+#endif /* CDC_ACM_CMD_ITF_NBR */
+#define CDC_ACM_DATA_ITF_NBR                          (CDC_ACM_CMD_ITF_NBR + 1U)
+
+#define CDC_ACM_IN_EP                                 0x82U  /* bulk, device to host */
+#define CDC_ACM_OUT_EP                                0x02U  /* bulk, host to device */
+#define CDC_ACM_CMD_EP                                0x83U  /* interrupt, notifications */
+
+#define CDC_ACM_DATA_FS_MAX_PACKET_SIZE               64U
+#define CDC_ACM_CMD_PACKET_SIZE                       8U
+#define CDC_ACM_FS_BINTERVAL                          0x10U
+
+/* Largest single transmit, sent as several bulk packets */
+#ifndef CDC_ACM_TX_SIZE
+#define CDC_ACM_TX_SIZE                               256U
+#endif /* CDC_ACM_TX_SIZE */
+
+#define USB_CDC_ACM_IAD_DESC_SIZ                      0x08U
+#define USB_CDC_ACM_CONFIG_DESC_SIZ                   (USB_LEN_CFG_DESC + USB_CDC_ACM_IAD_DESC_SIZ + \
+                                                       USB_LEN_IF_DESC + 5U + 5U + 4U + 5U + USB_LEN_EP_DESC + \
+                                                       USB_LEN_IF_DESC + USB_LEN_EP_DESC + USB_LEN_EP_DESC)
+
+#define CDC_ACM_SEND_ENCAPSULATED_COMMAND             0x00U
+#define CDC_ACM_GET_ENCAPSULATED_RESPONSE             0x01U
+#define CDC_ACM_SET_LINE_CODING                       0x20U
+#define CDC_ACM_GET_LINE_CODING                       0x21U
+#define CDC_ACM_SET_CONTROL_LINE_STATE                0x22U
+#define CDC_ACM_SEND_BREAK                            0x23U
+
+/* SET_CONTROL_LINE_STATE wValue: DTR is set while a terminal has the port open */
+#define CDC_ACM_LINE_DTR                              0x0001U
+
+#define USB_DESC_TYPE_IAD                             0x0BU
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CDC_ACM_Exported_TypesDefinitions
+  * @{
+  */
+typedef struct
+{
+  void (*Init)(void);
+  void (*DeInit)(void);
+  void (*LineState)(uint16_t state);                   /* CDC_ACM_LINE_xxx, from the OTG interrupt */
+  void (*Receive)(const uint8_t *buf, uint32_t len);   /* from the OTG interrupt */
+  void (*Tick)(void);                                  /* every SOF while configured */
+} USBD_CDC_ACM_ItfTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CDC_ACM_Exported_Variables
+  * @{
+  */
+extern USBD_ClassTypeDef USBD_CDC_ACM;
+#define USBD_CDC_ACM_CLASS &USBD_CDC_ACM
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CDC_ACM_Exported_Functions
+  * @{
+  */
+uint8_t USBD_CDC_ACM_RegisterInterface(USBD_CDC_ACM_ItfTypeDef *fops);
+uint8_t USBD_CDC_ACM_Transmit(USBD_HandleTypeDef *pdev, const uint8_t *buf, uint16_t len);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_CDC_ACM_H */
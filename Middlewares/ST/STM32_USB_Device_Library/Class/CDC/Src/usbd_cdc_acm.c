@@ -0,0 +1,503 @@
+/**
+  ******************************************************************************
+  * @file    usbd_cdc_acm.c
+  * @brief   CDC-ACM virtual COM port class.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                CDC-ACM
+  *          ===================================================================
+  *           A communication interface with its notification endpoint and a
+  *           data interface with two bulk endpoints, grouped by an interface
+  *           association descriptor so the host binds one driver to both.
+  *           Meant to be combined with the audio function by usbd_composite.c.
+  *           Like the HID class, the state is kept here because pClassData and
+  *           pUserData belong to the audio class.
+  *
+  *           The bulk endpoints cannot delay the audio: the OTG core serves the
+  *           periodic (isochronous) endpoints first in every frame, each IN
+  *           endpoint has its own TX FIFO, and the OUT endpoint is only armed
+  *           once the last packet has been handed over, so bulk data never
+  *           piles up in the shared RX FIFO.
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_cdc_acm.h"
+#include "usbd_ctlreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_CDC_ACM
+  * @brief CDC-ACM virtual COM port
+  * @{
+  */
+
+/** @defgroup USBD_CDC_ACM_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_CDC_ACM_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_CDC_ACM_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_CDC_ACM_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_CDC_ACM_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_CDC_ACM_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_CDC_ACM_SOF(USBD_HandleTypeDef *pdev);
+static uint8_t *USBD_CDC_ACM_GetCfgDesc(uint16_t *length);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_ACM_Private_Variables
+  * @{
+  */
+USBD_ClassTypeDef USBD_CDC_ACM =
+{
+  USBD_CDC_ACM_Init,
+  USBD_CDC_ACM_DeInit,
+  USBD_CDC_ACM_Setup,
+  NULL,                 /* EP0_TxSent */
+  NULL,                 /* EP0_RxReady, the line coding is received in place */
+  USBD_CDC_ACM_DataIn,
+  USBD_CDC_ACM_DataOut,
+  USBD_CDC_ACM_SOF,
+  NULL,
+  NULL,
+  USBD_CDC_ACM_GetCfgDesc,
+  USBD_CDC_ACM_GetCfgDesc,
+  USBD_CDC_ACM_GetCfgDesc,
+  NULL,
+};
+
+/* USB CDC device Configuration Descriptor, only the part after the header is used by usbd_composite.c */
+__ALIGN_BEGIN static uint8_t USBD_CDC_ACM_CfgDesc[USB_CDC_ACM_CONFIG_DESC_SIZ] __ALIGN_END =
+{
+  /* Configuration */
+  USB_LEN_CFG_DESC,                     /* bLength */
+  USB_DESC_TYPE_CONFIGURATION,          /* bDescriptorType */
+  LOBYTE(USB_CDC_ACM_CONFIG_DESC_SIZ),  /* wTotalLength */
+  HIBYTE(USB_CDC_ACM_CONFIG_DESC_SIZ),
+  0x02,                                 /* bNumInterfaces */
+  0x01,                                 /* bConfigurationValue */
+  0x00,                                 /* iConfiguration */
+#if (USBD_SELF_POWERED == 1U)
+  0xC0,                                 /* bmAttributes: Bus Powered according to user configuration */
+#else
+  0x80,                                 /* bmAttributes: Bus Powered according to user configuration */
+#endif
+  USBD_MAX_POWER,                       /* bMaxPower */
+
+  /* Interface Association Descriptor */
+  USB_CDC_ACM_IAD_DESC_SIZ,             /* bLength */
+  USB_DESC_TYPE_IAD,                    /* bDescriptorType */
+  CDC_ACM_CMD_ITF_NBR,                  /* bFirstInterface */
+  0x02,                                 /* bInterfaceCount */
+  0x02,                                 /* bFunctionClass: CDC */
+  0x02,                                 /* bFunctionSubClass: ACM */
+  0x01,                                 /* bFunctionProtocol: AT commands */
+  0x00,                                 /* iFunction */
+
+  /* Communication Interface Descriptor */
+  USB_LEN_IF_DESC,                      /* bLength */
+  USB_DESC_TYPE_INTERFACE,              /* bDescriptorType */
+  CDC_ACM_CMD_ITF_NBR,                  /* bInterfaceNumber */
+  0x00,                                 /* bAlternateSetting */
+  0x01,                                 /* bNumEndpoints */
+  0x02,                                 /* bInterfaceClass: CDC */
+  0x02,                                 /* bInterfaceSubClass: ACM */
+  0x01,                                 /* bInterfaceProtocol: AT commands */
+  0x00,                                 /* iInterface */
+
+  /* Header Functional Descriptor */
+  0x05,                                 /* bLength */
+  0x24,                                 /* bDescriptorType: CS_INTERFACE */
+  0x00,                                 /* bDescriptorSubtype: Header */
+  0x10,                                 /* bcdCDC 1.10 */
+  0x01,
+
+  /* Call Management Functional Descriptor */
+  0x05,                                 /* bLength */
+  0x24,                                 /* bDescriptorType: CS_INTERFACE */
+  0x01,                                 /* bDescriptorSubtype: Call Management */
+  0x00,                                 /* bmCapabilities */
+  CDC_ACM_DATA_ITF_NBR,                 /* bDataInterface */
+
+  /* ACM Functional Descriptor */
+  0x04,                                 /* bLength */
+  0x24,                                 /* bDescriptorType: CS_INTERFACE */
+  0x02,                                 /* bDescriptorSubtype: Abstract Control Management */
+  0x02,                                 /* bmCapabilities: line coding and serial state */
+
+  /* Union Functional Descriptor */
+  0x05,                                 /* bLength */
+  0x24,                                 /* bDescriptorType: CS_INTERFACE */
+  0x06,                                 /* bDescriptorSubtype: Union */
+  CDC_ACM_CMD_ITF_NBR,                  /* bMasterInterface */
+  CDC_ACM_DATA_ITF_NBR,                 /* bSlaveInterface0 */
+
+  /* Notification Endpoint Descriptor */
+  USB_LEN_EP_DESC,                      /* bLength */
+  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */
+  CDC_ACM_CMD_EP,                       /* bEndpointAddress */
+  USBD_EP_TYPE_INTR,                    /* bmAttributes */
+  LOBYTE(CDC_ACM_CMD_PACKET_SIZE),      /* wMaxPacketSize */
+  HIBYTE(CDC_ACM_CMD_PACKET_SIZE),
+  CDC_ACM_FS_BINTERVAL,                 /* bInterval */
+
+  /* Data Interface Descriptor */
+  USB_LEN_IF_DESC,                      /* bLength */
+  USB_DESC_TYPE_INTERFACE,              /* bDescriptorType */
+  CDC_ACM_DATA_ITF_NBR,                 /* bInterfaceNumber */
+  0x00,                                 /* bAlternateSetting */
+  0x02,                                 /* bNumEndpoints */
+  0x0A,                                 /* bInterfaceClass: CDC Data */
+  0x00,                                 /* bInterfaceSubClass */
+  0x00,                                 /* bInterfaceProtocol */
+  0x00,                                 /* iInterface */
+
+  /* Data OUT Endpoint Descriptor */
+  USB_LEN_EP_DESC,                      /* bLength */
+  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */
+  CDC_ACM_OUT_EP,                       /* bEndpointAddress */
+  USBD_EP_TYPE_BULK,                    /* bmAttributes */
+  LOBYTE(CDC_ACM_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize */
+  HIBYTE(CDC_ACM_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                                 /* bInterval */
+
+  /* Data IN Endpoint Descriptor */
+  USB_LEN_EP_DESC,                      /* bLength */
+  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */
+  CDC_ACM_IN_EP,                        /* bEndpointAddress */
+  USBD_EP_TYPE_BULK,                    /* bmAttributes */
+  LOBYTE(CDC_ACM_DATA_FS_MAX_PACKET_SIZE),  /* wMaxPacketSize */
+  HIBYTE(CDC_ACM_DATA_FS_MAX_PACKET_SIZE),
+  0x00,                                 /* bInterval */
+};
+
+/* dwDTERate, bCharFormat, bParityType, bDataBits. Only kept for GET_LINE_CODING, the port has no baud rate */
+__ALIGN_BEGIN static uint8_t CDC_ACM_LineCoding[7] __ALIGN_END =
+{
+  0x00, 0xC2, 0x01, 0x00,               /* 115200 */
+  0x00,                                 /* 1 stop bit */
+  0x00,                                 /* no parity */
+  0x08,                                 /* 8 data bits */
+};
+
+__ALIGN_BEGIN static uint8_t CDC_ACM_TxBuf[CDC_ACM_TX_SIZE] __ALIGN_END;
+__ALIGN_BEGIN static uint8_t CDC_ACM_RxBuf[CDC_ACM_DATA_FS_MAX_PACKET_SIZE] __ALIGN_END;
+
+static USBD_CDC_ACM_ItfTypeDef *CDC_ACM_fops = NULL;
+static volatile uint8_t CDC_ACM_TxBusy = 0U;
+static uint16_t CDC_ACM_TxLen = 0U;
+static uint32_t CDC_ACM_AltSetting = 0U;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_CDC_ACM_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_CDC_ACM_Init
+  *         Initialize the CDC interfaces
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_CDC_ACM_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+  (void)USBD_LL_OpenEP(pdev, CDC_ACM_IN_EP, USBD_EP_TYPE_BULK, CDC_ACM_DATA_FS_MAX_PACKET_SIZE);
+  pdev->ep_in[CDC_ACM_IN_EP & 0xFU].is_used = 1U;
+
+  (void)USBD_LL_OpenEP(pdev, CDC_ACM_OUT_EP, USBD_EP_TYPE_BULK, CDC_ACM_DATA_FS_MAX_PACKET_SIZE);
+  pdev->ep_out[CDC_ACM_OUT_EP & 0xFU].is_used = 1U;
+
+  pdev->ep_in[CDC_ACM_CMD_EP & 0xFU].bInterval = CDC_ACM_FS_BINTERVAL;
+  (void)USBD_LL_OpenEP(pdev, CDC_ACM_CMD_EP, USBD_EP_TYPE_INTR, CDC_ACM_CMD_PACKET_SIZE);
+  pdev->ep_in[CDC_ACM_CMD_EP & 0xFU].is_used = 1U;
+
+  CDC_ACM_TxBusy = 0U;
+  CDC_ACM_TxLen = 0U;
+  CDC_ACM_AltSetting = 0U;
+
+  if (CDC_ACM_fops != NULL)
+  {
+    CDC_ACM_fops->Init();
+  }
+
+  (void)USBD_LL_PrepareReceive(pdev, CDC_ACM_OUT_EP, CDC_ACM_RxBuf, CDC_ACM_DATA_FS_MAX_PACKET_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_DeInit
+  *         DeInitialize the CDC interfaces
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_CDC_ACM_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+  (void)USBD_LL_CloseEP(pdev, CDC_ACM_IN_EP);
+  pdev->ep_in[CDC_ACM_IN_EP & 0xFU].is_used = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, CDC_ACM_OUT_EP);
+  pdev->ep_out[CDC_ACM_OUT_EP & 0xFU].is_used = 0U;
+
+  (void)USBD_LL_CloseEP(pdev, CDC_ACM_CMD_EP);
+  pdev->ep_in[CDC_ACM_CMD_EP & 0xFU].is_used = 0U;
+  pdev->ep_in[CDC_ACM_CMD_EP & 0xFU].bInterval = 0U;
+
+  CDC_ACM_TxBusy = 0U;
+
+  if (CDC_ACM_fops != NULL)
+  {
+    CDC_ACM_fops->DeInit();
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_Setup
+  *         Handle the CDC specific requests
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_CDC_ACM_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_StatusTypeDef ret = USBD_OK;
+  uint16_t status_info = 0U;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS:
+      switch (req->bRequest)
+      {
+        case CDC_ACM_SET_LINE_CODING:
+          (void)USBD_CtlPrepareRx(pdev, CDC_ACM_LineCoding, MIN(req->wLength, sizeof(CDC_ACM_LineCoding)));
+          break;
+
+        case CDC_ACM_GET_LINE_CODING:
+          (void)USBD_CtlSendData(pdev, CDC_ACM_LineCoding, MIN(req->wLength, sizeof(CDC_ACM_LineCoding)));
+          break;
+
+        case CDC_ACM_SET_CONTROL_LINE_STATE:
+          if (CDC_ACM_fops != NULL)
+          {
+            CDC_ACM_fops->LineState(req->wValue);
+          }
+          break;
+
+        case CDC_ACM_SEND_BREAK:
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&CDC_ACM_AltSetting, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          if (pdev->dev_state != USBD_STATE_CONFIGURED || (uint8_t)(req->wValue) != 0U)
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_DataIn
+  *         A transmit is over, closed with a zero length packet if it ended
+  *         on a full packet
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_CDC_ACM_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  if (epnum != (CDC_ACM_IN_EP & 0xFU))
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  if (CDC_ACM_TxLen != 0U && (CDC_ACM_TxLen % CDC_ACM_DATA_FS_MAX_PACKET_SIZE) == 0U)
+  {
+    CDC_ACM_TxLen = 0U;
+    (void)USBD_LL_Transmit(pdev, CDC_ACM_IN_EP, NULL, 0U);
+    return (uint8_t)USBD_OK;
+  }
+
+  CDC_ACM_TxBusy = 0U;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_DataOut
+  *         Hands received data to the interface and takes the next packet
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_CDC_ACM_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  uint32_t len = USBD_LL_GetRxDataSize(pdev, epnum);
+
+  if (CDC_ACM_fops != NULL)
+  {
+    CDC_ACM_fops->Receive(CDC_ACM_RxBuf, len);
+  }
+
+  (void)USBD_LL_PrepareReceive(pdev, CDC_ACM_OUT_EP, CDC_ACM_RxBuf, CDC_ACM_DATA_FS_MAX_PACKET_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_SOF
+  *         Gives the interface its 1ms tick
+  * @param  pdev: device instance
+  * @retval status
+  */
+RAM_ISR static uint8_t USBD_CDC_ACM_SOF(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+
+  if (CDC_ACM_fops != NULL)
+  {
+    CDC_ACM_fops->Tick();
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_GetCfgDesc
+  *         return configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_CDC_ACM_GetCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)sizeof(USBD_CDC_ACM_CfgDesc);
+
+  return USBD_CDC_ACM_CfgDesc;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_RegisterInterface
+  * @param  fops: CDC interface callbacks
+  * @retval status
+  */
+uint8_t USBD_CDC_ACM_RegisterInterface(USBD_CDC_ACM_ItfTypeDef *fops)
+{
+  if (fops == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  CDC_ACM_fops = fops;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_CDC_ACM_Transmit
+  *         Sends data to the host. The data is copied, the buffer can be
+  *         reused on return. To be called from a single context.
+  * @param  pdev: device instance
+  * @param  buf: data
+  * @param  len: length, CDC_ACM_TX_SIZE at most
+  * @retval USBD_OK, USBD_BUSY while the last transmit is pending, USBD_FAIL otherwise
+  */
+uint8_t USBD_CDC_ACM_Transmit(USBD_HandleTypeDef *pdev, const uint8_t *buf, uint16_t len)
+{
+  if (pdev->dev_state != USBD_STATE_CONFIGURED || len > CDC_ACM_TX_SIZE)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if (CDC_ACM_TxBusy != 0U)
+  {
+    return (uint8_t)USBD_BUSY;
+  }
+
+  CDC_ACM_TxBusy = 1U;
+  CDC_ACM_TxLen = len;
+  (void)USBD_memcpy(CDC_ACM_TxBuf, buf, len);
+
+  (void)USBD_LL_Transmit(pdev, CDC_ACM_IN_EP, CDC_ACM_TxBuf, len);
+
+  return (uint8_t)USBD_OK;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,78 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite.h
+  * @brief   Header file for the usbd_composite.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_COMPOSITE_H
+#define __USBD_COMPOSITE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_COMPOSITE
+  * @brief Multiplexer presenting several classes as one configuration
+  * @{
+  */
+
+
+/** @defgroup USBD_COMPOSITE_Exported_Defines
+  * @{
+  */
+#ifndef USBD_COMPOSITE_MAX_CLASSES
+#define USBD_COMPOSITE_MAX_CLASSES                    3U
+#endif /* USBD_COMPOSITE_MAX_CLASSES */
+
+/* Room for the combined configuration descriptor */
+#ifndef USBD_COMPOSITE_CFG_DESC_SIZ
+#define USBD_COMPOSITE_CFG_DESC_SIZ                   320U
+#endif /* USBD_COMPOSITE_CFG_DESC_SIZ */
+
+/* Owner of an interface or endpoint the configuration does not use */
+#define USBD_COMPOSITE_NONE                           0xFFU
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_COMPOSITE_Exported_Variables
+  * @{
+  */
+extern USBD_ClassTypeDef USBD_COMPOSITE;
+#define USBD_COMPOSITE_CLASS &USBD_COMPOSITE
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_COMPOSITE_Exported_Functions
+  * @{
+  */
+uint8_t USBD_COMPOSITE_AddClass(USBD_ClassTypeDef *pclass);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_COMPOSITE_H */
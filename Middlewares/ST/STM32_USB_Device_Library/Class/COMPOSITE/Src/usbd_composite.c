@@ -0,0 +1,457 @@
+/**
+  ******************************************************************************
+  * @file    usbd_composite.c
+  * @brief   Multiplexer presenting several classes as one configuration.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                Composite device
+  *          ===================================================================
+  *           Registered with the core in place of a single class. Classes are
+  *           added in order with USBD_COMPOSITE_AddClass() before USBD_Start():
+  *           the interfaces of each one are appended to a common configuration
+  *           descriptor, and the interface and endpoint numbers found in it
+  *           decide which class gets each request and endpoint event.
+  *
+  *           The first class added is the main one: it gets the requests sent
+  *           to the device (vendor requests), the device qualifier, and keeps
+  *           pdev->pClassData and pdev->pUserData for itself. The audio class
+  *           uses them from the DMA interrupt and PendSV, outside of any class
+  *           callback, so they cannot be swapped per call; the other classes
+  *           keep their state to themselves.
+  *
+  *           Endpoint events go through a table lookup and a single call, and
+  *           SOF goes to the classes in the order they were added, so the
+  *           isochronous path of the main class sees no extra work.
+  *
+  *           The interface numbers in the descriptors of the added classes
+  *           have to follow on from each other; they are not renumbered.
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_composite.h"
+#include "usbd_ctlreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_COMPOSITE
+  * @brief Multiplexer presenting several classes as one configuration
+  * @{
+  */
+
+/** @defgroup USBD_COMPOSITE_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_COMPOSITE_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_COMPOSITE_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_COMPOSITE_EP0_TxSent(USBD_HandleTypeDef *pdev);
+static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev);
+static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_COMPOSITE_SOF(USBD_HandleTypeDef *pdev);
+static uint8_t USBD_COMPOSITE_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t USBD_COMPOSITE_IsoOutIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t *USBD_COMPOSITE_GetCfgDesc(uint16_t *length);
+static uint8_t *USBD_COMPOSITE_GetDeviceQualifierDesc(uint16_t *length);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_COMPOSITE_Private_Variables
+  * @{
+  */
+USBD_ClassTypeDef USBD_COMPOSITE =
+{
+  USBD_COMPOSITE_Init,
+  USBD_COMPOSITE_DeInit,
+  USBD_COMPOSITE_Setup,
+  USBD_COMPOSITE_EP0_TxSent,
+  USBD_COMPOSITE_EP0_RxReady,
+  USBD_COMPOSITE_DataIn,
+  USBD_COMPOSITE_DataOut,
+  USBD_COMPOSITE_SOF,
+  USBD_COMPOSITE_IsoINIncomplete,
+  USBD_COMPOSITE_IsoOutIncomplete,
+  USBD_COMPOSITE_GetCfgDesc,
+  USBD_COMPOSITE_GetCfgDesc,
+  USBD_COMPOSITE_GetCfgDesc,
+  USBD_COMPOSITE_GetDeviceQualifierDesc,
+};
+
+__ALIGN_BEGIN static uint8_t COMPOSITE_CfgDesc[USBD_COMPOSITE_CFG_DESC_SIZ] __ALIGN_END;
+static uint16_t COMPOSITE_CfgDescLen = 0U;
+
+static USBD_ClassTypeDef *COMPOSITE_Class[USBD_COMPOSITE_MAX_CLASSES];
+static uint8_t COMPOSITE_NumClasses = 0U;
+
+/* Class index of every interface and endpoint, USBD_COMPOSITE_NONE if unused */
+static uint8_t COMPOSITE_ItfOwner[USBD_MAX_NUM_INTERFACES];
+static uint8_t COMPOSITE_EpInOwner[16];
+static uint8_t COMPOSITE_EpOutOwner[16];
+
+/* Class that took the last SETUP, it gets the data stage callbacks */
+static uint8_t COMPOSITE_Ep0Owner = 0U;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_COMPOSITE_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_COMPOSITE_AddClass
+  *         Appends the interfaces of a class to the configuration. To be
+  *         called before USBD_Start(), the main class first.
+  * @param  pclass: class, with a full speed configuration descriptor
+  * @retval USBD_OK, USBD_FAIL if the class does not fit or clashes with another
+  */
+uint8_t USBD_COMPOSITE_AddClass(USBD_ClassTypeDef *pclass)
+{
+  uint16_t len = 0U;
+  uint16_t idx;
+  uint8_t *desc;
+  uint8_t id = COMPOSITE_NumClasses;
+
+  if (pclass == NULL || pclass->GetFSConfigDescriptor == NULL || id >= USBD_COMPOSITE_MAX_CLASSES)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  desc = pclass->GetFSConfigDescriptor(&len);
+
+  if (len < USB_LEN_CFG_DESC || desc[0] != USB_LEN_CFG_DESC)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if (id == 0U)
+  {
+    /* The configuration header comes from the main class, the totals are patched below */
+    (void)USBD_memset(COMPOSITE_ItfOwner, USBD_COMPOSITE_NONE, sizeof(COMPOSITE_ItfOwner));
+    (void)USBD_memset(COMPOSITE_EpInOwner, USBD_COMPOSITE_NONE, sizeof(COMPOSITE_EpInOwner));
+    (void)USBD_memset(COMPOSITE_EpOutOwner, USBD_COMPOSITE_NONE, sizeof(COMPOSITE_EpOutOwner));
+    (void)USBD_memcpy(COMPOSITE_CfgDesc, desc, USB_LEN_CFG_DESC);
+    COMPOSITE_CfgDesc[4] = 0U;
+    COMPOSITE_CfgDescLen = USB_LEN_CFG_DESC;
+  }
+
+  if (COMPOSITE_CfgDescLen + len - USB_LEN_CFG_DESC > USBD_COMPOSITE_CFG_DESC_SIZ)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  /* Record the interfaces and endpoints of the class, any clash fails the whole configuration */
+  for (idx = USB_LEN_CFG_DESC; idx < len; idx += desc[idx])
+  {
+    uint8_t *d = &desc[idx];
+
+    if (d[0] < 2U || (idx + d[0]) > len)
+    {
+      return (uint8_t)USBD_FAIL;
+    }
+
+    if (d[1] == USB_DESC_TYPE_INTERFACE)
+    {
+      if (d[2] >= USBD_MAX_NUM_INTERFACES ||
+          (COMPOSITE_ItfOwner[d[2]] != USBD_COMPOSITE_NONE && COMPOSITE_ItfOwner[d[2]] != id))
+      {
+        return (uint8_t)USBD_FAIL;
+      }
+      COMPOSITE_ItfOwner[d[2]] = id;
+    }
+    else if (d[1] == USB_DESC_TYPE_ENDPOINT)
+    {
+      uint8_t *owner = ((d[2] & 0x80U) != 0U) ? &COMPOSITE_EpInOwner[d[2] & 0xFU]
+                                              : &COMPOSITE_EpOutOwner[d[2] & 0xFU];
+
+      if (*owner != USBD_COMPOSITE_NONE && *owner != id)
+      {
+        return (uint8_t)USBD_FAIL;
+      }
+      *owner = id;
+    }
+  }
+
+  (void)USBD_memcpy(&COMPOSITE_CfgDesc[COMPOSITE_CfgDescLen], &desc[USB_LEN_CFG_DESC],
+                    len - USB_LEN_CFG_DESC);
+  COMPOSITE_CfgDescLen += len - USB_LEN_CFG_DESC;
+
+  COMPOSITE_CfgDesc[2] = LOBYTE(COMPOSITE_CfgDescLen);
+  COMPOSITE_CfgDesc[3] = HIBYTE(COMPOSITE_CfgDescLen);
+  COMPOSITE_CfgDesc[4] += desc[4];
+
+  COMPOSITE_Class[id] = pclass;
+  COMPOSITE_NumClasses++;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_Init
+  *         Initialize every class
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_COMPOSITE_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  for (uint8_t i = 0U; i < COMPOSITE_NumClasses; i++)
+  {
+    uint8_t ret = COMPOSITE_Class[i]->Init(pdev, cfgidx);
+
+    if (ret != (uint8_t)USBD_OK)
+    {
+      return ret;
+    }
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DeInit
+  *         DeInitialize every class
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_COMPOSITE_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  for (uint8_t i = 0U; i < COMPOSITE_NumClasses; i++)
+  {
+    (void)COMPOSITE_Class[i]->DeInit(pdev, cfgidx);
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_Setup
+  *         Hands a request to the class owning its interface or endpoint.
+  *         Requests to the device go to the main class.
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_COMPOSITE_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  uint8_t id;
+  uint8_t index = LOBYTE(req->wIndex);
+
+  switch (req->bmRequest & USB_REQ_RECIPIENT_MASK)
+  {
+    case USB_REQ_RECIPIENT_INTERFACE:
+      id = (index < USBD_MAX_NUM_INTERFACES) ? COMPOSITE_ItfOwner[index] : USBD_COMPOSITE_NONE;
+      break;
+
+    case USB_REQ_RECIPIENT_ENDPOINT:
+      id = ((index & 0x80U) != 0U) ? COMPOSITE_EpInOwner[index & 0xFU] : COMPOSITE_EpOutOwner[index & 0xFU];
+      break;
+
+    default:
+      id = 0U;
+      break;
+  }
+
+  if (id >= COMPOSITE_NumClasses || COMPOSITE_Class[id]->Setup == NULL)
+  {
+    USBD_CtlError(pdev, req);
+    return (uint8_t)USBD_FAIL;
+  }
+
+  COMPOSITE_Ep0Owner = id;
+
+  return COMPOSITE_Class[id]->Setup(pdev, req);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_EP0_TxSent
+  *         handle EP0 TRx Ready event
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_COMPOSITE_EP0_TxSent(USBD_HandleTypeDef *pdev)
+{
+  USBD_ClassTypeDef *pclass = COMPOSITE_Class[COMPOSITE_Ep0Owner];
+
+  if (pclass->EP0_TxSent == NULL)
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  return pclass->EP0_TxSent(pdev);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_EP0_RxReady
+  *         handle EP0 Rx Ready event
+  * @param  pdev: device instance
+  * @retval status
+  */
+static uint8_t USBD_COMPOSITE_EP0_RxReady(USBD_HandleTypeDef *pdev)
+{
+  USBD_ClassTypeDef *pclass = COMPOSITE_Class[COMPOSITE_Ep0Owner];
+
+  if (pclass->EP0_RxReady == NULL)
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  return pclass->EP0_RxReady(pdev);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DataIn
+  *         handle data IN Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+RAM_ISR static uint8_t USBD_COMPOSITE_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  uint8_t id = COMPOSITE_EpInOwner[epnum & 0xFU];
+
+  if (id >= COMPOSITE_NumClasses || COMPOSITE_Class[id]->DataIn == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  return COMPOSITE_Class[id]->DataIn(pdev, epnum);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_DataOut
+  *         handle data OUT Stage
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+RAM_ISR static uint8_t USBD_COMPOSITE_DataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  uint8_t id = COMPOSITE_EpOutOwner[epnum & 0xFU];
+
+  if (id >= COMPOSITE_NumClasses || COMPOSITE_Class[id]->DataOut == NULL)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  return COMPOSITE_Class[id]->DataOut(pdev, epnum);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_SOF
+  *         handle SOF event, the main class first
+  * @param  pdev: device instance
+  * @retval status
+  */
+RAM_ISR static uint8_t USBD_COMPOSITE_SOF(USBD_HandleTypeDef *pdev)
+{
+  for (uint8_t i = 0U; i < COMPOSITE_NumClasses; i++)
+  {
+    if (COMPOSITE_Class[i]->SOF != NULL)
+    {
+      (void)COMPOSITE_Class[i]->SOF(pdev);
+    }
+  }
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_IsoINIncomplete
+  *         handle data ISO IN Incomplete event
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+RAM_ISR static uint8_t USBD_COMPOSITE_IsoINIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  uint8_t id = COMPOSITE_EpInOwner[epnum & 0xFU];
+
+  /* Only isochronous endpoints get here, they belong to the main class unless told otherwise */
+  if (id >= COMPOSITE_NumClasses)
+  {
+    id = 0U;
+  }
+
+  if (COMPOSITE_Class[id]->IsoINIncomplete == NULL)
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  return COMPOSITE_Class[id]->IsoINIncomplete(pdev, epnum);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_IsoOutIncomplete
+  *         handle data ISO OUT Incomplete event
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+RAM_ISR static uint8_t USBD_COMPOSITE_IsoOutIncomplete(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  uint8_t id = COMPOSITE_EpOutOwner[epnum & 0xFU];
+
+  if (id >= COMPOSITE_NumClasses)
+  {
+    id = 0U;
+  }
+
+  if (COMPOSITE_Class[id]->IsoOUTIncomplete == NULL)
+  {
+    return (uint8_t)USBD_OK;
+  }
+
+  return COMPOSITE_Class[id]->IsoOUTIncomplete(pdev, epnum);
+}
+
+/**
+  * @brief  USBD_COMPOSITE_GetCfgDesc
+  *         return the combined configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_COMPOSITE_GetCfgDesc(uint16_t *length)
+{
+  *length = COMPOSITE_CfgDescLen;
+
+  return COMPOSITE_CfgDesc;
+}
+
+/**
+  * @brief  USBD_COMPOSITE_GetDeviceQualifierDesc
+  *         return Device Qualifier descriptor of the main class
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_COMPOSITE_GetDeviceQualifierDesc(uint16_t *length)
+{
+  if (COMPOSITE_NumClasses == 0U || COMPOSITE_Class[0]->GetDeviceQualifierDescriptor == NULL)
+  {
+    *length = 0U;
+    return NULL;
+  }
+
+  return COMPOSITE_Class[0]->GetDeviceQualifierDescriptor(length);
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
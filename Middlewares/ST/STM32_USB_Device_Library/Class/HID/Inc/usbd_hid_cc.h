@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    usbd_hid_cc.h
+  * @brief   Header file for the usbd_hid_cc.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_HID_CC_H
+#define __USBD_HID_CC_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include  "usbd_ioreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_HID_CC
+  * @brief HID consumer control (volume and media keys)
+  * @{
+  */
+
+
+/** @defgroup USBD_HID_CC_Exported_Defines
+  * @{
+  */
+/* Interface number of the HID function in the configuration it is part of */
+#ifndef HID_CC_ITF_NBR
+#define HID_CC_ITF_NBR                                0x02U
+#endif /* HID_CC_ITF_NBR */
+
+#define HID_CC_EPIN_ADDR                              0x82U
+#define HID_CC_EPIN_SIZE                              0x01U
+
+#ifndef HID_CC_FS_BINTERVAL
+#define HID_CC_FS_BINTERVAL                           0x0AU
+#endif /* HID_CC_FS_BINTERVAL */
+
+#define USB_HID_CC_CONFIG_DESC_SIZ                    (USB_LEN_CFG_DESC + USB_LEN_IF_DESC + \
+                                                       USB_HID_CC_DESC_SIZ + USB_LEN_EP_DESC)
+#define USB_HID_CC_DESC_SIZ                           0x09U
+#define HID_CC_REPORT_DESC_SIZE                       35U
+
+#define HID_CC_DESCRIPTOR_TYPE                        0x21U
+#define HID_CC_REPORT_DESC                            0x22U
+
+#define HID_CC_REQ_SET_PROTOCOL                       0x0BU
+#define HID_CC_REQ_GET_PROTOCOL                       0x03U
+#define HID_CC_REQ_SET_IDLE                           0x0AU
+#define HID_CC_REQ_GET_IDLE                           0x02U
+#define HID_CC_REQ_GET_REPORT                         0x01U
+
+/* Report bits, one per consumer control usage. A key stays pressed until a report without it is sent */
+#define HID_CC_VOLUME_UP                              0x01U
+#define HID_CC_VOLUME_DOWN                            0x02U
+#define HID_CC_MUTE                                   0x04U
+#define HID_CC_PLAY_PAUSE                             0x08U
+#define HID_CC_NEXT_TRACK                             0x10U
+#define HID_CC_PREV_TRACK                             0x20U
+#define HID_CC_STOP                                   0x40U
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_CC_Exported_TypesDefinitions
+  * @{
+  */
+typedef enum
+{
+  HID_CC_IDLE = 0,
+  HID_CC_BUSY,
+} HID_CC_StateTypeDef;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_CC_Exported_Variables
+  * @{
+  */
+extern USBD_ClassTypeDef USBD_HID_CC;
+#define USBD_HID_CC_CLASS &USBD_HID_CC
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_CC_Exported_Functions
+  * @{
+  */
+uint8_t USBD_HID_CC_SendReport(USBD_HandleTypeDef *pdev, uint8_t keys);
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_HID_CC_H */
@@ -0,0 +1,392 @@
+/**
+  ******************************************************************************
+  * @file    usbd_hid_cc.c
+  * @brief   HID consumer control class, for volume and media keys.
+  *
+  * @verbatim
+  *
+  *          ===================================================================
+  *                                HID Consumer Control
+  *          ===================================================================
+  *           One interface with an interrupt IN endpoint sending a one byte
+  *           report, one bit per key (HID_CC_xxx). The host maps the usages to
+  *           its own volume and media controls, so front panel keys can drive
+  *           the host mixer.
+  *
+  *           Meant to be combined with the audio function by usbd_composite.c.
+  *           The audio class owns pClassData and pUserData, so the state of
+  *           this class is kept here rather than allocated.
+  *
+  *  @endverbatim
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_hid_cc.h"
+#include "usbd_ctlreq.h"
+
+/** @addtogroup STM32_USB_DEVICE_LIBRARY
+  * @{
+  */
+
+/** @defgroup USBD_HID_CC
+  * @brief HID consumer control (volume and media keys)
+  * @{
+  */
+
+/** @defgroup USBD_HID_CC_Private_FunctionPrototypes
+  * @{
+  */
+static uint8_t USBD_HID_CC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_HID_CC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx);
+static uint8_t USBD_HID_CC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
+static uint8_t USBD_HID_CC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
+static uint8_t *USBD_HID_CC_GetCfgDesc(uint16_t *length);
+/**
+  * @}
+  */
+
+/** @defgroup USBD_HID_CC_Private_Variables
+  * @{
+  */
+USBD_ClassTypeDef USBD_HID_CC =
+{
+  USBD_HID_CC_Init,
+  USBD_HID_CC_DeInit,
+  USBD_HID_CC_Setup,
+  NULL,                 /* EP0_TxSent */
+  NULL,                 /* EP0_RxReady */
+  USBD_HID_CC_DataIn,
+  NULL,                 /* DataOut */
+  NULL,                 /* SOF */
+  NULL,
+  NULL,
+  USBD_HID_CC_GetCfgDesc,
+  USBD_HID_CC_GetCfgDesc,
+  USBD_HID_CC_GetCfgDesc,
+  NULL,
+};
+
+/* USB HID device Configuration Descriptor, only the interface part is used by usbd_composite.c */
+__ALIGN_BEGIN static uint8_t USBD_HID_CC_CfgDesc[USB_HID_CC_CONFIG_DESC_SIZ] __ALIGN_END =
+{
+  /* Configuration */
+  USB_LEN_CFG_DESC,                     /* bLength */
+  USB_DESC_TYPE_CONFIGURATION,          /* bDescriptorType */
+  LOBYTE(USB_HID_CC_CONFIG_DESC_SIZ),   /* wTotalLength */
+  HIBYTE(USB_HID_CC_CONFIG_DESC_SIZ),
+  0x01,                                 /* bNumInterfaces */
+  0x01,                                 /* bConfigurationValue */
+  0x00,                                 /* iConfiguration */
+#if (USBD_SELF_POWERED == 1U)
+  0xC0,                                 /* bmAttributes: Bus Powered according to user configuration */
+#else
+  0x80,                                 /* bmAttributes: Bus Powered according to user configuration */
+#endif
+  USBD_MAX_POWER,                       /* bMaxPower */
+
+  /* Consumer Control Interface Descriptor */
+  USB_LEN_IF_DESC,                      /* bLength */
+  USB_DESC_TYPE_INTERFACE,              /* bDescriptorType */
+  HID_CC_ITF_NBR,                       /* bInterfaceNumber */
+  0x00,                                 /* bAlternateSetting */
+  0x01,                                 /* bNumEndpoints */
+  0x03,                                 /* bInterfaceClass: HID */
+  0x00,                                 /* bInterfaceSubClass: no boot */
+  0x00,                                 /* bInterfaceProtocol: none */
+  0x00,                                 /* iInterface */
+
+  /* HID Descriptor */
+  USB_HID_CC_DESC_SIZ,                  /* bLength */
+  HID_CC_DESCRIPTOR_TYPE,               /* bDescriptorType */
+  0x11,                                 /* bcdHID 1.11 */
+  0x01,
+  0x00,                                 /* bCountryCode */
+  0x01,                                 /* bNumDescriptors */
+  HID_CC_REPORT_DESC,                   /* bDescriptorType */
+  LOBYTE(HID_CC_REPORT_DESC_SIZE),      /* wItemLength */
+  HIBYTE(HID_CC_REPORT_DESC_SIZE),
+
+  /* Consumer Control Endpoint Descriptor */
+  USB_LEN_EP_DESC,                      /* bLength */
+  USB_DESC_TYPE_ENDPOINT,               /* bDescriptorType */
+  HID_CC_EPIN_ADDR,                     /* bEndpointAddress */
+  USBD_EP_TYPE_INTR,                    /* bmAttributes */
+  LOBYTE(HID_CC_EPIN_SIZE),             /* wMaxPacketSize */
+  HIBYTE(HID_CC_EPIN_SIZE),
+  HID_CC_FS_BINTERVAL,                  /* bInterval */
+};
+
+__ALIGN_BEGIN static uint8_t HID_CC_ReportDesc[HID_CC_REPORT_DESC_SIZE] __ALIGN_END =
+{
+  0x05, 0x0C,                           /* Usage Page (Consumer) */
+  0x09, 0x01,                           /* Usage (Consumer Control) */
+  0xA1, 0x01,                           /* Collection (Application) */
+  0x15, 0x00,                           /*   Logical Minimum (0) */
+  0x25, 0x01,                           /*   Logical Maximum (1) */
+  0x75, 0x01,                           /*   Report Size (1) */
+  0x95, 0x07,                           /*   Report Count (7) */
+  0x09, 0xE9,                           /*   Usage (Volume Increment)  HID_CC_VOLUME_UP */
+  0x09, 0xEA,                           /*   Usage (Volume Decrement)  HID_CC_VOLUME_DOWN */
+  0x09, 0xE2,                           /*   Usage (Mute)              HID_CC_MUTE */
+  0x09, 0xCD,                           /*   Usage (Play/Pause)        HID_CC_PLAY_PAUSE */
+  0x09, 0xB5,                           /*   Usage (Scan Next Track)   HID_CC_NEXT_TRACK */
+  0x09, 0xB6,                           /*   Usage (Scan Prev Track)   HID_CC_PREV_TRACK */
+  0x09, 0xB7,                           /*   Usage (Stop)              HID_CC_STOP */
+  0x81, 0x02,                           /*   Input (Data, Variable, Absolute) */
+  0x95, 0x01,                           /*   Report Count (1) */
+  0x81, 0x01,                           /*   Input (Constant), pads to a byte */
+  0xC0                                  /* End Collection */
+};
+
+__ALIGN_BEGIN static uint8_t HID_CC_Report[HID_CC_EPIN_SIZE] __ALIGN_END;
+
+static volatile HID_CC_StateTypeDef HID_CC_State = HID_CC_IDLE;
+static uint32_t HID_CC_Protocol = 0U;
+static uint32_t HID_CC_IdleState = 0U;
+static uint32_t HID_CC_AltSetting = 0U;
+/**
+  * @}
+  */
+
+
+/** @defgroup USBD_HID_CC_Private_Functions
+  * @{
+  */
+
+/**
+  * @brief  USBD_HID_CC_Init
+  *         Initialize the HID consumer control interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_HID_CC_Init(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+  pdev->ep_in[HID_CC_EPIN_ADDR & 0xFU].bInterval = HID_CC_FS_BINTERVAL;
+
+  (void)USBD_LL_OpenEP(pdev, HID_CC_EPIN_ADDR, USBD_EP_TYPE_INTR, HID_CC_EPIN_SIZE);
+  pdev->ep_in[HID_CC_EPIN_ADDR & 0xFU].is_used = 1U;
+
+  HID_CC_State = HID_CC_IDLE;
+  HID_CC_Protocol = 0U;
+  HID_CC_IdleState = 0U;
+  HID_CC_AltSetting = 0U;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_CC_DeInit
+  *         DeInitialize the HID consumer control interface
+  * @param  pdev: device instance
+  * @param  cfgidx: Configuration index
+  * @retval status
+  */
+static uint8_t USBD_HID_CC_DeInit(USBD_HandleTypeDef *pdev, uint8_t cfgidx)
+{
+  UNUSED(cfgidx);
+
+  (void)USBD_LL_CloseEP(pdev, HID_CC_EPIN_ADDR);
+  pdev->ep_in[HID_CC_EPIN_ADDR & 0xFU].is_used = 0U;
+  pdev->ep_in[HID_CC_EPIN_ADDR & 0xFU].bInterval = 0U;
+
+  HID_CC_State = HID_CC_IDLE;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_CC_Setup
+  *         Handle the HID specific requests
+  * @param  pdev: instance
+  * @param  req: usb requests
+  * @retval status
+  */
+static uint8_t USBD_HID_CC_Setup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req)
+{
+  USBD_StatusTypeDef ret = USBD_OK;
+  uint16_t status_info = 0U;
+  uint16_t len;
+  uint8_t *pbuf;
+
+  switch (req->bmRequest & USB_REQ_TYPE_MASK)
+  {
+    case USB_REQ_TYPE_CLASS:
+      switch (req->bRequest)
+      {
+        case HID_CC_REQ_SET_PROTOCOL:
+          HID_CC_Protocol = (uint8_t)(req->wValue);
+          break;
+
+        case HID_CC_REQ_GET_PROTOCOL:
+          (void)USBD_CtlSendData(pdev, (uint8_t *)&HID_CC_Protocol, 1U);
+          break;
+
+        case HID_CC_REQ_SET_IDLE:
+          HID_CC_IdleState = (uint8_t)(req->wValue >> 8);
+          break;
+
+        case HID_CC_REQ_GET_IDLE:
+          (void)USBD_CtlSendData(pdev, (uint8_t *)&HID_CC_IdleState, 1U);
+          break;
+
+        case HID_CC_REQ_GET_REPORT:
+          (void)USBD_CtlSendData(pdev, HID_CC_Report, MIN(req->wLength, HID_CC_EPIN_SIZE));
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    case USB_REQ_TYPE_STANDARD:
+      switch (req->bRequest)
+      {
+        case USB_REQ_GET_STATUS:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&status_info, 2U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_GET_DESCRIPTOR:
+          if ((req->wValue >> 8) == HID_CC_REPORT_DESC)
+          {
+            len = MIN(HID_CC_REPORT_DESC_SIZE, req->wLength);
+            pbuf = HID_CC_ReportDesc;
+          }
+          else if ((req->wValue >> 8) == HID_CC_DESCRIPTOR_TYPE)
+          {
+            len = MIN(USB_HID_CC_DESC_SIZ, req->wLength);
+            pbuf = &USBD_HID_CC_CfgDesc[USB_LEN_CFG_DESC + USB_LEN_IF_DESC];
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+            break;
+          }
+          (void)USBD_CtlSendData(pdev, pbuf, len);
+          break;
+
+        case USB_REQ_GET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED)
+          {
+            (void)USBD_CtlSendData(pdev, (uint8_t *)&HID_CC_AltSetting, 1U);
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_SET_INTERFACE:
+          if (pdev->dev_state == USBD_STATE_CONFIGURED && (uint8_t)(req->wValue) == 0U)
+          {
+            HID_CC_AltSetting = 0U;
+          }
+          else
+          {
+            USBD_CtlError(pdev, req);
+            ret = USBD_FAIL;
+          }
+          break;
+
+        case USB_REQ_CLEAR_FEATURE:
+          break;
+
+        default:
+          USBD_CtlError(pdev, req);
+          ret = USBD_FAIL;
+          break;
+      }
+      break;
+
+    default:
+      USBD_CtlError(pdev, req);
+      ret = USBD_FAIL;
+      break;
+  }
+
+  return (uint8_t)ret;
+}
+
+/**
+  * @brief  USBD_HID_CC_DataIn
+  *         The last report has been sent
+  * @param  pdev: device instance
+  * @param  epnum: endpoint index
+  * @retval status
+  */
+static uint8_t USBD_HID_CC_DataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
+{
+  UNUSED(pdev);
+  UNUSED(epnum);
+
+  HID_CC_State = HID_CC_IDLE;
+
+  return (uint8_t)USBD_OK;
+}
+
+/**
+  * @brief  USBD_HID_CC_GetCfgDesc
+  *         return configuration descriptor
+  * @param  length : pointer data length
+  * @retval pointer to descriptor buffer
+  */
+static uint8_t *USBD_HID_CC_GetCfgDesc(uint16_t *length)
+{
+  *length = (uint16_t)sizeof(USBD_HID_CC_CfgDesc);
+
+  return USBD_HID_CC_CfgDesc;
+}
+
+/**
+  * @brief  USBD_HID_CC_SendReport
+  *         Sends the state of the keys. A pressed key has to be followed by a
+  *         report without it, or the host sees it held down.
+  * @param  pdev: device instance
+  * @param  keys: HID_CC_xxx bits of the keys pressed
+  * @retval USBD_OK, USBD_BUSY while the last report is pending, USBD_FAIL if not configured
+  */
+uint8_t USBD_HID_CC_SendReport(USBD_HandleTypeDef *pdev, uint8_t keys)
+{
+  if (pdev->dev_state != USBD_STATE_CONFIGURED)
+  {
+    return (uint8_t)USBD_FAIL;
+  }
+
+  if (HID_CC_State != HID_CC_IDLE)
+  {
+    return (uint8_t)USBD_BUSY;
+  }
+
+  HID_CC_State = HID_CC_BUSY;
+  HID_CC_Report[0] = keys;
+
+  (void)USBD_LL_Transmit(pdev, HID_CC_EPIN_ADDR, HID_CC_Report, HID_CC_EPIN_SIZE);
+
+  return (uint8_t)USBD_OK;
+}
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,115 @@
+/**
+  ******************************************************************************
+  * @file           : sim.h
+  * @brief          : Host simulation of the USB audio device.
+  *
+  *                   The USB core, the classes of the composite device, their
+  *                   interface files, MX_USB_DEVICE_Init and the Core queues
+  *                   are built unchanged for the host. The
+  *                   simulator stands in for everything below them: the
+  *                   USBD_LL_* driver, the I2S DMA and the core registers.
+  *                   Time is host time in microseconds. Interrupt handlers
+  *                   run to completion one at a time, each followed by
+  *                   PendSV (the work queue) and the thread mode events.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __SIM_H
+#define __SIM_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/* Exported constants --------------------------------------------------------*/
+/* Largest number of timed actions of a scenario */
+#define SIM_ACTION_MAX                  8U
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  SIM_ACT_NONE = 0,
+  SIM_ACT_ALT,              /* SET_INTERFACE of the streaming interface, arg = alternate setting */
+  SIM_ACT_LATENCY,          /* vendor SET_LATENCY, arg = AUDIO_LATENCY_xxx */
+  SIM_ACT_DROP,             /* the host loses arg consecutive OUT packets */
+  SIM_ACT_PAUSE,            /* the host stops sending for arg ms, the alternate setting stays */
+  SIM_ACT_DRIFT,            /* device clock changes to arg ppm against the host */
+} SIM_ActionIdTypeDef;
+
+typedef struct
+{
+  uint32_t at_ms;
+  SIM_ActionIdTypeDef id;
+  int32_t arg;
+} SIM_ActionTypeDef;
+
+typedef struct
+{
+  const char *name;
+  uint32_t duration_ms;
+  double drift_ppm;         /* device I2S clock against the host SOF clock, > 0 is faster */
+  double jitter_us;         /* OUT packet arrival spread within the frame */
+  double drop_rate;         /* probability of losing each OUT packet */
+  uint32_t seed;
+  SIM_ActionTypeDef action[SIM_ACTION_MAX];
+  /* Pass criteria, counted from settle_ms on */
+  uint32_t settle_ms;
+  uint32_t max_underruns;
+  uint32_t latency_tol;     /* mean fill against the pre-roll GET_LATENCY reports, frames, 0 skips it */
+} SIM_ScenarioTypeDef;
+
+/* One CSV row, the state at the end of a 1ms frame */
+typedef struct
+{
+  uint32_t frame;
+  uint32_t alt;
+  uint32_t sent;            /* frames the host sent in this frame */
+  uint32_t fill;            /* frames buffered, ring plus DMA blocks */
+  double latency_ms;        /* fill at the I2S rate */
+  double fb;                /* feedback the host last received, frames per ms */
+  uint32_t underruns;
+  uint32_t underrun_frames;
+  uint32_t overruns;
+  uint32_t rx_busy;
+  uint32_t iso_out_incomplete;
+  uint32_t work_dropped;
+} SIM_SampleTypeDef;
+
+/* Exported functions prototypes ---------------------------------------------*/
+/* sim_hal.c: time, core registers and the I2S DMA */
+void SIM_Reset(void);
+double SIM_Now(void);
+void SIM_AdvanceTo(double t_us);
+void SIM_SetDrift(double ppm);
+void SIM_Pend(void);
+uint32_t SIM_DMA_GetNdtr(void);
+uint32_t SIM_DMA_IsRunning(void);
+uint32_t SIM_GetCycles(void);
+
+/* sim_usb.c: USBD_LL_* driver and the host side of the bus */
+void SIM_USB_Attach(void);
+int32_t SIM_USB_Control(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                        uint16_t wLength, uint8_t *data);
+int32_t SIM_USB_Out(uint8_t ep_addr, const uint8_t *data, uint32_t len);
+int32_t SIM_USB_In(uint8_t ep_addr, uint8_t *data, uint32_t frame);
+void SIM_USB_Sof(uint32_t frame);
+void SIM_USB_IsoOutIncomplete(uint8_t ep_addr);
+uint32_t SIM_USB_GetFrame(void);
+const struct _Device_cb *SIM_USB_GetFifoClass(void);
+
+/* sim_audio.c: scenario runner */
+int SIM_Run(const SIM_ScenarioTypeDef *scn, const char *csv_path, uint32_t verbose);
+
+/* sim_scenarios.c */
+extern const SIM_ScenarioTypeDef SIM_Scenarios[];
+extern const uint32_t SIM_ScenarioCount;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __SIM_H */
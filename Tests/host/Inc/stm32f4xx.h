@@ -0,0 +1,151 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f4xx.h
+  * @brief          : Host build stand-in for the CMSIS device header.
+  *
+  *                   Only what the USB device library, the audio class and
+  *                   the Core queues use: core register blocks backed by
+  *                   plain variables and C versions of the Cortex-M4
+  *                   intrinsics. The simulation is single threaded, so
+  *                   masking interrupts does nothing and exclusive stores
+  *                   always succeed.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32F4xx_H
+#define __STM32F4xx_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+#include <stddef.h>
+
+/* Exported types ------------------------------------------------------------*/
+#define __I                             volatile const
+#define __O                             volatile
+#define __IO                            volatile
+
+typedef enum
+{
+  PendSV_IRQn = -2,
+  SysTick_IRQn = -1,
+  DMA1_Stream4_IRQn = 15,
+  OTG_FS_IRQn = 67,
+} IRQn_Type;
+
+typedef struct
+{
+  __IO uint32_t ICSR;
+} SCB_Type;
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t LOAD;
+  __IO uint32_t VAL;
+} SysTick_Type;
+
+typedef struct
+{
+  __IO uint32_t CTRL;
+  __IO uint32_t CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+  __IO uint32_t DEMCR;
+} CoreDebug_Type;
+
+/* Exported constants --------------------------------------------------------*/
+#define SCB_ICSR_PENDSVSET_Msk          (1UL << 28)
+#define DWT_CTRL_CYCCNTENA_Msk          (1UL << 0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1UL << 24)
+
+/* Exported variables --------------------------------------------------------*/
+extern uint32_t SystemCoreClock;
+extern SCB_Type SIM_SCB;
+extern SysTick_Type SIM_SysTick;
+extern DWT_Type SIM_DWT;
+extern CoreDebug_Type SIM_CoreDebug;
+extern uint32_t SIM_Uid[3];
+
+#define SCB                             (&SIM_SCB)
+#define SysTick                         (&SIM_SysTick)
+#define DWT                             (&SIM_DWT)
+#define CoreDebug                       (&SIM_CoreDebug)
+/* Unique device ID, the serial number string is made from it */
+#define UID_BASE                        ((uintptr_t)SIM_Uid)
+
+/* Exported macro ------------------------------------------------------------*/
+#define __STATIC_INLINE                 static inline
+#define __STATIC_FORCEINLINE            __attribute__((always_inline)) static inline
+#define __weak                          __attribute__((weak))
+#define __packed                        __attribute__((packed))
+
+/* Exported functions --------------------------------------------------------*/
+__STATIC_INLINE void __disable_irq(void) {}
+__STATIC_INLINE void __enable_irq(void) {}
+__STATIC_INLINE uint32_t __get_PRIMASK(void) { return 0U; }
+__STATIC_INLINE void __set_PRIMASK(uint32_t primask) { (void)primask; }
+__STATIC_INLINE void __WFI(void) {}
+__STATIC_INLINE void __NOP(void) {}
+__STATIC_INLINE void __DSB(void) {}
+__STATIC_INLINE void __ISB(void) {}
+
+__STATIC_INLINE uint32_t __LDREXW(volatile uint32_t *addr)
+{
+  return *addr;
+}
+
+__STATIC_INLINE uint32_t __STREXW(uint32_t value, volatile uint32_t *addr)
+{
+  *addr = value;
+  return 0U;
+}
+
+__STATIC_INLINE uint8_t __CLZ(uint32_t value)
+{
+  return (value == 0U) ? 32U : (uint8_t)__builtin_clz(value);
+}
+
+__STATIC_INLINE uint32_t __RBIT(uint32_t value)
+{
+  uint32_t result = 0U;
+
+  for (uint32_t i = 0U; i < 32U; i++)
+  {
+    result = (result << 1) | ((value >> i) & 1U);
+  }
+  return result;
+}
+
+__STATIC_INLINE int32_t __SSAT(int32_t value, uint32_t bits)
+{
+  const int32_t max = (int32_t)((1UL << (bits - 1U)) - 1U);
+  const int32_t min = -max - 1;
+
+  return (value > max) ? max : ((value < min) ? min : value);
+}
+
+/* Bottom half of a, top half of b shifted left, as PKHBT with the shifts the class uses */
+__STATIC_INLINE uint32_t __PKHBT(uint32_t a, uint32_t b, uint32_t shift)
+{
+  return (a & 0x0000FFFFUL) | ((b << shift) & 0xFFFF0000UL);
+}
+
+/* Sum of the products of the signed halfwords */
+__STATIC_INLINE uint32_t __SMUAD(uint32_t a, uint32_t b)
+{
+  return (uint32_t)(((int32_t)(int16_t)a * (int16_t)b) +
+                    ((int32_t)(int16_t)(a >> 16) * (int16_t)(b >> 16)));
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_H */
@@ -0,0 +1,79 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f4xx_hal.h
+  * @brief          : Host build stand-in for the HAL header.
+  *
+  *                   HAL types and the few HAL calls the audio path makes,
+  *                   implemented by the simulator (sim_hal.c). The hardware
+  *                   seams of the audio class are pointed at the simulated
+  *                   DMA and SOF clock here, since usbd_conf.h includes this
+  *                   header ahead of the class.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32F4xx_HAL_H
+#define __STM32F4xx_HAL_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f4xx.h"
+#include "sim.h"
+
+/* Exported types ------------------------------------------------------------*/
+typedef enum
+{
+  HAL_OK       = 0x00U,
+  HAL_ERROR    = 0x01U,
+  HAL_BUSY     = 0x02U,
+  HAL_TIMEOUT  = 0x03U
+} HAL_StatusTypeDef;
+
+typedef enum
+{
+  HAL_I2S_STATE_RESET      = 0x00U,
+  HAL_I2S_STATE_READY      = 0x01U,
+  HAL_I2S_STATE_BUSY       = 0x02U,
+  HAL_I2S_STATE_BUSY_TX    = 0x03U,
+  HAL_I2S_STATE_ERROR      = 0x07U
+} HAL_I2S_StateTypeDef;
+
+typedef struct
+{
+  uint16_t *pTxBuffPtr;
+  uint16_t TxXferSize;
+  __IO HAL_I2S_StateTypeDef State;
+} I2S_HandleTypeDef;
+
+/* Exported macro ------------------------------------------------------------*/
+#define UNUSED(X)                       (void)X
+
+/* No separate RAM and flash on the host */
+#define RAM_ISR
+
+/* Hardware seams of usbd_audio.c and usbd_audio_dsp.c */
+#define AUDIO_DMA_NDTR()                SIM_DMA_GetNdtr()
+#define AUDIO_DMA_RUNNING()             (SIM_DMA_IsRunning() != 0U)
+#define AUDIO_USB_FNSOF()               SIM_USB_GetFrame()
+#define AUDIO_DSP_CYCLES()              SIM_GetCycles()
+#define AUDIO_DSP_CYCLES_START()
+
+/* Exported functions --------------------------------------------------------*/
+uint32_t HAL_GetTick(void);
+void HAL_Delay(uint32_t Delay);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+
+HAL_StatusTypeDef HAL_I2S_Transmit_DMA(I2S_HandleTypeDef *hi2s, uint16_t *pData, uint16_t Size);
+HAL_StatusTypeDef HAL_I2S_DMAStop(I2S_HandleTypeDef *hi2s);
+HAL_StatusTypeDef HAL_I2S_DeInit(I2S_HandleTypeDef *hi2s);
+void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef *hi2s);
+void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef *hi2s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __STM32F4xx_HAL_H */
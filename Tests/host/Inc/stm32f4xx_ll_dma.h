@@ -0,0 +1,17 @@
+/**
+  ******************************************************************************
+  * @file           : stm32f4xx_ll_dma.h
+  * @brief          : Host build stand-in for the LL DMA header.
+  *
+  *                   The audio class only reads the I2S stream NDTR, which
+  *                   stm32f4xx_hal.h routes to the simulated DMA instead.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __STM32F4xx_LL_DMA_H
+#define __STM32F4xx_LL_DMA_H
+
+#include "stm32f4xx.h"
+
+#endif /* __STM32F4xx_LL_DMA_H */
@@ -0,0 +1,216 @@
+/**
+  ******************************************************************************
+  * @file           : bench_audio.c
+  * @brief          : Host timing of the playback data path, ns per call.
+  *
+  *                   The counterpart of usbd_audio_bench.c on the host. The
+  *                   device is enumerated and streams the 48kHz alternate
+  *                   setting in the simulator, and every frame the SOF and
+  *                   the OUT packet are timed end to end: USBD_AUDIO_SOF and
+  *                   USBD_AUDIO_DataOut with the PendSV work they queue, as
+  *                   the core would run them back to back. The kernels the
+  *                   target benchmark times on their own follow, with the
+  *                   same arguments, so both reports line up.
+  *
+  *                   The numbers only compare builds on the same machine;
+  *                   the DWT cycles on the target come from GET_BENCH and,
+  *                   for the handlers, from the ISR profiler.
+  *
+  *                   Usage: bench_audio [-n frames]
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+#include "usbd_core.h"
+#include "usbd_audio.h"
+#include "usbd_audio_dsp.h"
+#include "usbd_audio_src.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define BENCH_FRAMES_DEFAULT            20000U
+/* Frames streamed before timing, playback has started and the feedback settled */
+#define BENCH_WARMUP                    2000U
+#define BENCH_SRC_FRAMES                45U
+#define BENCH_FB_NOM                    (48UL << 22)
+
+#define BENCH_REQ_STD_ITF_OUT           0x01U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef enum
+{
+  BENCH_SOF = 0,            /* USBD_AUDIO_SOF and the feedback work */
+  BENCH_DATAOUT,            /* USBD_AUDIO_DataOut and the packet conversion */
+  BENCH_RING_WRITE,         /* one 48kHz packet into a ring */
+  BENCH_FEEDBACK,           /* one feedback value */
+  BENCH_SRC,                /* one 44.1kHz packet through the SRC */
+  BENCH_DSP,                /* one AUDIO_BLOCK_FRAMES block through the DSP pipeline */
+  BENCH_NUM
+} BENCH_IdTypeDef;
+
+typedef struct
+{
+  uint64_t min;
+  uint64_t max;
+  uint64_t total;
+  uint32_t count;
+} BENCH_ResultTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static const char *const BENCH_Name[BENCH_NUM] =
+{
+  "USBD_AUDIO_SOF + feedback", "USBD_AUDIO_DataOut + copy", "AUDIO_Ring_Write",
+  "AUDIO_Feedback_Calc", "AUDIO_SRC_Process", "AUDIO_DSP_Process"
+};
+
+static BENCH_ResultTypeDef BENCH_Result[BENCH_NUM];
+
+static uint32_t BENCH_Packet[AUDIO_OUT_PACKET / 4U];
+static uint8_t BENCH_Ring[AUDIO_TOTAL_BUF_SIZE];
+static uint32_t BENCH_Out[AUDIO_SRC_OUT_FRAMES(BENCH_SRC_FRAMES)];
+static AUDIO_SRC_TypeDef BENCH_Src;
+
+/* Private function prototypes -----------------------------------------------*/
+static uint64_t BENCH_Now(void);
+static void BENCH_Add(BENCH_IdTypeDef id, uint64_t ns);
+
+/**
+  * @brief  Monotonic time.
+  * @retval ns
+  */
+static uint64_t BENCH_Now(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_MONOTONIC, &ts);
+
+  return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/**
+  * @brief  Accounts one timed call.
+  * @param  id: what was timed
+  * @param  ns: duration
+  * @retval None
+  */
+static void BENCH_Add(BENCH_IdTypeDef id, uint64_t ns)
+{
+  BENCH_ResultTypeDef *res = &BENCH_Result[id];
+
+  res->min = (res->count == 0U || ns < res->min) ? ns : res->min;
+  res->max = (ns > res->max) ? ns : res->max;
+  res->total += ns;
+  res->count++;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t frames = BENCH_FRAMES_DEFAULT;
+  volatile uint32_t sink = 0U;
+  uint32_t wr_ptr = 0U;
+  uint8_t fb[AUDIO_IN_PACKET];
+  uint32_t refused = 0U;
+  uint64_t t0;
+  int32_t ret;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "n:")) != -1)
+  {
+    if (opt == 'n')
+    {
+      frames = (uint32_t)strtoul(optarg, NULL, 0);
+    }
+    else
+    {
+      (void)fprintf(stderr, "usage: %s [-n frames]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  /* Full scale sawtooth, left and right in opposite directions, as on the target */
+  for (uint32_t i = 0U; i < AUDIO_OUT_PACKET / 4U; i++)
+  {
+    uint16_t v = (uint16_t)(i * (65536U / (AUDIO_OUT_PACKET / 4U)));
+
+    BENCH_Packet[i] = (uint32_t)v | ((uint32_t)(uint16_t)~v << 16);
+  }
+
+  SIM_Reset();
+  SIM_USB_Attach();
+  (void)SIM_USB_Control(BENCH_REQ_STD_ITF_OUT, USB_REQ_SET_INTERFACE, AUDIO_ALT_48K, 1U, 0U, NULL);
+
+  /* The device clock is the host one, 48 frames every frame keeps the fill where it is */
+  for (uint32_t frame = 0U; frame < BENCH_WARMUP + frames; frame++)
+  {
+    SIM_AdvanceTo((double)frame * 1000.0);
+
+    t0 = BENCH_Now();
+    SIM_USB_Sof(frame);
+    if (frame >= BENCH_WARMUP)
+    {
+      BENCH_Add(BENCH_SOF, BENCH_Now() - t0);
+    }
+
+    SIM_AdvanceTo((double)frame * 1000.0 + 100.0);
+
+    t0 = BENCH_Now();
+    ret = SIM_USB_Out(AUDIO_OUT_EP, (const uint8_t *)BENCH_Packet, 48U * AUDIO_FRAME_SIZE);
+    if (frame >= BENCH_WARMUP)
+    {
+      BENCH_Add(BENCH_DATAOUT, BENCH_Now() - t0);
+      refused += (ret < 0) ? 1U : 0U;
+    }
+
+    SIM_AdvanceTo((double)frame * 1000.0 + 900.0);
+    (void)SIM_USB_In(AUDIO_IN_EP, fb, frame);
+  }
+
+  /* Only worth reporting if the packets went down the playback path */
+  if (refused != 0U || SIM_DMA_IsRunning() == 0U)
+  {
+    (void)printf("FAIL bench: %u packets refused, I2S %s\n", (unsigned)refused,
+                 (SIM_DMA_IsRunning() != 0U) ? "running" : "stopped");
+    return 1;
+  }
+
+  /* Kernels, same arguments as usbd_audio_bench.c */
+  AUDIO_SRC_Reset(&BENCH_Src);
+  (void)AUDIO_DSP_Init();
+
+  for (uint32_t i = 0U; i < frames; i++)
+  {
+    t0 = BENCH_Now();
+    wr_ptr = AUDIO_Ring_Write(BENCH_Ring, sizeof(BENCH_Ring), wr_ptr, BENCH_Packet, AUDIO_OUT_PACKET / 4U);
+    BENCH_Add(BENCH_RING_WRITE, BENCH_Now() - t0);
+
+    t0 = BENCH_Now();
+    sink = AUDIO_Feedback_Calc(i % (AUDIO_TOTAL_BUF_SIZE / 4U), AUDIO_TOTAL_BUF_SIZE / 8U,
+                               BENCH_FB_NOM, AUDIO_FB_GAIN_DEFAULT);
+    BENCH_Add(BENCH_FEEDBACK, BENCH_Now() - t0);
+
+    t0 = BENCH_Now();
+    sink = AUDIO_SRC_Process(&BENCH_Src, BENCH_Packet, BENCH_SRC_FRAMES, BENCH_Out);
+    BENCH_Add(BENCH_SRC, BENCH_Now() - t0);
+
+    t0 = BENCH_Now();
+    AUDIO_DSP_Process(BENCH_Packet, AUDIO_BLOCK_FRAMES);
+    BENCH_Add(BENCH_DSP, BENCH_Now() - t0);
+  }
+  (void)sink;
+
+  (void)printf("%-28s %10s %10s %10s  (ns per call, %u calls)\n", "", "min", "avg", "max", (unsigned)frames);
+  for (uint32_t id = 0U; id < BENCH_NUM; id++)
+  {
+    const BENCH_ResultTypeDef *res = &BENCH_Result[id];
+
+    (void)printf("%-28s %10llu %10llu %10llu\n", BENCH_Name[id], (unsigned long long)res->min,
+                 (unsigned long long)((res->count != 0U) ? res->total / res->count : 0U),
+                 (unsigned long long)res->max);
+  }
+
+  return 0;
+}
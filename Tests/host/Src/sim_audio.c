@@ -0,0 +1,496 @@
+/**
+  ******************************************************************************
+  * @file           : sim_audio.c
+  * @brief          : Scenario runner of the audio device simulation.
+  *
+  *                   The host sends a 1kHz tone at the rate the feedback
+  *                   endpoint asks for, one packet per 1ms frame, capped to
+  *                   the wMaxPacketSize of the alternate setting, and takes
+  *                   every feedback value it receives at once. A frame is:
+  *                   SOF, the OUT packet somewhere in the first part of the
+  *                   frame, the feedback IN token near its end. The I2S DMA
+  *                   interrupts fall in between at the device clock.
+  *
+  *                   Usage: sim_audio [-l] [-s name] [-o file.csv]
+  *                                    [-d ppm] [-j us] [-r rate] [-t ms] [-v]
+  *                   Without -s every scenario runs, each in its own process
+  *                   since the class keeps its state in statics.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include "usbd_core.h"
+#include "usbd_audio.h"
+#include "usbd_audio_telemetry.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Start of the OUT packet in the frame and time of the feedback IN token, us */
+#define SIM_OUT_AT_US                   50.0
+#define SIM_IN_AT_US                    900.0
+#define SIM_TONE_HZ                     1000.0
+#define SIM_TONE_AMPLITUDE              16384.0
+
+#define SIM_REQ_VENDOR_OUT              0x41U
+#define SIM_REQ_VENDOR_IN               0xC1U
+#define SIM_REQ_STD_ITF_OUT             0x01U
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t alt;
+  uint32_t rate;            /* nominal frames per second of alt */
+  uint32_t mps_frames;      /* wMaxPacketSize of alt in frames */
+  double fb;                /* frames per ms, from the feedback endpoint */
+  double acc;               /* fractional frames owed */
+  double phase;             /* tone */
+  uint32_t pause_until;
+  uint32_t drop_left;
+  uint32_t rng;
+} SIM_HostTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+extern USBD_HandleTypeDef hUsbDeviceFS;
+static SIM_HostTypeDef SIM_Host;
+
+/* Private function prototypes -----------------------------------------------*/
+static void SIM_Host_Alt(uint8_t alt);
+static double SIM_Random(void);
+static void SIM_Action(const SIM_ActionTypeDef *act);
+static void SIM_Sample(uint32_t frame, uint32_t sent, SIM_SampleTypeDef *smp);
+static void SIM_CsvRow(FILE *csv, const SIM_SampleTypeDef *smp);
+static const SIM_ScenarioTypeDef *SIM_Find(const char *name);
+static int SIM_RunChild(const SIM_ScenarioTypeDef *scn, uint32_t verbose);
+
+/**
+  * @brief  Runs one scenario from power-on.
+  * @param  scn: scenario
+  * @param  csv_path: one row per frame written there, NULL for none
+  * @param  verbose: print the summary even when the scenario passes
+  * @retval 0 if the pass criteria are met
+  */
+int SIM_Run(const SIM_ScenarioTypeDef *scn, const char *csv_path, uint32_t verbose)
+{
+  FILE *csv = NULL;
+  SIM_SampleTypeDef smp;
+  uint32_t underruns_settled = 0U;
+  uint32_t fill_min = UINT32_MAX;
+  uint32_t fill_max = 0U;
+  double fill_sum = 0.0;
+  uint32_t fill_count = 0U;
+  uint8_t lat[AUDIO_VENDOR_LATENCY_SIZE];
+  double preroll = 0.0;
+  int result;
+
+  if (csv_path != NULL)
+  {
+    csv = fopen(csv_path, "w");
+    if (csv == NULL)
+    {
+      perror(csv_path);
+      return 2;
+    }
+    (void)fprintf(csv, "frame,alt,sent,fill,latency_ms,fb,underruns,underrun_frames,overruns,"
+                       "rx_busy,iso_out_incomplete,work_dropped\n");
+  }
+
+  (void)memset(&smp, 0, sizeof(smp));
+  (void)memset(&SIM_Host, 0, sizeof(SIM_Host));
+  SIM_Host.rng = (scn->seed != 0U) ? scn->seed : 1U;
+
+  SIM_Reset();
+  SIM_SetDrift(scn->drift_ppm);
+  SIM_USB_Attach();
+  AUDIO_TLM_Reset();
+
+  for (uint32_t frame = 0U; frame < scn->duration_ms; frame++)
+  {
+    double t0 = (double)frame * 1000.0;
+    uint32_t sent = 0U;
+    uint32_t missing = 0U;
+    uint8_t fb[AUDIO_IN_PACKET];
+
+    SIM_AdvanceTo(t0);
+
+    for (uint32_t i = 0U; i < SIM_ACTION_MAX; i++)
+    {
+      if (scn->action[i].id != SIM_ACT_NONE && scn->action[i].at_ms == frame)
+      {
+        SIM_Action(&scn->action[i]);
+      }
+    }
+
+    SIM_USB_Sof(frame);
+
+    if (SIM_Host.alt != 0U && frame >= SIM_Host.pause_until)
+    {
+      SIM_AdvanceTo(t0 + SIM_OUT_AT_US + SIM_Random() * scn->jitter_us);
+
+      /* Frames owed at the feedback rate, what does not fit the packet is lost */
+      SIM_Host.acc += SIM_Host.fb;
+      sent = (uint32_t)SIM_Host.acc;
+      SIM_Host.acc -= (double)sent;
+      sent = MIN(sent, SIM_Host.mps_frames);
+
+      if (SIM_Host.drop_left != 0U || SIM_Random() < scn->drop_rate)
+      {
+        SIM_Host.drop_left -= (SIM_Host.drop_left != 0U) ? 1U : 0U;
+        missing = 1U;
+      }
+      else
+      {
+        int16_t pkt[2U * (AUDIO_OUT_PACKET_44K / AUDIO_FRAME_SIZE + 1U)];
+
+        for (uint32_t i = 0U; i < sent; i++)
+        {
+          int16_t smp_val = (int16_t)(SIM_TONE_AMPLITUDE * sin(SIM_Host.phase));
+
+          pkt[2U * i] = smp_val;
+          pkt[2U * i + 1U] = smp_val;
+          SIM_Host.phase = fmod(SIM_Host.phase + 2.0 * M_PI * SIM_TONE_HZ / SIM_Host.rate, 2.0 * M_PI);
+        }
+        (void)SIM_USB_Out(AUDIO_OUT_EP, (const uint8_t *)pkt, sent * AUDIO_FRAME_SIZE);
+      }
+    }
+    else if (SIM_Host.alt != 0U)
+    {
+      missing = 1U;
+    }
+
+    SIM_AdvanceTo(t0 + SIM_IN_AT_US);
+
+    if (SIM_Host.alt != 0U && SIM_USB_In(AUDIO_IN_EP, fb, frame) == (int32_t)AUDIO_IN_PACKET)
+    {
+      /* 10.14 frames per frame */
+      SIM_Host.fb = (double)((uint32_t)fb[0] | ((uint32_t)fb[1] << 8) | ((uint32_t)fb[2] << 16)) / 16384.0;
+    }
+
+    if (missing != 0U)
+    {
+      SIM_USB_IsoOutIncomplete(AUDIO_OUT_EP);
+    }
+
+    /* Sampled where the feedback measures the fill, just before the next SOF */
+    SIM_AdvanceTo(t0 + 1000.0);
+    SIM_Sample(frame, sent, &smp);
+    if (csv != NULL)
+    {
+      SIM_CsvRow(csv, &smp);
+    }
+
+    if (frame == scn->settle_ms)
+    {
+      underruns_settled = smp.underruns;
+    }
+    if (frame >= scn->settle_ms && SIM_DMA_IsRunning() != 0U)
+    {
+      fill_min = MIN(fill_min, smp.fill);
+      fill_max = MAX(fill_max, smp.fill);
+      fill_sum += smp.fill;
+      fill_count++;
+    }
+  }
+
+  if (csv != NULL)
+  {
+    (void)fclose(csv);
+  }
+
+  underruns_settled = smp.underruns - underruns_settled;
+  result = (underruns_settled <= scn->max_underruns) ? 0 : 1;
+
+  if (scn->latency_tol != 0U)
+  {
+    /* The latency the device reports is its pre-roll, the running fill has to match it */
+    if (SIM_USB_Control(SIM_REQ_VENDOR_IN, AUDIO_VENDOR_REQ_GET_LATENCY, 0U, 0U,
+                        AUDIO_VENDOR_LATENCY_SIZE, lat) == (int32_t)AUDIO_VENDOR_LATENCY_SIZE)
+    {
+      preroll = (double)((uint32_t)lat[4] | ((uint32_t)lat[5] << 8));
+    }
+    if (fill_count == 0U || fabs(fill_sum / fill_count - preroll) > (double)scn->latency_tol)
+    {
+      result = 1;
+    }
+  }
+
+  if (verbose != 0U || result != 0)
+  {
+    (void)printf("  %s: drift %+.0fppm, jitter %.0fus, drops %.4f\n", scn->name, scn->drift_ppm,
+                 scn->jitter_us, scn->drop_rate);
+    (void)printf("    underruns after %ums: %u (max %u), total %u, overruns %u, rx busy %u, work dropped %u\n",
+                 (unsigned)scn->settle_ms, (unsigned)underruns_settled, (unsigned)scn->max_underruns,
+                 (unsigned)smp.underruns, (unsigned)smp.overruns, (unsigned)smp.rx_busy,
+                 (unsigned)smp.work_dropped);
+    if (fill_count != 0U)
+    {
+      (void)printf("    fill %u..%u frames, mean %.1f (%.2fms), feedback %.4f frames/ms\n",
+                   (unsigned)fill_min, (unsigned)fill_max, fill_sum / fill_count,
+                   fill_sum / fill_count / (USBD_AUDIO_FREQ / 1000.0), smp.fb);
+    }
+    if (scn->latency_tol != 0U)
+    {
+      (void)printf("    reported latency %.0f frames (%.2fms), tolerance %u\n", preroll,
+                   preroll / (USBD_AUDIO_FREQ / 1000.0), (unsigned)scn->latency_tol);
+    }
+  }
+
+  return result;
+}
+
+/**
+  * @brief  Host side of a SET_INTERFACE to the streaming interface.
+  * @param  alt: alternate setting
+  * @retval None
+  */
+static void SIM_Host_Alt(uint8_t alt)
+{
+  if (SIM_USB_Control(SIM_REQ_STD_ITF_OUT, USB_REQ_SET_INTERFACE, alt, 1U, 0U, NULL) < 0)
+  {
+    return;
+  }
+
+  SIM_Host.alt = alt;
+  SIM_Host.rate = (alt == AUDIO_ALT_44K) ? 44100U : USBD_AUDIO_FREQ;
+  SIM_Host.mps_frames = ((alt == AUDIO_ALT_44K) ? AUDIO_OUT_PACKET_44K : AUDIO_OUT_PACKET) / AUDIO_FRAME_SIZE;
+  SIM_Host.fb = SIM_Host.rate / 1000.0;
+  SIM_Host.acc = 0.0;
+}
+
+/**
+  * @brief  Uniform random number, reproducible from the scenario seed.
+  * @retval [0, 1)
+  */
+static double SIM_Random(void)
+{
+  SIM_Host.rng ^= SIM_Host.rng << 13;
+  SIM_Host.rng ^= SIM_Host.rng >> 17;
+  SIM_Host.rng ^= SIM_Host.rng << 5;
+
+  return (double)SIM_Host.rng / 4294967296.0;
+}
+
+/**
+  * @brief  Applies a timed action of the scenario.
+  * @param  act: action
+  * @retval None
+  */
+static void SIM_Action(const SIM_ActionTypeDef *act)
+{
+  uint8_t data = (uint8_t)act->arg;
+
+  switch (act->id)
+  {
+    case SIM_ACT_ALT:
+      SIM_Host_Alt((uint8_t)act->arg);
+      break;
+
+    case SIM_ACT_LATENCY:
+      (void)SIM_USB_Control(SIM_REQ_VENDOR_OUT, AUDIO_VENDOR_REQ_SET_LATENCY, 0U, 0U, 1U, &data);
+      break;
+
+    case SIM_ACT_DROP:
+      SIM_Host.drop_left = (uint32_t)act->arg;
+      break;
+
+    case SIM_ACT_PAUSE:
+      SIM_Host.pause_until = act->at_ms + (uint32_t)act->arg;
+      break;
+
+    case SIM_ACT_DRIFT:
+      SIM_SetDrift((double)act->arg);
+      break;
+
+    default:
+      break;
+  }
+}
+
+/**
+  * @brief  State at the end of a frame.
+  * @param  frame: frame number
+  * @param  sent: frames the host sent in it
+  * @param  smp: filled in
+  * @retval None
+  */
+static void SIM_Sample(uint32_t frame, uint32_t sent, SIM_SampleTypeDef *smp)
+{
+  USBD_AUDIO_HandleTypeDef *haudio = (USBD_AUDIO_HandleTypeDef *)hUsbDeviceFS.pClassData;
+  AUDIO_TLM_TypeDef tlm;
+
+  AUDIO_TLM_Read(&tlm);
+
+  smp->frame = frame;
+  smp->alt = SIM_Host.alt;
+  smp->sent = sent;
+  smp->fill = 0U;
+
+  if (haudio != NULL && haudio->ring_size != 0U)
+  {
+    smp->fill = ((uint32_t)haudio->wr_ptr + haudio->ring_size - haudio->rd_ptr) % haudio->ring_size
+                / AUDIO_FRAME_SIZE;
+
+    /* Same count as AUDIO_Feedback_Work: what is left of the block being played and the other one */
+    if (haudio->rd_enable != 0U && SIM_DMA_IsRunning() != 0U)
+    {
+      smp->fill += (SIM_DMA_GetNdtr() / 2U + AUDIO_BLOCK_FRAMES - 1U) % AUDIO_BLOCK_FRAMES + 1U
+                   + AUDIO_BLOCK_FRAMES;
+    }
+  }
+
+  smp->latency_ms = smp->fill / (USBD_AUDIO_FREQ / 1000.0);
+  smp->fb = SIM_Host.fb;
+  smp->underruns = tlm.underruns;
+  smp->underrun_frames = tlm.underrun_frames;
+  smp->overruns = tlm.overruns;
+  smp->rx_busy = tlm.rx_busy;
+  smp->iso_out_incomplete = tlm.iso_out_incomplete;
+  smp->work_dropped = tlm.work_dropped;
+}
+
+/**
+  * @brief  Writes one CSV row.
+  * @param  csv: file
+  * @param  smp: sample
+  * @retval None
+  */
+static void SIM_CsvRow(FILE *csv, const SIM_SampleTypeDef *smp)
+{
+  (void)fprintf(csv, "%u,%u,%u,%u,%.3f,%.5f,%u,%u,%u,%u,%u,%u\n",
+                (unsigned)smp->frame, (unsigned)smp->alt, (unsigned)smp->sent, (unsigned)smp->fill,
+                smp->latency_ms, smp->fb, (unsigned)smp->underruns, (unsigned)smp->underrun_frames,
+                (unsigned)smp->overruns, (unsigned)smp->rx_busy, (unsigned)smp->iso_out_incomplete,
+                (unsigned)smp->work_dropped);
+}
+
+/**
+  * @brief  Scenario by name.
+  * @param  name: scenario name
+  * @retval scenario, NULL if there is none
+  */
+static const SIM_ScenarioTypeDef *SIM_Find(const char *name)
+{
+  for (uint32_t i = 0U; i < SIM_ScenarioCount; i++)
+  {
+    if (strcmp(SIM_Scenarios[i].name, name) == 0)
+    {
+      return &SIM_Scenarios[i];
+    }
+  }
+  return NULL;
+}
+
+/**
+  * @brief  Runs a scenario in a child process, the class statics start over.
+  * @param  scn: scenario
+  * @param  verbose: see SIM_Run
+  * @retval 0 if it passed
+  */
+static int SIM_RunChild(const SIM_ScenarioTypeDef *scn, uint32_t verbose)
+{
+  int status;
+  pid_t pid;
+
+  (void)fflush(stdout);
+  pid = fork();
+
+  if (pid == 0)
+  {
+    exit(SIM_Run(scn, NULL, verbose));
+  }
+  if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status))
+  {
+    return 2;
+  }
+  return WEXITSTATUS(status);
+}
+
+int main(int argc, char **argv)
+{
+  SIM_ScenarioTypeDef scn;
+  const SIM_ScenarioTypeDef *base = NULL;
+  const char *csv_path = NULL;
+  uint32_t verbose = 0U;
+  uint32_t failed = 0U;
+  int opt;
+
+  (void)memset(&scn, 0, sizeof(scn));
+
+  while ((opt = getopt(argc, argv, "ls:o:d:j:r:t:v")) != -1)
+  {
+    switch (opt)
+    {
+      case 'l':
+        for (uint32_t i = 0U; i < SIM_ScenarioCount; i++)
+        {
+          (void)printf("%s\n", SIM_Scenarios[i].name);
+        }
+        return 0;
+
+      case 's':
+        base = SIM_Find(optarg);
+        if (base == NULL)
+        {
+          (void)fprintf(stderr, "unknown scenario %s\n", optarg);
+          return 2;
+        }
+        scn = *base;
+        break;
+
+      case 'o':
+        csv_path = optarg;
+        break;
+
+      case 'd':
+        scn.drift_ppm = atof(optarg);
+        break;
+
+      case 'j':
+        scn.jitter_us = atof(optarg);
+        break;
+
+      case 'r':
+        scn.drop_rate = atof(optarg);
+        break;
+
+      case 't':
+        scn.duration_ms = (uint32_t)atoi(optarg);
+        break;
+
+      case 'v':
+        verbose = 1U;
+        break;
+
+      default:
+        (void)fprintf(stderr, "usage: %s [-l] [-s name] [-o file.csv] [-d ppm] [-j us] [-r rate] [-t ms] [-v]\n",
+                      argv[0]);
+        return 2;
+    }
+  }
+
+  /* One scenario, options on top of it */
+  if (base != NULL)
+  {
+    int result = SIM_Run(&scn, csv_path, verbose);
+
+    (void)printf("%s %s\n", (result == 0) ? "PASS" : "FAIL", scn.name);
+    return result;
+  }
+
+  for (uint32_t i = 0U; i < SIM_ScenarioCount; i++)
+  {
+    int result = SIM_RunChild(&SIM_Scenarios[i], verbose);
+
+    (void)printf("%s %s\n", (result == 0) ? "PASS" : "FAIL", SIM_Scenarios[i].name);
+    failed += (result != 0) ? 1U : 0U;
+  }
+
+  (void)printf("%u of %u scenarios failed\n", (unsigned)failed, (unsigned)SIM_ScenarioCount);
+
+  return (failed == 0U) ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+/**
+  ******************************************************************************
+  * @file           : sim_hal.c
+  * @brief          : Simulated time, core registers and I2S DMA.
+  *
+  *                   The I2S DMA plays the buffer it was started on in a
+  *                   loop at the device clock, USBD_AUDIO_FREQ corrected by
+  *                   the drift, and raises the half and full transfer
+  *                   callbacks as it crosses them. NDTR is worked out from
+  *                   the time the transfer was started.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include "main.h"
+#include "usbd_conf.h"
+#include "work_queue.h"
+#include "event_queue.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint32_t running;
+  uint32_t size;            /* half-words per pass, as given to HAL_I2S_Transmit_DMA */
+  double t_start;           /* time of the first half-word */
+  uint32_t events;          /* half/full transfer callbacks raised so far */
+  uint32_t ndtr;            /* kept once stopped */
+} SIM_DMA_TypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+SCB_Type SIM_SCB;
+SysTick_Type SIM_SysTick;
+DWT_Type SIM_DWT;
+CoreDebug_Type SIM_CoreDebug;
+uint32_t SIM_Uid[3] = { 0x00470031U, 0x3133510CU, 0x35393438U };
+
+uint32_t SystemCoreClock = 84000000U;
+I2S_HandleTypeDef hi2s2;
+
+static double SIM_Time;
+/* Device frames per microsecond of host time */
+static double SIM_Rate = USBD_AUDIO_FREQ / 1e6;
+static SIM_DMA_TypeDef SIM_DMA;
+
+/* Private function prototypes -----------------------------------------------*/
+static double SIM_DMA_NextEvent(void);
+static void SIM_SetTime(double t_us);
+
+/**
+  * @brief  Back to power-on: time zero, I2S off, no drift.
+  * @retval None
+  */
+void SIM_Reset(void)
+{
+  SIM_Time = 0.0;
+  SIM_Rate = USBD_AUDIO_FREQ / 1e6;
+  SIM_DMA.running = 0U;
+  SIM_DMA.ndtr = 0U;
+  hi2s2.State = HAL_I2S_STATE_RESET;
+  SIM_SysTick.LOAD = (SystemCoreClock / 1000U) - 1U;
+  SIM_SetTime(0.0);
+}
+
+/**
+  * @brief  Current simulated time.
+  * @retval microseconds since SIM_Reset
+  */
+double SIM_Now(void)
+{
+  return SIM_Time;
+}
+
+/**
+  * @brief  Moves the time forward, raising the DMA interrupts on the way.
+  * @param  t_us: new time, not before the current one
+  * @retval None
+  */
+void SIM_AdvanceTo(double t_us)
+{
+  double t_dma = SIM_DMA_NextEvent();
+
+  while (t_dma <= t_us)
+  {
+    SIM_SetTime(t_dma);
+
+    /* DMA1_Stream4_IRQHandler -> HAL_I2S_IRQHandler -> half/full transfer callback */
+    if ((SIM_DMA.events++ & 1U) == 0U)
+    {
+      HAL_I2S_TxHalfCpltCallback(&hi2s2);
+    }
+    else
+    {
+      HAL_I2S_TxCpltCallback(&hi2s2);
+    }
+    SIM_Pend();
+
+    t_dma = SIM_DMA_NextEvent();
+  }
+
+  SIM_SetTime(t_us);
+}
+
+/**
+  * @brief  Sets the device clock error. A running DMA carries on from where
+  *         it is at the new rate.
+  * @param  ppm: device I2S clock against the host, > 0 is faster
+  * @retval None
+  */
+void SIM_SetDrift(double ppm)
+{
+  double rate = (USBD_AUDIO_FREQ / 1e6) * (1.0 + ppm / 1e6);
+
+  if (SIM_DMA.running != 0U)
+  {
+    /* Same number of half-words played at the current time with the new rate */
+    SIM_DMA.t_start = SIM_Time - (SIM_Time - SIM_DMA.t_start) * SIM_Rate / rate;
+  }
+  SIM_Rate = rate;
+}
+
+/**
+  * @brief  What runs once an interrupt handler returns: PendSV if it was
+  *         pended, then the main loop events.
+  * @retval None
+  */
+void SIM_Pend(void)
+{
+  if ((SIM_SCB.ICSR & SCB_ICSR_PENDSVSET_Msk) != 0U)
+  {
+    SIM_SCB.ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+    WORK_Run();
+  }
+  EVENT_Dispatch();
+}
+
+/**
+  * @brief  NDTR of the I2S TX stream.
+  * @retval half-words left in the current pass
+  */
+uint32_t SIM_DMA_GetNdtr(void)
+{
+  uint32_t played;
+
+  if (SIM_DMA.running == 0U)
+  {
+    return SIM_DMA.ndtr;
+  }
+
+  /* Two half-words per frame */
+  played = (uint32_t)floor((SIM_Time - SIM_DMA.t_start) * SIM_Rate) * 2U;
+
+  return SIM_DMA.size - (played % SIM_DMA.size);
+}
+
+/**
+  * @brief  Whether the I2S DMA is running.
+  * @retval 1 if running
+  */
+uint32_t SIM_DMA_IsRunning(void)
+{
+  return SIM_DMA.running;
+}
+
+/**
+  * @brief  DWT cycle counter at the core clock.
+  * @retval cycles
+  */
+uint32_t SIM_GetCycles(void)
+{
+  return (uint32_t)(uint64_t)(SIM_Time * (SystemCoreClock / 1e6));
+}
+
+/**
+  * @brief  Time of the next half/full transfer interrupt.
+  * @retval microseconds, INFINITY if the DMA is stopped
+  */
+static double SIM_DMA_NextEvent(void)
+{
+  if (SIM_DMA.running == 0U)
+  {
+    return INFINITY;
+  }
+
+  /* Every half of the buffer, size / 4 frames */
+  return SIM_DMA.t_start + (double)((SIM_DMA.events + 1U) * (SIM_DMA.size / 4U)) / SIM_Rate;
+}
+
+/**
+  * @brief  Sets the time and the registers that follow it.
+  * @param  t_us: time
+  * @retval None
+  */
+static void SIM_SetTime(double t_us)
+{
+  double us = fmod(t_us, 1000.0);
+
+  SIM_Time = t_us;
+  /* SysTick counts down from LOAD once per ms */
+  SIM_SysTick.VAL = SIM_SysTick.LOAD - (uint32_t)(us * (SystemCoreClock / 1e6));
+  SIM_DWT.CYCCNT = SIM_GetCycles();
+}
+
+/* HAL ---------------------------------------------------------------------*/
+uint32_t HAL_GetTick(void)
+{
+  return (uint32_t)(SIM_Time / 1000.0);
+}
+
+void HAL_Delay(uint32_t Delay)
+{
+  /* Thread mode only, the simulated time is moved by the scenario */
+  UNUSED(Delay);
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+  UNUSED(IRQn);
+  UNUSED(PreemptPriority);
+  UNUSED(SubPriority);
+}
+
+void MX_I2S2_Init(void)
+{
+  hi2s2.State = HAL_I2S_STATE_READY;
+}
+
+HAL_StatusTypeDef HAL_I2S_Transmit_DMA(I2S_HandleTypeDef *hi2s, uint16_t *pData, uint16_t Size)
+{
+  if (hi2s->State != HAL_I2S_STATE_READY || Size == 0U)
+  {
+    return HAL_BUSY;
+  }
+
+  hi2s->pTxBuffPtr = pData;
+  hi2s->TxXferSize = Size;
+  hi2s->State = HAL_I2S_STATE_BUSY_TX;
+
+  SIM_DMA.running = 1U;
+  SIM_DMA.size = Size;
+  SIM_DMA.t_start = SIM_Time;
+  SIM_DMA.events = 0U;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2S_DMAStop(I2S_HandleTypeDef *hi2s)
+{
+  if (SIM_DMA.running != 0U)
+  {
+    SIM_DMA.ndtr = SIM_DMA_GetNdtr();
+    SIM_DMA.running = 0U;
+  }
+  hi2s->State = HAL_I2S_STATE_READY;
+
+  return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_I2S_DeInit(I2S_HandleTypeDef *hi2s)
+{
+  (void)HAL_I2S_DMAStop(hi2s);
+  hi2s->State = HAL_I2S_STATE_RESET;
+
+  return HAL_OK;
+}
+
+void Error_Handler(void)
+{
+  abort();
+}
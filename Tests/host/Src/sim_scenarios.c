@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file           : sim_scenarios.c
+  * @brief          : Streaming scenarios run by sim_audio.
+  *
+  *                   Each one enumerates, selects a streaming alternate
+  *                   setting at 10ms and plays for the given time. The
+  *                   feedback loop needs about 2s to settle after a start
+  *                   or an alternate setting change, underruns are only
+  *                   counted after settle_ms. The latency_xxx ones select
+  *                   a profile before streaming and check that the fill
+  *                   settles at the latency the device reports for it.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_audio.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_START                       { 10U, SIM_ACT_ALT, AUDIO_ALT_48K }
+#define SIM_START_44K                   { 10U, SIM_ACT_ALT, AUDIO_ALT_44K }
+#define SIM_LATENCY(p)                  { 5U, SIM_ACT_LATENCY, (p) }
+
+/* Exported variables --------------------------------------------------------*/
+const SIM_ScenarioTypeDef SIM_Scenarios[] =
+{
+  /* name             duration drift    jitter drops   seed  actions                                                             settle underruns latency */
+  { "nominal",        5000U,   0.0,     0.0,   0.0,    1U,   { SIM_START },                                                      500U,  0U,  0U },
+  { "device_slow",    8000U,   -500.0,  0.0,   0.0,    1U,   { SIM_START },                                                      500U,  0U,  0U },
+  { "device_fast",    8000U,   500.0,   0.0,   0.0,    1U,   { SIM_START },                                                      500U,  0U,  0U },
+  { "jitter",         5000U,   100.0,   800.0, 0.0,    7U,   { SIM_START },                                                      500U,  0U,  0U },
+  { "drops",          5000U,   0.0,     400.0, 0.002,  11U,  { SIM_START },                                                      500U,  8U,  0U },
+  { "drop_burst",     5000U,   0.0,     0.0,   0.0,    1U,   { SIM_START, { 3000U, SIM_ACT_DROP, 3 } },                          500U,  4U,  0U },
+  { "alt_44k",        8000U,   -200.0,  300.0, 0.0,    3U,   { SIM_START_44K },                                                  500U,  0U,  0U },
+  { "alt_switch",     9000U,   200.0,   300.0, 0.0,    5U,   { SIM_START, { 3000U, SIM_ACT_ALT, AUDIO_ALT_ZERO_BW },
+                                                               { 3100U, SIM_ACT_ALT, AUDIO_ALT_44K },
+                                                               { 6000U, SIM_ACT_ALT, AUDIO_ALT_48K } },                          500U,  0U,  0U },
+  { "drift_step",     8000U,   0.0,     0.0,   0.0,    1U,   { SIM_START, { 4000U, SIM_ACT_DRIFT, 300 } },                       500U,  0U,  0U },
+  { "idle_resume",    5000U,   0.0,     0.0,   0.0,    1U,   { SIM_START, { 2000U, SIM_ACT_PAUSE, 700 } },                       3000U, 0U,  0U },
+  { "latency_2ms",    5000U,   0.0,     300.0, 0.0,    13U,  { SIM_LATENCY(AUDIO_LATENCY_2MS), SIM_START },                      1500U, 0U,  4U },
+  { "latency_4ms",    5000U,   0.0,     300.0, 0.0,    13U,  { SIM_LATENCY(AUDIO_LATENCY_4MS), SIM_START },                      1500U, 0U,  4U },
+  { "latency_8ms",    5000U,   0.0,     300.0, 0.0,    13U,  { SIM_LATENCY(AUDIO_LATENCY_8MS), SIM_START },                      1500U, 0U,  4U },
+  { "latency_2ms_44k", 8000U,  -200.0,  300.0, 0.0,    13U,  { SIM_LATENCY(AUDIO_LATENCY_2MS), SIM_START_44K },                  3000U, 0U,  4U },
+};
+
+const uint32_t SIM_ScenarioCount = sizeof(SIM_Scenarios) / sizeof(SIM_Scenarios[0]);
@@ -0,0 +1,452 @@
+/**
+  ******************************************************************************
+  * @file           : sim_usb.c
+  * @brief          : Simulated USBD_LL_* driver and host.
+  *
+  *                   Stands in for usbd_conf.c and the PCD driver: the
+  *                   endpoints only remember the buffer they were armed with,
+  *                   the FIFOs only the plan made on the bus reset.
+  *                   The host side moves data in and out of those buffers
+  *                   and calls the USBD_LL_* stage callbacks the way the PCD
+  *                   interrupt handler does, EP0 one max packet at a time.
+  *                   An isochronous IN packet armed in frame n goes out in
+  *                   frame n + 1, as the OTG core schedules it.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usb_device.h"
+#include "usbd_core.h"
+#include "usbd_audio.h"
+#include "usbd_audio_if.h"
+#include "usbd_fifo.h"
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  uint8_t open;
+  uint8_t armed;
+  uint8_t stall;
+  uint8_t *buf;
+  uint32_t len;             /* armed length, received length once done */
+  uint32_t frame;           /* isochronous IN: frame the packet goes out in */
+} SIM_EPTypeDef;
+
+/* Private define ------------------------------------------------------------*/
+#define SIM_EP_NUM                      4U
+#define SIM_POOL_SIZE                   4096U
+
+/* Private variables ---------------------------------------------------------*/
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+static SIM_EPTypeDef SIM_EP_In[SIM_EP_NUM];
+static SIM_EPTypeDef SIM_EP_Out[SIM_EP_NUM];
+static uint32_t SIM_Frame;
+
+static uint32_t SIM_Pool[SIM_POOL_SIZE / 4U];
+static uint32_t SIM_PoolUsed;
+static uint32_t SIM_PoolBlocks;
+static uint32_t SIM_PoolPeak;
+
+static const USBD_ClassTypeDef *SIM_FifoClass;
+
+/* Private function prototypes -----------------------------------------------*/
+static SIM_EPTypeDef *SIM_USB_Ep(uint8_t ep_addr);
+static void SIM_USB_BusReset(void);
+
+/**
+  * @brief  Power-up, reset and enumeration: MX_USB_DEVICE_Init registers the
+  *         classes as on the target, then the device is reset, addressed and
+  *         configuration 1 selected.
+  * @retval None
+  */
+void SIM_USB_Attach(void)
+{
+  MX_USB_DEVICE_Init();
+
+  SIM_USB_BusReset();
+
+  (void)SIM_USB_Control(0x00U, USB_REQ_SET_ADDRESS, 1U, 0U, 0U, NULL);
+  (void)SIM_USB_Control(0x00U, USB_REQ_SET_CONFIGURATION, 1U, 0U, 0U, NULL);
+}
+
+/**
+  * @brief  End of a bus reset, as HAL_PCD_ResetCallback in usbd_conf.c: the
+  *         FIFOs are planned for the registered class before EP0 is opened.
+  * @retval None
+  */
+static void SIM_USB_BusReset(void)
+{
+  USBD_FIFO_PlanTypeDef plan;
+
+  (void)USBD_LL_SetSpeed(&hUsbDeviceFS, USBD_SPEED_FULL);
+
+  if (USBD_FIFO_PlanClass(&hUsbDeviceFS, &plan) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  SIM_FifoClass = hUsbDeviceFS.pClass;
+
+  (void)USBD_LL_Reset(&hUsbDeviceFS);
+}
+
+/**
+  * @brief  Class the FIFOs were planned for on the last bus reset.
+  * @retval class, NULL before the first reset
+  */
+const USBD_ClassTypeDef *SIM_USB_GetFifoClass(void)
+{
+  return SIM_FifoClass;
+}
+
+/**
+  * @brief  Control transfer on EP0.
+  * @param  bmRequest, bRequest, wValue, wIndex, wLength: SETUP packet
+  * @param  data: wLength bytes, sent for OUT requests, received for IN ones
+  * @retval bytes of the data stage, -1 if the device stalled the request
+  */
+int32_t SIM_USB_Control(uint8_t bmRequest, uint8_t bRequest, uint16_t wValue, uint16_t wIndex,
+                        uint16_t wLength, uint8_t *data)
+{
+  uint8_t setup[8] = { bmRequest, bRequest, LOBYTE(wValue), HIBYTE(wValue),
+                       LOBYTE(wIndex), HIBYTE(wIndex), LOBYTE(wLength), HIBYTE(wLength) };
+  uint32_t done = 0U;
+
+  SIM_EP_In[0].stall = 0U;
+  SIM_EP_Out[0].stall = 0U;
+  SIM_EP_In[0].armed = 0U;
+  SIM_EP_Out[0].armed = 0U;
+
+  (void)USBD_LL_SetupStage(&hUsbDeviceFS, setup);
+  SIM_Pend();
+
+  if (SIM_EP_In[0].stall != 0U || SIM_EP_Out[0].stall != 0U)
+  {
+    return -1;
+  }
+
+  if ((bmRequest & 0x80U) != 0U)
+  {
+    while (SIM_EP_In[0].armed != 0U && done < wLength)
+    {
+      uint32_t chunk = MIN(SIM_EP_In[0].len, USB_MAX_EP0_SIZE);
+
+      SIM_EP_In[0].armed = 0U;
+      (void)memcpy(&data[done], SIM_EP_In[0].buf, MIN(chunk, (uint32_t)wLength - done));
+      done += chunk;
+      (void)USBD_LL_DataInStage(&hUsbDeviceFS, 0U, SIM_EP_In[0].buf + chunk);
+      SIM_Pend();
+    }
+  }
+  else
+  {
+    while (SIM_EP_Out[0].armed != 0U && done < wLength)
+    {
+      uint32_t chunk = MIN(MIN(SIM_EP_Out[0].len, USB_MAX_EP0_SIZE), (uint32_t)wLength - done);
+
+      SIM_EP_Out[0].armed = 0U;
+      (void)memcpy(SIM_EP_Out[0].buf, &data[done], chunk);
+      SIM_EP_Out[0].len = chunk;
+      done += chunk;
+      (void)USBD_LL_DataOutStage(&hUsbDeviceFS, 0U, SIM_EP_Out[0].buf + chunk);
+      SIM_Pend();
+    }
+  }
+
+  return (int32_t)done;
+}
+
+/**
+  * @brief  OUT packet from the host, dropped if the endpoint is not armed.
+  * @param  ep_addr: endpoint
+  * @param  data: packet
+  * @param  len: bytes
+  * @retval bytes received, -1 if dropped
+  */
+int32_t SIM_USB_Out(uint8_t ep_addr, const uint8_t *data, uint32_t len)
+{
+  SIM_EPTypeDef *ep = SIM_USB_Ep(ep_addr);
+
+  if (ep->open == 0U || ep->armed == 0U)
+  {
+    return -1;
+  }
+
+  /* The OTG core stops at the armed length */
+  len = MIN(len, ep->len);
+  (void)memcpy(ep->buf, data, len);
+  ep->len = len;
+  ep->armed = 0U;
+
+  (void)USBD_LL_DataOutStage(&hUsbDeviceFS, ep_addr & 0x7FU, ep->buf);
+  SIM_Pend();
+
+  return (int32_t)len;
+}
+
+/**
+  * @brief  IN token from the host on an isochronous endpoint. A packet armed
+  *         for an earlier frame was missed and raises the incomplete IN
+  *         interrupt instead.
+  * @param  ep_addr: endpoint
+  * @param  data: receives the packet
+  * @param  frame: current frame number
+  * @retval bytes sent, -1 if nothing was armed for this frame
+  */
+int32_t SIM_USB_In(uint8_t ep_addr, uint8_t *data, uint32_t frame)
+{
+  SIM_EPTypeDef *ep = SIM_USB_Ep(ep_addr);
+  uint32_t len;
+
+  if (ep->open == 0U || ep->armed == 0U)
+  {
+    return -1;
+  }
+
+  if (ep->frame != frame)
+  {
+    if ((int32_t)(frame - ep->frame) > 0)
+    {
+      (void)USBD_LL_IsoINIncomplete(&hUsbDeviceFS, ep_addr & 0x7FU);
+      SIM_Pend();
+    }
+    return -1;
+  }
+
+  len = ep->len;
+  (void)memcpy(data, ep->buf, len);
+  ep->armed = 0U;
+
+  (void)USBD_LL_DataInStage(&hUsbDeviceFS, ep_addr & 0x7FU, ep->buf);
+  SIM_Pend();
+
+  return (int32_t)len;
+}
+
+/**
+  * @brief  Start of frame.
+  * @param  frame: frame number
+  * @retval None
+  */
+void SIM_USB_Sof(uint32_t frame)
+{
+  SIM_Frame = frame;
+
+  (void)USBD_LL_SOF(&hUsbDeviceFS);
+  SIM_Pend();
+}
+
+/**
+  * @brief  Incomplete isochronous OUT transfer interrupt, raised at the end
+  *         of a frame the host sent nothing in.
+  * @param  ep_addr: endpoint
+  * @retval None
+  */
+void SIM_USB_IsoOutIncomplete(uint8_t ep_addr)
+{
+  (void)USBD_LL_IsoOUTIncomplete(&hUsbDeviceFS, ep_addr & 0x7FU);
+  SIM_Pend();
+}
+
+/**
+  * @brief  FNSOF of OTG_FS_DSTS.
+  * @retval frame number of the last SOF, 14 bits
+  */
+uint32_t SIM_USB_GetFrame(void)
+{
+  return SIM_Frame & 0x3FFFU;
+}
+
+/**
+  * @brief  Endpoint state.
+  * @param  ep_addr: endpoint address
+  * @retval endpoint
+  */
+static SIM_EPTypeDef *SIM_USB_Ep(uint8_t ep_addr)
+{
+  return ((ep_addr & 0x80U) != 0U) ? &SIM_EP_In[ep_addr & 0x0FU] : &SIM_EP_Out[ep_addr & 0x0FU];
+}
+
+/* USBD_LL_* ---------------------------------------------------------------*/
+USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
+{
+  (void)memset(SIM_EP_In, 0, sizeof(SIM_EP_In));
+  (void)memset(SIM_EP_Out, 0, sizeof(SIM_EP_Out));
+  pdev->pData = NULL;
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_DeInit(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Start(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Stop(USBD_HandleTypeDef *pdev)
+{
+  UNUSED(pdev);
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_OpenEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t ep_type,
+                                  uint16_t ep_mps)
+{
+  SIM_EPTypeDef *ep = SIM_USB_Ep(ep_addr);
+
+  UNUSED(pdev);
+  UNUSED(ep_type);
+  UNUSED(ep_mps);
+
+  ep->open = 1U;
+  ep->armed = 0U;
+  ep->stall = 0U;
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_CloseEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  SIM_EPTypeDef *ep = SIM_USB_Ep(ep_addr);
+
+  UNUSED(pdev);
+
+  ep->open = 0U;
+  ep->armed = 0U;
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  UNUSED(pdev);
+
+  /* Only an IN endpoint loses what it was armed with, OUT flushes empty the shared RX FIFO */
+  if ((ep_addr & 0x80U) != 0U)
+  {
+    SIM_USB_Ep(ep_addr)->armed = 0U;
+  }
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_StallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  UNUSED(pdev);
+
+  SIM_USB_Ep(ep_addr)->stall = 1U;
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_ClearStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  UNUSED(pdev);
+
+  SIM_USB_Ep(ep_addr)->stall = 0U;
+
+  return USBD_OK;
+}
+
+uint8_t USBD_LL_IsStallEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  UNUSED(pdev);
+
+  return SIM_USB_Ep(ep_addr)->stall;
+}
+
+USBD_StatusTypeDef USBD_LL_SetUSBAddress(USBD_HandleTypeDef *pdev, uint8_t dev_addr)
+{
+  UNUSED(pdev);
+  UNUSED(dev_addr);
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf,
+                                    uint32_t size)
+{
+  /* The core sends the EP0 data stage to address 0x00 */
+  SIM_EPTypeDef *ep = SIM_USB_Ep(ep_addr | 0x80U);
+
+  UNUSED(pdev);
+
+  ep->buf = pbuf;
+  ep->len = size;
+  ep->armed = 1U;
+  ep->frame = SIM_Frame + 1U;
+
+  return USBD_OK;
+}
+
+USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf,
+                                          uint32_t size)
+{
+  SIM_EPTypeDef *ep = SIM_USB_Ep(ep_addr);
+
+  UNUSED(pdev);
+
+  ep->buf = pbuf;
+  ep->len = size;
+  ep->armed = 1U;
+
+  return USBD_OK;
+}
+
+uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr)
+{
+  UNUSED(pdev);
+
+  return SIM_USB_Ep(ep_addr)->len;
+}
+
+void USBD_LL_Delay(uint32_t Delay)
+{
+  UNUSED(Delay);
+}
+
+/* Class pool ---------------------------------------------------------------*/
+void *USBD_static_malloc(uint32_t size)
+{
+  void *p;
+
+  size = (size + USBD_POOL_ALIGN - 1U) & ~(USBD_POOL_ALIGN - 1U);
+
+  if (SIM_PoolUsed + size > sizeof(SIM_Pool))
+  {
+    return NULL;
+  }
+
+  p = (uint8_t *)SIM_Pool + SIM_PoolUsed;
+  SIM_PoolUsed += size;
+  SIM_PoolPeak = MAX(SIM_PoolPeak, SIM_PoolUsed);
+  SIM_PoolBlocks++;
+
+  return p;
+}
+
+void USBD_static_free(void *p)
+{
+  UNUSED(p);
+
+  /* The class frees everything before allocating again */
+  if (SIM_PoolBlocks != 0U && --SIM_PoolBlocks == 0U)
+  {
+    SIM_PoolUsed = 0U;
+  }
+}
+
+void USBD_static_stats(USBD_PoolStatsTypeDef *stats)
+{
+  stats->size = sizeof(SIM_Pool);
+  stats->used = SIM_PoolUsed;
+  stats->peak = SIM_PoolPeak;
+  stats->blocks = SIM_PoolBlocks;
+  stats->sram_static = 0U;
+}
@@ -0,0 +1,134 @@
+/**
+  ******************************************************************************
+  * @file           : test_feedback.c
+  * @brief          : AUDIO_Feedback_Calc over the whole ring at every gain.
+  *
+  *                   The feedback value is compared with the same formula in
+  *                   double precision for every writable size from an empty
+  *                   to a full ring, with the setpoint at both ends and in the
+  *                   middle, at the default gain and at AUDIO_FB_GAIN_MAX, for
+  *                   the 48kHz and the 44.1kHz nominal values. Where the
+  *                   formula goes below zero the value must stay at zero, and
+  *                   it must never fall as the writable size grows.
+  *
+  *                   Usage: test_feedback [-v]
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "usbd_audio.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Frames in the largest ring a latency profile can use */
+#define FB_TEST_RING                    (AUDIO_TOTAL_BUF_SIZE / AUDIO_FRAME_SIZE)
+
+/* Private variables ---------------------------------------------------------*/
+/* Nominal values, 10.14 shifted left by 8 */
+static const uint32_t FB_TEST_Nom[] =
+{
+  48UL << 22,                     /* 48kHz */
+  (uint32_t)(44.1 * (1UL << 22))  /* 44.1kHz */
+};
+
+static const uint32_t FB_TEST_Gain[] =
+{
+  1U, AUDIO_FB_GAIN_DEFAULT, AUDIO_FB_GAIN_MAX
+};
+
+static const uint32_t FB_TEST_Target[] =
+{
+  0U, FB_TEST_RING / 2U, FB_TEST_RING
+};
+
+/* Private function prototypes -----------------------------------------------*/
+static int FB_TEST_Sweep(uint32_t nom, uint32_t gain, uint32_t target, uint32_t verbose);
+
+/**
+  * @brief  Runs every writable size for one nominal value, gain and setpoint.
+  * @param  nom: nominal feedback
+  * @param  gain: feedback gain
+  * @param  target: setpoint
+  * @param  verbose: print the extremes even when they are right
+  * @retval 0 if every value matches
+  */
+static int FB_TEST_Sweep(uint32_t nom, uint32_t gain, uint32_t target, uint32_t verbose)
+{
+  uint32_t last = 0U;
+  uint32_t lo = UINT32_MAX;
+  uint32_t hi = 0U;
+
+  for (uint32_t writable = 0U; writable <= FB_TEST_RING; writable++)
+  {
+    double ref = (double)nom * ((double)(1UL << 22) + ((double)writable - (double)target) * gain)
+                 / (double)(1UL << 22);
+    uint32_t fb = AUDIO_Feedback_Calc(writable, target, nom, gain);
+
+    ref = floor(fmin(fmax(ref, 0.0), (double)UINT32_MAX));
+
+    if (fabs((double)fb - ref) > 1.0 || fb < last)
+    {
+      (void)printf("FAIL feedback nom %u gain %u target %u: writable %u gives %u, expected %.0f%s\n",
+                   (unsigned)nom, (unsigned)gain, (unsigned)target, (unsigned)writable,
+                   (unsigned)fb, ref, (fb < last) ? ", below the previous one" : "");
+      return 1;
+    }
+
+    last = fb;
+    lo = (fb < lo) ? fb : lo;
+    hi = (fb > hi) ? fb : hi;
+  }
+
+  if (verbose != 0U)
+  {
+    (void)printf("  nom %u gain %5u target %3u: %10u .. %10u\n", (unsigned)nom, (unsigned)gain,
+                 (unsigned)target, (unsigned)lo, (unsigned)hi);
+  }
+
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t verbose = 0U;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "v")) != -1)
+  {
+    if (opt == 'v')
+    {
+      verbose = 1U;
+    }
+    else
+    {
+      (void)fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  for (uint32_t n = 0U; n < sizeof(FB_TEST_Nom) / sizeof(FB_TEST_Nom[0]); n++)
+  {
+    for (uint32_t g = 0U; g < sizeof(FB_TEST_Gain) / sizeof(FB_TEST_Gain[0]); g++)
+    {
+      for (uint32_t t = 0U; t < sizeof(FB_TEST_Target) / sizeof(FB_TEST_Target[0]); t++)
+      {
+        failed |= FB_TEST_Sweep(FB_TEST_Nom[n], FB_TEST_Gain[g], FB_TEST_Target[t], verbose);
+      }
+    }
+  }
+
+  /* Largest negative deviation at the largest gain: nothing left of the nominal value */
+  if (AUDIO_Feedback_Calc(0U, FB_TEST_RING, FB_TEST_Nom[0], AUDIO_FB_GAIN_MAX) != 0U)
+  {
+    (void)printf("FAIL feedback: empty writable at the maximum gain wraps\n");
+    failed = 1;
+  }
+
+  (void)printf("%s feedback, %u frame ring, gain up to %u\n", (failed == 0) ? "PASS" : "FAIL",
+               (unsigned)FB_TEST_RING, (unsigned)AUDIO_FB_GAIN_MAX);
+
+  return failed;
+}
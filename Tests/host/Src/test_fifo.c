@@ -0,0 +1,212 @@
+/**
+  ******************************************************************************
+  * @file           : test_fifo.c
+  * @brief          : OTG FS FIFO plans of the device configurations.
+  *
+  *                   Runs USBD_FIFO_Plan on the configuration descriptors the
+  *                   device actually reports, the audio class on its own and
+  *                   the composite device of this build: audio + CDC port by
+  *                   default, audio + HID consumer control when built with
+  *                   USE_USBD_HID_CC, audio only with neither (the Makefile
+  *                   builds all three). It checks
+  *                   that the plan fills the 320 words exactly and gives every
+  *                   endpoint the depth the sizing rules of usbd_fifo.c call
+  *                   for.
+  *
+  *                   The composite plan is the one made on the bus reset after
+  *                   MX_USB_DEVICE_Init, so the check fails if the FIFOs are
+  *                   planned for any other class than the one the host sees.
+  *
+  *                   Usage: test_fifo [-v]
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include <unistd.h>
+#include "usbd_conf.h"
+#include "usbd_fifo.h"
+#include "usbd_audio.h"
+#include "usbd_cdc_acm.h"
+#include "usbd_hid_cc.h"
+#include "usbd_composite.h"
+#include "sim.h"
+
+/* Private define ------------------------------------------------------------*/
+#define FIFO_TEST_WORDS(bytes)          (((bytes) + 3U) / 4U)
+
+/* RX: SETUP packets, two of the largest OUT packet, OUT status, global NAK */
+#define FIFO_TEST_RX(max_out, n_out)    ((5U + 8U) + 2U * (FIFO_TEST_WORDS(max_out) + 1U) + 2U * (n_out) + 1U)
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  const char *name;
+  uint16_t rx_min;
+  uint16_t tx[USBD_FIFO_MAX_EP];
+} FIFO_TEST_ExpectTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+/* Largest OUT packet of every configuration: the 48kHz alternate setting */
+static const FIFO_TEST_ExpectTypeDef FIFO_TEST_Audio =
+{
+  "audio",
+  /* EP0 and the streaming OUT endpoint */
+  FIFO_TEST_RX(AUDIO_OUT_PACKET, 2U),
+  /* EP0, feedback (3 bytes, two packets, raised to the minimum) */
+  { USBD_FIFO_TX_MIN_WORDS, USBD_FIFO_TX_MIN_WORDS, 0U, 0U }
+};
+
+#if (USE_USBD_CDC_DIAG == 1U)
+static const FIFO_TEST_ExpectTypeDef FIFO_TEST_AudioCdc =
+{
+  "audio+cdc",
+  /* EP0, the streaming OUT endpoint and the CDC bulk OUT one */
+  FIFO_TEST_RX(AUDIO_OUT_PACKET, 3U),
+  /* EP0, feedback, CDC bulk IN (two packets), CDC notifications (minimum) */
+  { USBD_FIFO_TX_MIN_WORDS, USBD_FIFO_TX_MIN_WORDS,
+    2U * FIFO_TEST_WORDS(CDC_ACM_DATA_FS_MAX_PACKET_SIZE), USBD_FIFO_TX_MIN_WORDS }
+};
+#endif /* USE_USBD_CDC_DIAG */
+
+#if (USE_USBD_HID_CC == 1U)
+static const FIFO_TEST_ExpectTypeDef FIFO_TEST_AudioHid =
+{
+  "audio+hid",
+  /* EP0 and the streaming OUT endpoint, the HID function has no OUT endpoint */
+  FIFO_TEST_RX(AUDIO_OUT_PACKET, 2U),
+  /* EP0, feedback, HID report (one packet, raised to the minimum) */
+  { USBD_FIFO_TX_MIN_WORDS, USBD_FIFO_TX_MIN_WORDS, USBD_FIFO_TX_MIN_WORDS, 0U }
+};
+#endif /* USE_USBD_HID_CC */
+
+#if (USE_USBD_HID_CC == 0U) && (USE_USBD_CDC_DIAG == 0U)
+/* The composite device with nothing next to the audio function: same endpoints */
+static const FIFO_TEST_ExpectTypeDef FIFO_TEST_AudioOnly =
+{
+  "audio only",
+  FIFO_TEST_RX(AUDIO_OUT_PACKET, 2U),
+  { USBD_FIFO_TX_MIN_WORDS, USBD_FIFO_TX_MIN_WORDS, 0U, 0U }
+};
+#endif /* USE_USBD_HID_CC, USE_USBD_CDC_DIAG */
+
+/* The composite device MX_USB_DEVICE_Init registers in this build */
+#if (USE_USBD_HID_CC == 1U)
+static const FIFO_TEST_ExpectTypeDef *const FIFO_TEST_Device = &FIFO_TEST_AudioHid;
+#elif (USE_USBD_CDC_DIAG == 1U)
+static const FIFO_TEST_ExpectTypeDef *const FIFO_TEST_Device = &FIFO_TEST_AudioCdc;
+#else
+static const FIFO_TEST_ExpectTypeDef *const FIFO_TEST_Device = &FIFO_TEST_AudioOnly;
+#endif /* USE_USBD_HID_CC */
+
+/* Private function prototypes -----------------------------------------------*/
+static int FIFO_TEST_Check(const FIFO_TEST_ExpectTypeDef *exp, USBD_ClassTypeDef *pclass,
+                           uint32_t verbose);
+
+/**
+  * @brief  Plans the FIFOs for a class and compares with the expected split.
+  * @param  exp: expected plan
+  * @param  pclass: class whose FS configuration descriptor is planned
+  * @param  verbose: print the plan even when it is right
+  * @retval 0 if it matches
+  */
+static int FIFO_TEST_Check(const FIFO_TEST_ExpectTypeDef *exp, USBD_ClassTypeDef *pclass,
+                           uint32_t verbose)
+{
+  USBD_FIFO_PlanTypeDef plan = {0};
+  uint16_t len = 0U;
+  uint8_t *cfg = pclass->GetFSConfigDescriptor(&len);
+  uint32_t total;
+  uint32_t tx_sum = 0U;
+  int failed = 0;
+
+  if (USBD_FIFO_Plan(cfg, len, USB_MAX_EP0_SIZE, &plan) != USBD_OK)
+  {
+    (void)printf("FAIL fifo %s: does not fit, %u words needed\n", exp->name, (unsigned)plan.used);
+    return 1;
+  }
+
+  for (uint32_t ep = 0U; ep < USBD_FIFO_MAX_EP; ep++)
+  {
+    tx_sum += plan.tx[ep];
+    if (plan.tx[ep] != exp->tx[ep])
+    {
+      (void)printf("FAIL fifo %s: TX%u %u words, expected %u\n", exp->name, (unsigned)ep,
+                   (unsigned)plan.tx[ep], (unsigned)exp->tx[ep]);
+      failed = 1;
+    }
+    if (plan.tx[ep] != 0U && plan.tx[ep] < USBD_FIFO_TX_MIN_WORDS)
+    {
+      (void)printf("FAIL fifo %s: TX%u below the minimum depth\n", exp->name, (unsigned)ep);
+      failed = 1;
+    }
+  }
+
+  total = plan.rx + tx_sum;
+
+  if (plan.rx_min != exp->rx_min)
+  {
+    (void)printf("FAIL fifo %s: RX needs %u words, expected %u\n", exp->name,
+                 (unsigned)plan.rx_min, (unsigned)exp->rx_min);
+    failed = 1;
+  }
+  if (plan.used != plan.rx_min + tx_sum || plan.used > USBD_FIFO_TOTAL_WORDS)
+  {
+    (void)printf("FAIL fifo %s: %u words used\n", exp->name, (unsigned)plan.used);
+    failed = 1;
+  }
+  /* The spare words all go to RX, nothing is left over and nothing overlaps */
+  if (total != USBD_FIFO_TOTAL_WORDS || plan.rx < plan.rx_min)
+  {
+    (void)printf("FAIL fifo %s: RX %u + TX %u = %u words, the RAM has %u\n", exp->name,
+                 (unsigned)plan.rx, (unsigned)tx_sum, (unsigned)total, USBD_FIFO_TOTAL_WORDS);
+    failed = 1;
+  }
+
+  if (verbose != 0U || failed != 0)
+  {
+    (void)printf("  %s: %u byte descriptor, RX %u (%u needed), TX %u/%u/%u/%u, %u of %u words needed\n",
+                 exp->name, (unsigned)len, (unsigned)plan.rx, (unsigned)plan.rx_min,
+                 (unsigned)plan.tx[0], (unsigned)plan.tx[1], (unsigned)plan.tx[2], (unsigned)plan.tx[3],
+                 (unsigned)plan.used, USBD_FIFO_TOTAL_WORDS);
+  }
+  (void)printf("%s fifo %s\n", (failed == 0) ? "PASS" : "FAIL", exp->name);
+
+  return failed;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t verbose = 0U;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "v")) != -1)
+  {
+    if (opt == 'v')
+    {
+      verbose = 1U;
+    }
+    else
+    {
+      (void)fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  failed |= FIFO_TEST_Check(&FIFO_TEST_Audio, &USBD_AUDIO, verbose);
+
+  /* MX_USB_DEVICE_Init and the first bus reset, the FIFOs are planned on the reset */
+  SIM_Reset();
+  SIM_USB_Attach();
+
+  if (SIM_USB_GetFifoClass() != &USBD_COMPOSITE)
+  {
+    (void)printf("FAIL fifo %s: planned for %s, not the composite class\n", FIFO_TEST_Device->name,
+                 (SIM_USB_GetFifoClass() == &USBD_AUDIO) ? "the audio class" : "another class");
+    return 1;
+  }
+  failed |= FIFO_TEST_Check(FIFO_TEST_Device, &USBD_COMPOSITE, verbose);
+
+  return failed;
+}
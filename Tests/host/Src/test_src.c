@@ -0,0 +1,230 @@
+/**
+  ******************************************************************************
+  * @file           : test_src.c
+  * @brief          : Passband and THD+N of the 44.1kHz to 48kHz SRC.
+  *
+  *                   Each tone is sent at -1dBFS in 44/45 frame packets, as
+  *                   the 44.1kHz alternate setting receives it, and the 48kHz
+  *                   output is analysed over SRC_TEST_N frames once the filter
+  *                   has settled. The tones sit on exact bins of the analysis
+  *                   length, so no window is needed: the tone bin gives the
+  *                   gain, every other bin is distortion and noise. THD+N is
+  *                   given over the audio band (20Hz-20kHz) and over the whole
+  *                   output band, where the image left by the transition band
+  *                   folds back just below 24kHz.
+  *
+  *                   Usage: test_src [-v]
+  *                   Fails if a result is worse than the limits below, which
+  *                   are the figures in the usbd_audio_src.c header.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "usbd_audio_src.h"
+
+/* Private define ------------------------------------------------------------*/
+/* Analysis length, 10Hz bins at 48kHz */
+#define SRC_TEST_N                      4800U
+/* Output frames dropped while the filter fills */
+#define SRC_TEST_SKIP                   512U
+#define SRC_TEST_LEVEL_DB               -1.0
+#define SRC_TEST_IN_RATE                44100.0
+#define SRC_TEST_OUT_RATE               48000.0
+#define SRC_TEST_BAND_HZ                20000.0
+
+/* Limits */
+#define SRC_TEST_RIPPLE_DB              0.05    /* 20Hz-18kHz */
+#define SRC_TEST_DROOP_20K_DB           -1.3    /* gain at 20kHz, lowest */
+#define SRC_TEST_THDN_BAND_DB           -90.0   /* audio band, 20Hz-20kHz */
+#define SRC_TEST_THDN_FULL_19K_DB       -86.0   /* whole band at 19kHz */
+#define SRC_TEST_THDN_FULL_20K_DB       -70.0   /* whole band at 20kHz */
+
+/* Private typedef -----------------------------------------------------------*/
+typedef struct
+{
+  double gain_db;
+  double thdn_band_db;
+  double thdn_full_db;
+} SRC_TEST_ResultTypeDef;
+
+/* Private variables ---------------------------------------------------------*/
+static const double SRC_TEST_Freq[] =
+{
+  20.0, 100.0, 1000.0, 5000.0, 10000.0, 15000.0, 18000.0, 19000.0, 20000.0
+};
+
+static uint32_t SRC_TEST_Out[SRC_TEST_SKIP + SRC_TEST_N + 64U];
+static double SRC_TEST_Pwr[SRC_TEST_N / 2U + 1U];
+
+/* Private function prototypes -----------------------------------------------*/
+static void SRC_TEST_Run(double freq, SRC_TEST_ResultTypeDef *res);
+static void SRC_TEST_Spectrum(const uint32_t *out, uint32_t channel);
+
+/**
+  * @brief  Converts one tone and measures it.
+  * @param  freq: tone, on a 10Hz bin
+  * @param  res: filled in
+  * @retval None
+  */
+static void SRC_TEST_Run(double freq, SRC_TEST_ResultTypeDef *res)
+{
+  static AUDIO_SRC_TypeDef src;
+  const double amp = 32767.0 * pow(10.0, SRC_TEST_LEVEL_DB / 20.0);
+  const uint32_t tone = (uint32_t)lround(freq * SRC_TEST_N / SRC_TEST_OUT_RATE);
+  uint32_t produced = 0U;
+  uint32_t sent = 0U;
+  double owed = 0.0;
+  double tone_pwr;
+  double band_pwr = 0.0;
+  double full_pwr = 0.0;
+
+  AUDIO_SRC_Reset(&src);
+
+  while (produced < SRC_TEST_SKIP + SRC_TEST_N)
+  {
+    uint32_t pkt[45];
+    uint32_t frames;
+
+    /* 44.1 frames per 1ms packet */
+    owed += SRC_TEST_IN_RATE / 1000.0;
+    frames = (uint32_t)owed;
+    owed -= (double)frames;
+
+    for (uint32_t i = 0U; i < frames; i++)
+    {
+      double t = (double)(sent + i) / SRC_TEST_IN_RATE;
+      int16_t l = (int16_t)lrint(amp * sin(2.0 * M_PI * freq * t));
+      int16_t r = (int16_t)lrint(amp * cos(2.0 * M_PI * freq * t));
+
+      pkt[i] = ((uint32_t)(uint16_t)l) | ((uint32_t)(uint16_t)r << 16);
+    }
+    sent += frames;
+
+    produced += AUDIO_SRC_Process(&src, pkt, frames, &SRC_TEST_Out[produced]);
+  }
+
+  /* Left channel, the right one carries the same tone in quadrature */
+  SRC_TEST_Spectrum(&SRC_TEST_Out[SRC_TEST_SKIP], 0U);
+
+  tone_pwr = SRC_TEST_Pwr[tone];
+  for (uint32_t k = 1U; k <= SRC_TEST_N / 2U; k++)
+  {
+    if (k == tone)
+    {
+      continue;
+    }
+    full_pwr += SRC_TEST_Pwr[k];
+    if (k * (SRC_TEST_OUT_RATE / SRC_TEST_N) >= 20.0 &&
+        k * (SRC_TEST_OUT_RATE / SRC_TEST_N) <= SRC_TEST_BAND_HZ)
+    {
+      band_pwr += SRC_TEST_Pwr[k];
+    }
+  }
+
+  /* Single sided power of a sine of amplitude A over N samples: (A N / 2)^2 */
+  res->gain_db = 10.0 * log10(tone_pwr) - 20.0 * log10(amp * SRC_TEST_N / 2.0);
+  res->thdn_band_db = 10.0 * log10(band_pwr / tone_pwr);
+  res->thdn_full_db = 10.0 * log10(full_pwr / tone_pwr);
+}
+
+/**
+  * @brief  Power of every bin of one channel, plain DFT.
+  * @param  out: SRC_TEST_N output frames
+  * @param  channel: 0 left, 1 right
+  * @retval None
+  */
+static void SRC_TEST_Spectrum(const uint32_t *out, uint32_t channel)
+{
+  static double x[SRC_TEST_N];
+  static double c[SRC_TEST_N];
+  static double s[SRC_TEST_N];
+
+  for (uint32_t n = 0U; n < SRC_TEST_N; n++)
+  {
+    x[n] = (double)(int16_t)(out[n] >> (16U * channel));
+    c[n] = cos(2.0 * M_PI * n / SRC_TEST_N);
+    s[n] = sin(2.0 * M_PI * n / SRC_TEST_N);
+  }
+
+  for (uint32_t k = 0U; k <= SRC_TEST_N / 2U; k++)
+  {
+    double re = 0.0;
+    double im = 0.0;
+    uint32_t idx = 0U;
+
+    for (uint32_t n = 0U; n < SRC_TEST_N; n++)
+    {
+      re += x[n] * c[idx];
+      im -= x[n] * s[idx];
+      idx += k;
+      idx = (idx >= SRC_TEST_N) ? (idx - SRC_TEST_N) : idx;
+    }
+    SRC_TEST_Pwr[k] = re * re + im * im;
+  }
+}
+
+int main(int argc, char **argv)
+{
+  SRC_TEST_ResultTypeDef res[sizeof(SRC_TEST_Freq) / sizeof(SRC_TEST_Freq[0])];
+  const uint32_t num = sizeof(SRC_TEST_Freq) / sizeof(SRC_TEST_Freq[0]);
+  double gain_min = INFINITY;
+  double gain_max = -INFINITY;
+  double thdn_band = -INFINITY;
+  uint32_t verbose = 0U;
+  int failed = 0;
+  int opt;
+
+  while ((opt = getopt(argc, argv, "v")) != -1)
+  {
+    if (opt == 'v')
+    {
+      verbose = 1U;
+    }
+    else
+    {
+      (void)fprintf(stderr, "usage: %s [-v]\n", argv[0]);
+      return 2;
+    }
+  }
+
+  for (uint32_t i = 0U; i < num; i++)
+  {
+    SRC_TEST_Run(SRC_TEST_Freq[i], &res[i]);
+
+    if (SRC_TEST_Freq[i] <= 18000.0)
+    {
+      gain_min = fmin(gain_min, res[i].gain_db);
+      gain_max = fmax(gain_max, res[i].gain_db);
+    }
+    thdn_band = fmax(thdn_band, res[i].thdn_band_db);
+
+    if (verbose != 0U)
+    {
+      (void)printf("  %6.0fHz: gain %+7.3fdB, THD+N %6.1fdB (20Hz-20kHz), %6.1fdB (full band)\n",
+                   SRC_TEST_Freq[i], res[i].gain_db, res[i].thdn_band_db, res[i].thdn_full_db);
+    }
+
+    if ((SRC_TEST_Freq[i] == 19000.0 && res[i].thdn_full_db > SRC_TEST_THDN_FULL_19K_DB) ||
+        (SRC_TEST_Freq[i] == 20000.0 && res[i].thdn_full_db > SRC_TEST_THDN_FULL_20K_DB) ||
+        (SRC_TEST_Freq[i] == 20000.0 && res[i].gain_db < SRC_TEST_DROOP_20K_DB))
+    {
+      (void)printf("FAIL src %.0fHz\n", SRC_TEST_Freq[i]);
+      failed = 1;
+    }
+  }
+
+  (void)printf("%s src ripple 20Hz-18kHz %.3fdB (max %.3f), THD+N in band %.1fdB (max %.1f)\n",
+               ((gain_max - gain_min) <= SRC_TEST_RIPPLE_DB && thdn_band <= SRC_TEST_THDN_BAND_DB)
+               ? "PASS" : "FAIL",
+               gain_max - gain_min, SRC_TEST_RIPPLE_DB, thdn_band, SRC_TEST_THDN_BAND_DB);
+
+  if ((gain_max - gain_min) > SRC_TEST_RIPPLE_DB || thdn_band > SRC_TEST_THDN_BAND_DB)
+  {
+    failed = 1;
+  }
+
+  return failed;
+}
@@ -27,6 +27,14 @@
 #include "usbd_audio_if.h"
 
 /* USER CODE BEGIN Includes */
+#include "usbd_composite.h"
+#include "usbd_audio_telemetry.h"
+#if (USE_USBD_HID_CC == 1U)
+#include "usbd_hid_cc.h"
+#endif /* USE_USBD_HID_CC */
+#if (USE_USBD_CDC_DIAG == 1U)
+#include "usbd_cdc_acm_if.h"
+#endif /* USE_USBD_CDC_DIAG */
 
 /* USER CODE END Includes */
 
@@ -64,6 +72,27 @@ USBD_HandleTypeDef hUsbDeviceFS;
 void MX_USB_DEVICE_Init(void)
 {
   /* USER CODE BEGIN USB_DEVICE_Init_PreTreatment */
+  /* Audio first: it is the main class of the composite device */
+  if (USBD_COMPOSITE_AddClass(&USBD_AUDIO) != USBD_OK)
+  {
+    Error_Handler();
+  }
+#if (USE_USBD_HID_CC == 1U)
+  if (USBD_COMPOSITE_AddClass(&USBD_HID_CC) != USBD_OK)
+  {
+    Error_Handler();
+  }
+#endif /* USE_USBD_HID_CC */
+#if (USE_USBD_CDC_DIAG == 1U)
+  if (USBD_COMPOSITE_AddClass(&USBD_CDC_ACM) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  if (USBD_CDC_ACM_RegisterInterface(&USBD_CDC_ACM_fops_FS) != USBD_OK)
+  {
+    Error_Handler();
+  }
+#endif /* USE_USBD_CDC_DIAG */
 
   /* USER CODE END USB_DEVICE_Init_PreTreatment */
 
@@ -86,7 +115,15 @@ void MX_USB_DEVICE_Init(void)
   }
 
   /* USER CODE BEGIN USB_DEVICE_Init_PostTreatment */
-
+  /* The composite class takes over from the generated audio one. The host waits at
+     least 100ms (TATTDB) after the attach before it resets the device and reads a
+     descriptor, so nothing has been seen of the single class */
+  if (USBD_RegisterClass(&hUsbDeviceFS, &USBD_COMPOSITE) != USBD_OK)
+  {
+    Error_Handler();
+  }
+  /* D+ pull-up is on, the host sees the device from here */
+  AUDIO_TLM_Stamp(&AUDIO_Tlm.boot_attach_us);
   /* USER CODE END USB_DEVICE_Init_PostTreatment */
 }
 
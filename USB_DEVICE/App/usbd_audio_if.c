@@ -62,6 +62,8 @@ extern I2S_HandleTypeDef hi2s2;
   */
 
 /* USER CODE BEGIN PRIVATE_DEFINES */
+/* Time the DMA needs to push the silence left in both blocks (1.3ms) out to the DAC */
+#define AUDIO_IF_DRAIN_MS       2U
 
 /* USER CODE END PRIVATE_DEFINES */
 
@@ -156,6 +158,12 @@ static int8_t AUDIO_Init_FS(uint32_t AudioFreq, uint32_t Volume, uint32_t option
   UNUSED(AudioFreq);
   UNUSED(Volume);
   UNUSED(options);
+
+  /* First stream since reset: the I2S and its PLL were kept off the boot path */
+  if (hi2s2.State == HAL_I2S_STATE_RESET)
+  {
+    MX_I2S2_Init();
+  }
   return (USBD_OK);
   /* USER CODE END 0 */
 }
@@ -169,6 +177,22 @@ static int8_t AUDIO_DeInit_FS(uint32_t options)
 {
   /* USER CODE BEGIN 1 */
   UNUSED(options);
+
+  if (hi2s2.State == HAL_I2S_STATE_RESET)
+  {
+    return (USBD_OK);
+  }
+
+  /* The class has already put silence in the DMA buffer: let it reach the DAC before
+     the clocks stop, so the output does not end on a partial sample */
+  HAL_Delay(AUDIO_IF_DRAIN_MS);
+
+  (void)HAL_I2S_DMAStop(&hi2s2);
+  /* SPI2 clock, pins and DMA stream, then the PLLI2S (HAL_I2S_MspDeInit) */
+  if (HAL_I2S_DeInit(&hi2s2) != HAL_OK)
+  {
+    return (USBD_FAIL);
+  }
   return (USBD_OK);
   /* USER CODE END 1 */
 }
@@ -186,7 +210,7 @@ static int8_t AUDIO_AudioCmd_FS(uint8_t* pbuf, uint32_t size, uint8_t cmd)
   switch(cmd)
   {
     case AUDIO_CMD_START:
-    	HAL_I2S_Transmit_DMA(&hi2s2, pbuf, size);
+    	HAL_I2S_Transmit_DMA(&hi2s2, (uint16_t *)pbuf, size);
     break;
 
     case AUDIO_CMD_PLAY:
@@ -247,6 +271,11 @@ static int8_t AUDIO_PeriodicTC_FS(uint8_t *pbuf, uint32_t size, uint8_t cmd)
 static int8_t AUDIO_GetState_FS(void)
 {
   /* USER CODE BEGIN 6 */
+  /* Playback can only start once the I2S has been powered up from thread mode */
+  if ((hi2s2.State != HAL_I2S_STATE_READY) && (hi2s2.State != HAL_I2S_STATE_BUSY_TX))
+  {
+    return (USBD_BUSY);
+  }
   return (USBD_OK);
   /* USER CODE END 6 */
 }
@@ -258,7 +287,7 @@ static int8_t AUDIO_GetState_FS(void)
 void TransferComplete_CallBack_FS(void)
 {
   /* USER CODE BEGIN 7 */
-//  USBD_AUDIO_Sync(&hUsbDeviceFS, AUDIO_OFFSET_FULL);
+  USBD_AUDIO_Sync(&hUsbDeviceFS, AUDIO_OFFSET_FULL);
   /* USER CODE END 7 */
 }
 
@@ -269,12 +298,38 @@ void TransferComplete_CallBack_FS(void)
 void HalfTransfer_CallBack_FS(void)
 {
   /* USER CODE BEGIN 8 */
-//  USBD_AUDIO_Sync(&hUsbDeviceFS, AUDIO_OFFSET_HALF);
+  USBD_AUDIO_Sync(&hUsbDeviceFS, AUDIO_OFFSET_HALF);
   /* USER CODE END 8 */
 }
 
 /* USER CODE BEGIN PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
+/**
+  * @brief  Tx Transfer Half completed callback, the first block can be refilled.
+  * @param  hi2s: I2S handle
+  * @retval None
+  */
+void HAL_I2S_TxHalfCpltCallback(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == &hi2s2)
+  {
+    HalfTransfer_CallBack_FS();
+  }
+}
+
+/**
+  * @brief  Tx Transfer completed callback, the second block can be refilled.
+  * @param  hi2s: I2S handle
+  * @retval None
+  */
+void HAL_I2S_TxCpltCallback(I2S_HandleTypeDef *hi2s)
+{
+  if (hi2s == &hi2s2)
+  {
+    TransferComplete_CallBack_FS();
+  }
+}
+
 /* USER CODE END PRIVATE_FUNCTIONS_IMPLEMENTATION */
 
 /**
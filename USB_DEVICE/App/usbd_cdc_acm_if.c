@@ -0,0 +1,236 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_acm_if.c
+  * @brief          : Diagnostics stream over the CDC-ACM virtual COM port.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdio.h>
+#include "usbd_cdc_acm_if.h"
+#include "usbd_audio_telemetry.h"
+#include "event_queue.h"
+#include "profile.h"
+
+/* Private typedef -----------------------------------------------------------*/
+/* Private define ------------------------------------------------------------*/
+/* Private macro -------------------------------------------------------------*/
+
+/* Private variables ---------------------------------------------------------*/
+extern USBD_HandleTypeDef hUsbDeviceFS;
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief Usb device library.
+  * @{
+  */
+
+/** @addtogroup USBD_CDC_ACM_IF
+  * @{
+  */
+
+/** @defgroup USBD_CDC_ACM_IF_Private_Variables USBD_CDC_ACM_IF_Private_Variables
+  * @brief Private variables.
+  * @{
+  */
+static volatile uint16_t CDC_Diag_LineState = 0U;
+static volatile uint8_t CDC_Diag_Binary = 0U;
+static uint32_t CDC_Diag_Ticks = 0U;
+/* Text reports alternate between the streaming counters (0) and the system figures (1) */
+static uint8_t CDC_Diag_Part = 0U;
+
+/* Built in thread mode only, USBD_CDC_ACM_Transmit takes a copy */
+static char CDC_Diag_Line[CDC_ACM_TX_SIZE];
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_ACM_IF_Private_FunctionPrototypes USBD_CDC_ACM_IF_Private_FunctionPrototypes
+  * @brief Private functions declaration.
+  * @{
+  */
+static void CDC_Init_FS(void);
+static void CDC_DeInit_FS(void);
+static void CDC_LineState_FS(uint16_t state);
+static void CDC_Receive_FS(const uint8_t *buf, uint32_t len);
+static void CDC_Tick_FS(void);
+static void CDC_Diag_Event(void *ctx);
+/**
+  * @}
+  */
+
+USBD_CDC_ACM_ItfTypeDef USBD_CDC_ACM_fops_FS =
+{
+  CDC_Init_FS,
+  CDC_DeInit_FS,
+  CDC_LineState_FS,
+  CDC_Receive_FS,
+  CDC_Tick_FS
+};
+
+/* Private functions ---------------------------------------------------------*/
+/**
+  * @brief  Initializes the diagnostics stream, on SET_CONFIGURATION.
+  * @retval None
+  */
+static void CDC_Init_FS(void)
+{
+  CDC_Diag_LineState = 0U;
+  CDC_Diag_Ticks = 0U;
+  EVENT_Register(EVENT_CDC_DIAG, CDC_Diag_Event, &hUsbDeviceFS);
+}
+
+/**
+  * @brief  Stops the diagnostics stream.
+  * @retval None
+  */
+static void CDC_DeInit_FS(void)
+{
+  CDC_Diag_LineState = 0U;
+}
+
+/**
+  * @brief  SET_CONTROL_LINE_STATE from the host.
+  * @param  state: CDC_ACM_LINE_xxx
+  * @retval None
+  */
+static void CDC_LineState_FS(uint16_t state)
+{
+  CDC_Diag_LineState = state;
+  CDC_Diag_Ticks = 0U;
+}
+
+/**
+  * @brief  Data received from the host, one command character per byte.
+  * @param  buf: data
+  * @param  len: number of bytes
+  * @retval None
+  */
+static void CDC_Receive_FS(const uint8_t *buf, uint32_t len)
+{
+  for (uint32_t i = 0U; i < len; i++)
+  {
+    if (buf[i] == (uint8_t)'b')
+    {
+      CDC_Diag_Binary = 1U;
+    }
+    else if (buf[i] == (uint8_t)'t')
+    {
+      CDC_Diag_Binary = 0U;
+    }
+  }
+}
+
+/**
+  * @brief  Called every SOF, posts a report every CDC_DIAG_PERIOD_MS while the port is open.
+  * @retval None
+  */
+RAM_ISR static void CDC_Tick_FS(void)
+{
+  if ((CDC_Diag_LineState & CDC_ACM_LINE_DTR) == 0U)
+  {
+    return;
+  }
+
+  if (++CDC_Diag_Ticks >= CDC_DIAG_PERIOD_MS)
+  {
+    CDC_Diag_Ticks = 0U;
+    EVENT_Post(EVENT_CDC_DIAG);
+  }
+}
+
+/**
+  * @brief  Formats and sends one report. Runs in thread mode. A report is
+  *         dropped if the previous one is still being sent. Text reports
+  *         alternate between two lines, each cut to CDC_ACM_TX_SIZE.
+  * @param  ctx: USB device handle
+  * @retval None
+  */
+static void CDC_Diag_Event(void *ctx)
+{
+  USBD_HandleTypeDef *pdev = (USBD_HandleTypeDef *)ctx;
+  AUDIO_TLM_TypeDef tlm;
+  int len;
+
+  AUDIO_TLM_Read(&tlm);
+
+  if (CDC_Diag_Binary != 0U)
+  {
+    CDC_Diag_Line[0] = (char)CDC_DIAG_SYNC0;
+    CDC_Diag_Line[1] = (char)CDC_DIAG_SYNC1;
+    CDC_Diag_Line[2] = (char)sizeof(tlm);
+    (void)USBD_memcpy(&CDC_Diag_Line[3], &tlm, sizeof(tlm));
+    (void)USBD_CDC_ACM_Transmit(pdev, (const uint8_t *)CDC_Diag_Line, (uint16_t)(3U + sizeof(tlm)));
+    return;
+  }
+
+  CDC_Diag_Part ^= 1U;
+
+  if (CDC_Diag_Part != 0U)
+  {
+    len = snprintf(CDC_Diag_Line, sizeof(CDC_Diag_Line),
+                   "fill %lu..%lu fb %lu..%lu last %lu under %lu over %lu size %lu iso %lu/%lu drop %lu busy %lu",
+                   (unsigned long)tlm.fill_min, (unsigned long)tlm.fill_max,
+                   (unsigned long)tlm.fb_min, (unsigned long)tlm.fb_max, (unsigned long)tlm.fb_last,
+                   (unsigned long)tlm.underruns, (unsigned long)tlm.overruns, (unsigned long)tlm.oversize,
+                   (unsigned long)tlm.iso_out_incomplete, (unsigned long)tlm.iso_in_incomplete,
+                   (unsigned long)tlm.work_dropped, (unsigned long)tlm.rx_busy);
+  }
+  else
+  {
+    len = snprintf(CDC_Diag_Line, sizeof(CDC_Diag_Line), "boot %lu/%lu",
+                   (unsigned long)tlm.boot_attach_us, (unsigned long)tlm.boot_audio_us);
+
+#if (USE_ISR_PROFILE == 1U)
+    {
+      PROFILE_ReportTypeDef otg;
+      PROFILE_ReportTypeDef dma;
+
+      PROFILE_Read(PROFILE_OTG_FS, &otg);
+      PROFILE_Read(PROFILE_DMA_I2S, &dma);
+
+      if (len > 0 && (uint32_t)len < sizeof(CDC_Diag_Line))
+      {
+        len += snprintf(&CDC_Diag_Line[len], sizeof(CDC_Diag_Line) - (uint32_t)len,
+                        " otg %lu/%lu dma %lu/%lu",
+                        (unsigned long)otg.avg, (unsigned long)otg.max,
+                        (unsigned long)dma.avg, (unsigned long)dma.max);
+      }
+    }
+#endif /* USE_ISR_PROFILE */
+
+    {
+      USBD_PoolStatsTypeDef pool;
+
+      USBD_static_stats(&pool);
+
+      if (len > 0 && (uint32_t)len < sizeof(CDC_Diag_Line))
+      {
+        len += snprintf(&CDC_Diag_Line[len], sizeof(CDC_Diag_Line) - (uint32_t)len,
+                        " ram %lu+%lu/%lu",
+                        (unsigned long)pool.sram_static, (unsigned long)pool.peak,
+                        (unsigned long)pool.size);
+      }
+    }
+  }
+
+  /* snprintf stops at the end of the buffer: keep what fits and room for the line end */
+  if (len > (int)(sizeof(CDC_Diag_Line) - 3U))
+  {
+    len = (int)(sizeof(CDC_Diag_Line) - 3U);
+  }
+
+  if (len > 0)
+  {
+    CDC_Diag_Line[len++] = '\r';
+    CDC_Diag_Line[len++] = '\n';
+    (void)USBD_CDC_ACM_Transmit(pdev, (const uint8_t *)CDC_Diag_Line, (uint16_t)len);
+  }
+}
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
@@ -0,0 +1,68 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_cdc_acm_if.h
+  * @brief          : Header for usbd_cdc_acm_if.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_CDC_ACM_IF_H__
+#define __USBD_CDC_ACM_IF_H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_cdc_acm.h"
+
+/** @addtogroup STM32_USB_OTG_DEVICE_LIBRARY
+  * @brief For Usb device.
+  * @{
+  */
+
+/** @defgroup USBD_CDC_ACM_IF USBD_CDC_ACM_IF
+  * @brief Diagnostics stream over the virtual COM port.
+  *
+  *        While a terminal holds the port open (DTR set) a telemetry report is
+  *        sent every CDC_DIAG_PERIOD_MS. Sending 't' selects one text line per
+  *        report (the default), 'b' selects binary records: CDC_DIAG_SYNC0,
+  *        CDC_DIAG_SYNC1, a length byte, then AUDIO_TLM_TypeDef as is.
+  * @{
+  */
+
+/** @defgroup USBD_CDC_ACM_IF_Exported_Defines USBD_CDC_ACM_IF_Exported_Defines
+  * @brief Defines.
+  * @{
+  */
+#define CDC_DIAG_PERIOD_MS          100U
+
+#define CDC_DIAG_SYNC0              0xA5U
+#define CDC_DIAG_SYNC1              0x5AU
+/**
+  * @}
+  */
+
+/** @defgroup USBD_CDC_ACM_IF_Exported_Variables USBD_CDC_ACM_IF_Exported_Variables
+  * @brief Public variables.
+  * @{
+  */
+/** CDC_ACM_IF Interface callback. */
+extern USBD_CDC_ACM_ItfTypeDef USBD_CDC_ACM_fops_FS;
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_CDC_ACM_IF_H__ */
@@ -164,9 +164,15 @@ __ALIGN_BEGIN uint8_t USBD_FS_DeviceDesc[USB_LEN_DEV_DESC] __ALIGN_END =
   0x00,                       /*bcdUSB */
 #endif /* (USBD_LPM_ENABLED == 1) */
   0x02,
+#if (USE_USBD_CDC_DIAG == 1U)
+  0xEF,                       /*bDeviceClass: miscellaneous, the audio and CDC functions use IADs*/
+  0x02,                       /*bDeviceSubClass: common class*/
+  0x01,                       /*bDeviceProtocol: interface association*/
+#else
   0x00,                       /*bDeviceClass*/
   0x00,                       /*bDeviceSubClass*/
   0x00,                       /*bDeviceProtocol*/
+#endif /* USE_USBD_CDC_DIAG */
   USB_MAX_EP0_SIZE,           /*bMaxPacketSize*/
   LOBYTE(USBD_VID),           /*idVendor*/
   HIBYTE(USBD_VID),           /*idVendor*/
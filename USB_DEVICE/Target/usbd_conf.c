@@ -27,7 +27,7 @@
 #include "usbd_audio.h"
 
 /* USER CODE BEGIN Includes */
-
+#include "usbd_fifo.h"
 /* USER CODE END Includes */
 
 /* Private typedef -----------------------------------------------------------*/
@@ -36,6 +36,15 @@
 
 /* USER CODE BEGIN PV */
 /* Private variables ---------------------------------------------------------*/
+/* Class pool and RAM bounds, from the linker script */
+extern uint8_t _susbd_pool[];
+extern uint8_t _eusbd_pool[];
+extern uint8_t _sdata[];
+extern uint8_t _ebss[];
+
+static uint32_t usbd_pool_used;
+static uint32_t usbd_pool_peak;
+static uint32_t usbd_pool_blocks;
 
 /* USER CODE END PV */
 
@@ -51,7 +60,27 @@ void SystemClock_Config(void);
 
 /* USER CODE BEGIN PFP */
 /* Private function prototypes -----------------------------------------------*/
-USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
+/* The generated functions on the OTG FS interrupt path get RAM_ISR from these declarations,
+   so regenerating the code keeps them in RAM */
+RAM_ISR USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
+#if (USE_HAL_PCD_REGISTER_CALLBACKS == 1U)
+RAM_ISR static void PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+RAM_ISR static void PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+RAM_ISR static void PCD_SOFCallback(PCD_HandleTypeDef *hpcd);
+RAM_ISR static void PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+RAM_ISR static void PCD_ISOINIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+#else
+RAM_ISR void HAL_PCD_DataOutStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+RAM_ISR void HAL_PCD_DataInStageCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+RAM_ISR void HAL_PCD_SOFCallback(PCD_HandleTypeDef *hpcd);
+RAM_ISR void HAL_PCD_ISOOUTIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+RAM_ISR void HAL_PCD_ISOINIncompleteCallback(PCD_HandleTypeDef *hpcd, uint8_t epnum);
+#endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
+RAM_ISR USBD_StatusTypeDef USBD_LL_FlushEP(USBD_HandleTypeDef *pdev, uint8_t ep_addr);
+RAM_ISR USBD_StatusTypeDef USBD_LL_Transmit(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size);
+RAM_ISR USBD_StatusTypeDef USBD_LL_PrepareReceive(USBD_HandleTypeDef *pdev, uint8_t ep_addr, uint8_t *pbuf, uint32_t size);
+RAM_ISR uint32_t USBD_LL_GetRxDataSize(USBD_HandleTypeDef *pdev, uint8_t ep_addr);
+static void USBD_LL_ConfigFifo(USBD_HandleTypeDef *pdev);
 
 /* USER CODE END PFP */
 
@@ -59,6 +88,38 @@ USBD_StatusTypeDef USBD_Get_USB_Status(HAL_StatusTypeDef hal_status);
 
 /* USER CODE BEGIN 1 */
 
+/**
+  * @brief  Sizes the OTG FS FIFOs for the registered class. Called on every
+  *         bus reset, before EP0 is opened: MX_USB_DEVICE_Init registers the
+  *         composite class only after USBD_Start, and the host always resets
+  *         the device before the first SETUP.
+  * @param  pdev: Device handle
+  * @retval None
+  */
+static void USBD_LL_ConfigFifo(USBD_HandleTypeDef *pdev)
+{
+  USBD_FIFO_PlanTypeDef plan;
+
+  if (pdev->id != DEVICE_FS || pdev->pClass == NULL)
+  {
+    return;
+  }
+
+  if (USBD_FIFO_PlanClass(pdev, &plan) != USBD_OK)
+  {
+    /* The configuration does not fit the 1.25 KB FIFO RAM */
+    Error_Handler();
+  }
+
+  HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_FS, plan.rx);
+
+  /* TX FIFOs are laid out one after the other, so they are set in endpoint order */
+  for (uint8_t ep = 0U; ep < USBD_FIFO_MAX_EP; ep++)
+  {
+    HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, ep, plan.tx[ep]);
+  }
+}
+
 /* USER CODE END 1 */
 
 /*******************************************************************************
@@ -91,7 +152,7 @@ void HAL_PCD_MspInit(PCD_HandleTypeDef* pcdHandle)
     __HAL_RCC_USB_OTG_FS_CLK_ENABLE();
 
     /* Peripheral interrupt init */
-    HAL_NVIC_SetPriority(OTG_FS_IRQn, 0, 0);
+    HAL_NVIC_SetPriority(OTG_FS_IRQn, 1, 0);
     HAL_NVIC_EnableIRQ(OTG_FS_IRQn);
   /* USER CODE BEGIN USB_OTG_FS_MspInit 1 */
 
@@ -202,6 +263,9 @@ void HAL_PCD_ResetCallback(PCD_HandleTypeDef *hpcd)
     /* Set Speed. */
   USBD_LL_SetSpeed((USBD_HandleTypeDef*)hpcd->pData, speed);
 
+  /* FIFOs of the class the host is about to enumerate, the TX ones were flushed by the reset */
+  USBD_LL_ConfigFifo((USBD_HandleTypeDef*)hpcd->pData);
+
   /* Reset Device. */
   USBD_LL_Reset((USBD_HandleTypeDef*)hpcd->pData);
 }
@@ -223,6 +287,8 @@ void HAL_PCD_SuspendCallback(PCD_HandleTypeDef *hpcd)
   __HAL_PCD_GATE_PHYCLOCK(hpcd);
   /* Enter in STOP mode. */
   /* USER CODE BEGIN 2 */
+  /* No stream while suspended, the I2S is powered down from thread mode */
+  USBD_AUDIO_Suspend((USBD_HandleTypeDef*)hpcd->pData);
   if (hpcd->Init.low_power_enable)
   {
     /* Set SLEEPDEEP bit and SleepOnExit of Cortex System Control Register. */
@@ -354,9 +420,7 @@ USBD_StatusTypeDef USBD_LL_Init(USBD_HandleTypeDef *pdev)
   HAL_PCD_RegisterIsoOutIncpltCallback(&hpcd_USB_OTG_FS, PCD_ISOOUTIncompleteCallback);
   HAL_PCD_RegisterIsoInIncpltCallback(&hpcd_USB_OTG_FS, PCD_ISOINIncompleteCallback);
 #endif /* USE_HAL_PCD_REGISTER_CALLBACKS */
-  HAL_PCDEx_SetRxFiFo(&hpcd_USB_OTG_FS, 0x120);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 0, 0x10);
-  HAL_PCDEx_SetTxFiFo(&hpcd_USB_OTG_FS, 1, 0x10);
+  /* FIFO sizes are planned from the class descriptors on every bus reset, see USBD_LL_ConfigFifo */
   }
   return USBD_OK;
 }
@@ -610,24 +674,70 @@ USBD_StatusTypeDef USBD_LL_SetTestMode(USBD_HandleTypeDef *pdev, uint8_t testmod
 #endif /* USBD_HS_TESTMODE_ENABLE */
 
 /**
-  * @brief  Static single allocation.
+  * @brief  Static allocation from the class pool. Blocks are rounded up to
+  *         USBD_POOL_ALIGN so each one stays usable by the DMA.
   * @param  size: Size of allocated memory
-  * @retval None
+  * @retval Pointer to the block, NULL when the pool is exhausted
   */
 void *USBD_static_malloc(uint32_t size)
 {
-  static uint32_t mem[(sizeof(USBD_AUDIO_HandleTypeDef)/4)+1];/* On 32-bit boundary */
-  return mem;
+  uint32_t pool_size = (uint32_t)(_eusbd_pool - _susbd_pool);
+  void *p;
+
+  size = (size + USBD_POOL_ALIGN - 1U) & ~(USBD_POOL_ALIGN - 1U);
+
+  if ((size == 0U) || (size > (pool_size - usbd_pool_used)))
+  {
+    return NULL;
+  }
+
+  p = &_susbd_pool[usbd_pool_used];
+  usbd_pool_used += size;
+  usbd_pool_blocks++;
+
+  if (usbd_pool_used > usbd_pool_peak)
+  {
+    usbd_pool_peak = usbd_pool_used;
+  }
+
+  return p;
 }
 
 /**
-  * @brief  Dummy memory free
+  * @brief  Memory free. The pool is a bump allocator: it is rewound once
+  *         every block is back, which the core does when it deinitializes
+  *         the classes on reset or SET_CONFIGURATION.
   * @param  p: Pointer to allocated  memory address
   * @retval None
   */
 void USBD_static_free(void *p)
 {
+  if (((uint8_t *)p < _susbd_pool) || ((uint8_t *)p >= _eusbd_pool) || (usbd_pool_blocks == 0U))
+  {
+    return;
+  }
+
+  usbd_pool_blocks--;
 
+  if (usbd_pool_blocks == 0U)
+  {
+    usbd_pool_used = 0U;
+  }
+}
+
+/**
+  * @brief  Class pool usage, to see how much of the RAM is committed once
+  *         the device is configured.
+  * @param  stats: usage
+  * @retval None
+  */
+void USBD_static_stats(USBD_PoolStatsTypeDef *stats)
+{
+  stats->size = (uint32_t)(_eusbd_pool - _susbd_pool);
+  stats->used = usbd_pool_used;
+  stats->peak = usbd_pool_peak;
+  stats->blocks = usbd_pool_blocks;
+  stats->sram_static = (uint32_t)(_ebss - _sdata);
 }
 
 /**
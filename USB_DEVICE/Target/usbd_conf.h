@@ -35,6 +35,35 @@
 #include "stm32f4xx_hal.h"
 
 /* USER CODE BEGIN INCLUDE */
+/* Functions added next to the audio one, at most one of them. The OTG FS core has
+   4 endpoints per direction, EP0 included. Audio takes EP1 OUT (stream) and EP1 IN
+   (feedback); the CDC port takes 0x82 bulk IN, 0x02 bulk OUT and 0x83 interrupt IN,
+   which leaves no IN endpoint for the HID report (0x82). Both also use interface 2.
+   Tests/host builds and runs the device both ways */
+#ifndef USE_USBD_HID_CC
+#define USE_USBD_HID_CC     0U
+#endif
+#ifndef USE_USBD_CDC_DIAG
+#define USE_USBD_CDC_DIAG     1U
+#endif
+#if (USE_USBD_HID_CC == 1U) && (USE_USBD_CDC_DIAG == 1U)
+#error "USE_USBD_HID_CC and USE_USBD_CDC_DIAG need the same endpoints"
+#endif
+
+/* Alignment of the blocks USBD_static_malloc hands out, word aligned for the DMA */
+#define USBD_POOL_ALIGN     4U
+
+/** Class pool usage, see USBD_static_stats. */
+typedef struct
+{
+  uint32_t size;            /* bytes reserved for the pool by the linker script */
+  uint32_t used;            /* bytes handed out now */
+  uint32_t peak;            /* high-water mark of used */
+  uint32_t blocks;          /* blocks not freed yet */
+  uint32_t sram_static;     /* .data and .bss, pool excluded */
+} USBD_PoolStatsTypeDef;
+
+void USBD_static_stats(USBD_PoolStatsTypeDef *stats);
 
 /* USER CODE END INCLUDE */
 
@@ -63,7 +92,7 @@
   */
 
 /*---------- -----------*/
-#define USBD_MAX_NUM_INTERFACES     1U
+#define USBD_MAX_NUM_INTERFACES     4U
 /*---------- -----------*/
 #define USBD_MAX_NUM_CONFIGURATION     1U
 /*---------- -----------*/
@@ -0,0 +1,164 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_fifo.c
+  * @brief          : OTG FS FIFO RAM planner.
+  *
+  *                   Works out the RX and per endpoint TX FIFO depths from the
+  *                   endpoints of a configuration descriptor, every alternate
+  *                   setting included, following the sizing rules of the
+  *                   reference manual (RM0368, 22.11 "FIFO RAM allocation"):
+  *
+  *                   RX = 5 * control endpoints + 8   (SETUP packets)
+  *                      + 2 * (largest OUT packet / 4 + 1)
+  *                                                    (two packets, so an
+  *                                                     isochronous packet can
+  *                                                     arrive while the last
+  *                                                     one is being read)
+  *                      + 2 * OUT endpoints           (transfer complete status)
+  *                      + 1                           (global OUT NAK)
+  *
+  *                   TX = max(16, packets * MPS / 4), two packets for
+  *                   isochronous and bulk endpoints so the next one can be
+  *                   loaded while the current one is sent.
+  *
+  *                   What is left of the 320 words goes to the RX FIFO.
+  *
+  *                   The plan has to be made for the class the host will see.
+  *                   MX_USB_DEVICE_Init only swaps the generated audio class
+  *                   for the composite one after USBD_Start, so usbd_conf.c
+  *                   plans on every bus reset, as the reference manual does
+  *                   the FIFO RAM set-up (22.17.5 "Initialization on USB
+  *                   reset"), rather than at start.
+  ******************************************************************************
+  */
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_fifo.h"
+
+/* Private define ------------------------------------------------------------*/
+#define USBD_FIFO_WORDS(bytes)        (((uint32_t)(bytes) + 3U) / 4U)
+
+/**
+  * @brief  Plans the FIFO RAM for a configuration.
+  * @param  cfg: configuration descriptor, all interfaces and alternate settings
+  * @param  len: total length of cfg
+  * @param  ep0_mps: EP0 max packet size
+  * @param  plan: result
+  * @retval USBD_OK, USBD_FAIL if an endpoint is out of range or the FIFOs do not fit
+  */
+USBD_StatusTypeDef USBD_FIFO_Plan(const uint8_t *cfg, uint16_t len, uint16_t ep0_mps,
+                                  USBD_FIFO_PlanTypeDef *plan)
+{
+  uint16_t out_mps[USBD_FIFO_MAX_EP] = {0};
+  uint16_t in_mps[USBD_FIFO_MAX_EP] = {0};
+  uint8_t in_double[USBD_FIFO_MAX_EP] = {0};
+  uint32_t max_out;
+  uint32_t n_out;
+  uint32_t rx;
+  uint32_t used;
+  uint16_t idx = 0U;
+
+  out_mps[0] = ep0_mps;
+  in_mps[0] = ep0_mps;
+
+  while ((idx + 1U) < len)
+  {
+    const uint8_t *desc = &cfg[idx];
+
+    if (desc[0] < 2U || (idx + desc[0]) > len)
+    {
+      return USBD_FAIL;
+    }
+
+    if (desc[1] == USB_DESC_TYPE_ENDPOINT && desc[0] >= 7U)
+    {
+      uint8_t ep = desc[2] & 0x0FU;
+      uint8_t type = desc[3] & 0x03U;
+      uint16_t mps = (uint16_t)(desc[4] | ((uint16_t)desc[5] << 8)) & 0x07FFU;
+
+      if (ep >= USBD_FIFO_MAX_EP)
+      {
+        return USBD_FAIL;
+      }
+
+      /* An endpoint may appear in several alternate settings, keep the largest */
+      if ((desc[2] & 0x80U) != 0U)
+      {
+        in_mps[ep] = MAX(in_mps[ep], mps);
+        if (type == USBD_EP_TYPE_ISOC || type == USBD_EP_TYPE_BULK)
+        {
+          in_double[ep] = 1U;
+        }
+      }
+      else
+      {
+        out_mps[ep] = MAX(out_mps[ep], mps);
+      }
+    }
+
+    idx += desc[0];
+  }
+
+  max_out = 0U;
+  n_out = 0U;
+  for (uint32_t ep = 0U; ep < USBD_FIFO_MAX_EP; ep++)
+  {
+    if (out_mps[ep] != 0U)
+    {
+      max_out = MAX(max_out, out_mps[ep]);
+      n_out++;
+    }
+  }
+
+  /* EP0 is the only control endpoint */
+  rx = (5U * 1U + 8U) + 2U * (USBD_FIFO_WORDS(max_out) + 1U) + 2U * n_out + 1U;
+  used = rx;
+
+  for (uint32_t ep = 0U; ep < USBD_FIFO_MAX_EP; ep++)
+  {
+    uint32_t tx = 0U;
+
+    if (in_mps[ep] != 0U)
+    {
+      tx = USBD_FIFO_WORDS(in_mps[ep]) * ((in_double[ep] != 0U) ? 2U : 1U);
+      tx = MAX(tx, USBD_FIFO_TX_MIN_WORDS);
+    }
+
+    plan->tx[ep] = (uint16_t)tx;
+    used += tx;
+  }
+
+  plan->rx_min = (uint16_t)rx;
+  plan->used = (uint16_t)used;
+
+  if (used > USBD_FIFO_TOTAL_WORDS)
+  {
+    return USBD_FAIL;
+  }
+
+  /* More RX room lets the core take further OUT packets while the CPU is busy elsewhere */
+  plan->rx = (uint16_t)(rx + (USBD_FIFO_TOTAL_WORDS - used));
+
+  return USBD_OK;
+}
+
+/**
+  * @brief  Plans the FIFO RAM for the FS configuration of the registered class.
+  * @param  pdev: device instance
+  * @param  plan: result
+  * @retval USBD_OK, USBD_FAIL if no class is registered or see USBD_FIFO_Plan
+  */
+USBD_StatusTypeDef USBD_FIFO_PlanClass(USBD_HandleTypeDef *pdev, USBD_FIFO_PlanTypeDef *plan)
+{
+  uint16_t len = 0U;
+  uint8_t *cfg;
+
+  if (pdev->pClass == NULL || pdev->pClass->GetFSConfigDescriptor == NULL)
+  {
+    return USBD_FAIL;
+  }
+
+  cfg = pdev->pClass->GetFSConfigDescriptor(&len);
+
+  return USBD_FIFO_Plan(cfg, len, USB_MAX_EP0_SIZE, plan);
+}
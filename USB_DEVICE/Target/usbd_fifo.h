@@ -0,0 +1,86 @@
+/**
+  ******************************************************************************
+  * @file           : usbd_fifo.h
+  * @brief          : Header for usbd_fifo.c file.
+  ******************************************************************************
+  */
+
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __USBD_FIFO__H__
+#define __USBD_FIFO__H__
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "usbd_def.h"
+
+/** @addtogroup USBD_OTG_DRIVER
+  * @{
+  */
+
+/** @defgroup USBD_FIFO USBD_FIFO
+  * @brief OTG FS FIFO RAM planner.
+  * @{
+  */
+
+/** @defgroup USBD_FIFO_Exported_Defines USBD_FIFO_Exported_Defines
+  * @brief Defines.
+  * @{
+  */
+
+/* OTG FS data FIFO RAM: 1.25 KB, in 32-bit words */
+#define USBD_FIFO_TOTAL_WORDS         320U
+/* Endpoints of the OTG FS core, EP0 included */
+#define USBD_FIFO_MAX_EP              4U
+/* Minimum depth of a TX FIFO (RM0368, OTG_FS_DIEPTXFx) */
+#define USBD_FIFO_TX_MIN_WORDS        16U
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_FIFO_Exported_Types USBD_FIFO_Exported_Types
+  * @brief Types.
+  * @{
+  */
+
+typedef struct
+{
+  uint16_t rx;                          /* shared RX FIFO depth, words */
+  uint16_t tx[USBD_FIFO_MAX_EP];        /* TX FIFO depth of each IN endpoint, 0 if unused */
+  uint16_t rx_min;                      /* RX depth before the spare RAM was added */
+  uint16_t used;                        /* words needed before the spare RAM was added */
+} USBD_FIFO_PlanTypeDef;
+
+/**
+  * @}
+  */
+
+/** @defgroup USBD_FIFO_Exported_FunctionsPrototype USBD_FIFO_Exported_FunctionsPrototype
+  * @brief Public functions declaration.
+  * @{
+  */
+
+USBD_StatusTypeDef USBD_FIFO_Plan(const uint8_t *cfg, uint16_t len, uint16_t ep0_mps,
+                                  USBD_FIFO_PlanTypeDef *plan);
+USBD_StatusTypeDef USBD_FIFO_PlanClass(USBD_HandleTypeDef *pdev, USBD_FIFO_PlanTypeDef *plan);
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+/**
+  * @}
+  */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_FIFO__H__ */